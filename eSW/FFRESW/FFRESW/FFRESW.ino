@@ -1,6 +1,16 @@
+#define LOG_SOURCE LogSource::SKETCH
+
 #include <frt.h>
 #include <calcModule.h>
+#include <runningMedian.h>
 #include <sensorModule.h>
+#include <sensorSnapshot.h>
+#include <sensorHistory.h>
+#include <sensorTrend.h>
+#include <sensorStatistics.h>
+#include <adcEngine.h>
+#include <scopeCapture.h>
+#include <rippleAnalyzer.h>
 #include <comModule.h>
 #include <reportSystem.h>
 #include <jsonModule.h>
@@ -8,8 +18,57 @@
 #include <serialMenu.h>
 #include <flyback.h>
 #include <logManager.h>
+#include <dataLogger.h>
+#include <eventRecorder.h>
 #include <vacControl.h>
 #include <lockGuard.h>
+#include <util/atomic.h>
+#include <ErriezMemoryUsage.h>
+
+// Optional features, 1 = built in. Override with -DUSE_<FEATURE>=0/1, e.g. arduino-cli compile
+// --build-property "compiler.cpp.extra_flags=-DUSE_SCOPE=1 -DUSE_HISTORY=0".
+// The Mega has 8192 bytes of SRAM, the baseline before the acquisition task used 3799 of them for
+// globals (docs/PlantUML/Memory_Layout_Usage_Arduino.txt), the task stacks and the singletons come
+// on top. What each feature costs:
+//
+//   USE_STATISTICS  get_stats                     SensorStatistics
+//   USE_HISTORY     get_history                   historyStorage + SensorHistory
+//   USE_TREND       get_trend                     trendStorage + SensorTrend
+//   USE_SCOPE       set_scope, get_ripple         scopeStorage + rippleWork + ScopeCapture + RippleAnalyzer
+//   USE_EVENTS      set_event                     eventStorage + EventRecorder
+//   USE_DATALOGGER  set_datalog                   DataLogger (two SD blocks) + dataLoggerTask stack
+//
+// The bytes come from the AVR build, eSW/utils/check_ram_budget.sh prints them per feature, the
+// globals from the arduino-cli size report and the singletons on the heap from the debug info of the
+// ELF, the CI puts the table into the job summary. Together the enabled features must stay within
+// FEATURE_RAM_BUDGET, checked when built for the AVR. The default set fits, trend, scope or events
+// fit in exchange for the history, the data logger in exchange for statistics and history, all
+// without an override. setup() logs the free RAM once all tasks run, it must not drop below
+// RAM_RESERVE_BYTES, the Strings of the endpoints live there. The script builds these sets and fails
+// when one of them does not build or its globals pass 75 % of the SRAM, the CI runs it.
+#ifndef USE_STATISTICS
+#define USE_STATISTICS 1
+#endif
+#ifndef USE_HISTORY
+#define USE_HISTORY 1
+#endif
+#ifndef USE_TREND
+#define USE_TREND 0
+#endif
+#ifndef USE_SCOPE
+#define USE_SCOPE 0
+#endif
+#ifndef USE_EVENTS
+#define USE_EVENTS 0
+#endif
+#ifndef USE_DATALOGGER
+#define USE_DATALOGGER 0
+#endif
+
+#ifndef FEATURE_RAM_BUDGET
+#define FEATURE_RAM_BUDGET 1536     // the largest set, the data logger
+#endif
+#define RAM_RESERVE_BYTES 1024
 
 using namespace calcModule;
 using namespace sensorModule;
@@ -43,31 +102,362 @@ char ethernetBuffer[256];
 #endif
 
 
+// Analog inputs of the background ADC scan, analogRead() must not be used while it runs.
+// The HV divider is sampled at the same phase of every PWM period it uses, no ripple beats
+// into the PID: a conversion every 3 periods at 25 kHz, every 29 at 250 kHz, so its 17
+// conversions take 2.0 - 2.1 ms, the 3 * 5 free running ones 1.6 ms. About 270 scans per second.
+const AdcChannelConfig adcChannels[] = {
+    { A0, 2, AdcTrigger::TIMER1_OVERFLOW },   // HV measurement, 16 x oversampled
+    { A1, 1 },      // PWM frequency poti
+    { A2, 1 },      // PWM duty cycle poti
+    { A4, 1 }       // target pressure poti
+};
+
+#if USE_SCOPE
+// Inputs of set_scope, any of them can be captured while the scan runs and the HV is off.
+// The HV divider is the only input the scan keeps current during a capture, the PID needs it.
+struct ScopeChannel
+{
+    const char* name;
+    uint8_t pin;
+};
+
+const ScopeChannel scopeChannels[] = {
+    { "hv", A0 },
+    { "freq_pot", A1 },
+    { "duty_pot", A2 },
+    { "pressure_pot", A4 }
+};
+const uint8_t SCOPE_CHANNEL_COUNT = sizeof(scopeChannels) / sizeof(scopeChannels[0]);
+const char* const scopeStateNames[] = { "idle", "armed", "triggered", "captured", "timed_out" };
+
+// One byte per sample, 6.6 ms at the default 26 us sample interval, 27 ms at div=128
+#define SCOPE_BUFFER_SIZE 256
+uint8_t scopeStorage[SCOPE_BUFFER_SIZE];
+
+// Work buffer of get_ripple, one int16_t per point of the largest FFT
+#define RIPPLE_MAX_POINTS 128
+int16_t rippleWork[RIPPLE_MAX_POINTS];
+#endif
+
+// Channels of get_history, names and units as in the data logger
+struct HistoryChannel
+{
+    const char* name;
+    const char* unit;
+    SensorChannel channel;
+};
+
+const HistoryChannel historyChannels[] = {
+    { "hv_voltage", "V", SensorChannel::HV_VOLTAGE },
+    { "hv_current", "uA", SensorChannel::HV_CURRENT },
+    { "pressure", "mbar", SensorChannel::VAT_PRESSURE },
+    { "temp_in", "C", SensorChannel::TEMPERATURE_INDOOR },
+    { "temp_out", "C", SensorChannel::TEMPERATURE_OUTDOOR }
+};
+const uint8_t HISTORY_CHANNEL_COUNT = sizeof(historyChannels) / sizeof(historyChannels[0]);
+
+// Ring buffers of the history, SensorHistory takes any block, e.g. external SRAM on the XMEM bus
+// (needs pins 35/36 of the flyback moved, XMEM uses port C for the high address lines)
+#if USE_HISTORY
+#define HISTORY_STORAGE_SIZE 512
+uint8_t historyStorage[HISTORY_STORAGE_SIZE];
+#endif
+
+#if USE_TREND
+// Error bounds of get_trend, only the points needed to reconstruct the channels within them are kept
+const TrendConfig trendConfigs[] = {
+    { SensorChannel::HV_VOLTAGE, 0.0f, 100.0f, false },            // two ADC steps
+    { SensorChannel::VAT_PRESSURE, 0.0f, 0.01f, true },            // 0.01 decades, 2.3 %
+    { SensorChannel::TEMPERATURE_INDOOR, 0.0625f, 0.25f, false },  // deadband one MCP9601 step
+    { SensorChannel::TEMPERATURE_OUTDOOR, 0.0625f, 0.25f, false }
+};
+#define TREND_STORAGE_SIZE 384
+uint8_t trendStorage[TREND_STORAGE_SIZE];
+#endif
+
+#if USE_STATISTICS
+// Channels of get_stats, every sample goes into mean, deviation, min/max and P² quantiles
+const SensorChannel statsChannels[] = { SensorChannel::HV_VOLTAGE, SensorChannel::HV_CURRENT, SensorChannel::VAT_PRESSURE };
+#endif
+
+#if USE_EVENTS
+// Ring of the event recorder, it records the channels of get_history in their order plus the switch states,
+// 16 records are 0.8 s around an event at the default 50 ms
+static_assert(HISTORY_CHANNEL_COUNT == EVENT_CHANNEL_COUNT, "event channels follow historyChannels");
+#define EVENT_STORAGE_SIZE (16 * EVENT_RECORD_SIZE)
+uint8_t eventStorage[EVENT_STORAGE_SIZE];
+const char* const eventStateNames[] = { "idle", "armed", "triggered", "pending" };
+const char* const eventSourceNames[] = { "none", "hv", "switch", "threshold", "manual" };
+#endif
+
+
 frt::Queue<float, 1> temperatureQueue;
 frt::Queue<String, 5> endpointQueue;
 
 frt::Mutex temperatureQueueMutex;
-frt::Mutex ethernetMutex;
 
 
-// helper method to update time, do not run in a TASK!
+// helper method to sync the time with the HAS from setup(), before the tasks share the bus
+bool syncTimeWithHas()
+{
+    unsigned long requestMillis = 0;
+    unsigned long responseMillis = 0;
+    String response = com.getEthernet().getSpecificEndpoint("time/", &requestMillis, &responseMillis);
+    return _timeMod->syncWithHas(response, requestMillis, responseMillis);
+}
+
+// helper method to update time from a task, the bus is only held for each W5100 access of the HAS request,
+// the waits in between sleep without it, so other devices get the bus and the waits are no bus occupancy
 void updateTime()
 {
     static unsigned long lastUpdateTime = 0;
-    const unsigned long updateInterval = 60000; // 60 sec
 
-    if (millis() - lastUpdateTime >= updateInterval)
+    // interval grows up to 32 min once the drift of millis() is learned
+    if (millis() - lastUpdateTime < _timeMod->getSyncInterval())
+    {
+        return;
+    }
+    lastUpdateTime = millis(); // Update timestamp
+
+    EthernetCommunication& eth = com.getEthernet();
+    bool connected;
+    {
+    	SPIBusLock bus(SPIDevice::ETHERNET);
+    	connected = eth.connectHas();
+    }
+    if (!connected) return;
+
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    unsigned long requestMillis = 0;
+    {
+    	SPIBusLock bus(SPIDevice::ETHERNET);
+    	eth.sendHasRequest("time/", &requestMillis);
+    }
+
+    // polled once per tick, the arrival time is late by at most one tick, the HAS sees a longer round trip
+    unsigned long responseMillis = 0;
+    while (true)
+    {
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		if (eth.isHasResponseAvailable())
+    		{
+    			responseMillis = millis();
+    			break;
+    		}
+    		if (millis() - requestMillis > EthernetCommunication::HAS_RESPONSE_TIMEOUT_MS)
+    		{
+    			eth.abortHasRequest();
+    			return;
+    		}
+    	}
+    	vTaskDelay(1);
+    }
+
+    String response;
+    {
+    	SPIBusLock bus(SPIDevice::ETHERNET);
+    	response = eth.readHasResponse();
+    }
+    _timeMod->syncWithHas(response, requestMillis, responseMillis);
+}
+
+#if USE_SCOPE
+// helper method to check if an input can be captured, only the HV divider while the HV is on
+bool isScopeAllowed(uint8_t pin)
+{
+    return AdcEngine::toChannel(pin) == AdcEngine::toChannel(A0) || flyback.getHVState() != HVModule::powerSupply_ON;
+}
+#endif
+
+/// @brief Implementation of the AcquisitionTask class, the only task that samples the sensors \class AcquisitionTask
+/// Every group of channels has its own period, the values go to the SensorSnapshotStore.
+/// Endpoints, report and control read the snapshot, requests cause no extra bus traffic.
+class AcquisitionTask final : public frt::Task<AcquisitionTask, 384>
+{
+public:
+    /// @brief Groups of channels sampled together. \enum Group
+    enum Group : uint8_t
+    {
+        GROUP_HV,               // ADC and potis of the flyback
+        GROUP_TEMPERATURE,      // MCP9601 thermocouples, I2C
+        GROUP_VAT,              // pressure and position of the VAT valve, one TCP request each
+        GROUP_COUNT
+    };
+
+    bool run()
     {
-        lastUpdateTime = millis(); // Update timestamp
+        unsigned long now = millis();
+
+        if (flyback.isInitialized() && isDue(GROUP_HV, now))
+        {
+            sampleFlyback();
+        }
+
+        if (isDue(GROUP_TEMPERATURE, now))
+        {
+            sampleTemperatures();
+        }
+
+        if (vacControl.isInitialized() && isDue(GROUP_VAT, now))
+        {
+            sampleVat();
+        }
+
+#if USE_HISTORY
+        // fixed 10 Hz after the groups, the history sees the newest values
+        SensorHistory* history = SensorHistory::getInstance();
+        if (history->isInitialized() && now - lastHistoryMs >= HISTORY_RAW_PERIOD_MS)
+        {
+            lastHistoryMs = (now - lastHistoryMs >= 2 * HISTORY_RAW_PERIOD_MS) ? now : lastHistoryMs + HISTORY_RAW_PERIOD_MS;
+            history->sample(TimeModuleInternals::getMonotonicMicros());
+        }
+#endif
+
+#if USE_EVENTS
+        // the event recorder as well, the loggerTask writes a frozen record
+        EventRecorder* events = EventRecorder::getInstance();
+        uint16_t eventPeriodMs = events->getPeriodMs();
+        if (eventPeriodMs > 0 && now - lastEventMs >= eventPeriodMs)
+        {
+            lastEventMs = (now - lastEventMs >= 2 * static_cast<unsigned long>(eventPeriodMs)) ? now : lastEventMs + eventPeriodMs;
+            events->add(sampleEvent());
+        }
+#endif
+
+        msleep(ACQUISITION_TICK_MS);
+        return true;
+    }
 
-        String startTime;
+    void setPeriod(Group group, uint16_t periodMs)
+    {
+        if (group < GROUP_COUNT && periodMs >= ACQUISITION_TICK_MS)
         {
-        	//LockGuard lock(ethernetMutex);
-        	startTime = com.getEthernet().getSpecificEndpoint("time/");
+            periods[group] = periodMs;
+        }
+    }
+
+    uint16_t getPeriod(Group group) const
+    {
+        return (group < GROUP_COUNT) ? periods[group] : 0;
+    }
+
+private:
+    static const uint16_t ACQUISITION_TICK_MS = 15; // one FreeRTOS tick
+
+    uint16_t periods[GROUP_COUNT] = { 50, 1000, 2000 };
+    unsigned long lastSampleMs[GROUP_COUNT] = {};
+    unsigned long lastHistoryMs = 0;
+    unsigned long lastEventMs = 0;
+
+    // median filters of the published values, the DataLoggerTask records unfiltered samples
+    RunningMedian<float, 5> hvVoltageMedian;    // 50 ms period, steps delayed by 100 ms
+    RunningMedian<float, 5> hvCurrentMedian;
+    RunningMedian<float, 5> hvPowerMedian;
+    RunningMedian<float, 3> pressureMedian;     // 2 s period, steps delayed by 2 s
+
+    bool isDue(Group group, unsigned long now)
+    {
+        if (now - lastSampleMs[group] < periods[group])
+        {
+            return false;
+        }
+        lastSampleMs[group] = now;
+        return true;
+    }
+
+    void sampleFlyback()
+    {
+        Measurement hv = flyback.sample();
+        flyback.publish(hv);
+
+        // spike rejection, all three follow the same ADC value, so the medians pick the same sample
+        float values[] = {
+            hvVoltageMedian.add(hv.voltage), hvCurrentMedian.add(hv.current), hvPowerMedian.add(hv.power),
+            static_cast<float>(hv.frequency), static_cast<float>(hv.dutyCycle),
+            static_cast<float>(hv.digitalFreqValue), static_cast<float>(hv.digitalDutyValue)
+        };
+        record(SensorChannel::HV_VOLTAGE, values, 7, hv.timestampUs);
+    }
+
+    void sampleTemperatures()
+    {
+        SensorReading indoor = sens.readSensorSample(SensorType::MCP9601_Celsius_Indoor);
+        record(SensorChannel::TEMPERATURE_INDOOR, &indoor.value, 1, indoor.timestampUs);
+        SensorReading outdoor = sens.readSensorSample(SensorType::MCP9601_Celsius_Outdoor);
+        record(SensorChannel::TEMPERATURE_OUTDOOR, &outdoor.value, 1, outdoor.timestampUs);
+    }
+
+    void sampleVat()
+    {
+        sampleVatParameter(Compound2::ACTUAL_PRESSURE, Type::Pressure, SensorChannel::VAT_PRESSURE);
+        sampleVatParameter(Compound2::ACTUAL_POSITION, Type::Position, SensorChannel::VAT_POSITION);
+    }
+
+    void sampleVatParameter(Compound2 param, Type type, SensorChannel channel)
+    {
+        String response;
+        uint64_t capturedUs;
+        {
+            SPIBusLock bus(SPIDevice::ETHERNET);
+            response = com.getEthernet().getParameter(param);
+            capturedUs = TimeModuleInternals::getMonotonicMicros();
+        }
+
+        // no answer keeps the last value, its timestamp shows the age
+        float value = CalcModuleInternals::extractFloatFromResponse(response, type);
+        if (!isnan(value))
+        {
+            if (channel == SensorChannel::VAT_PRESSURE)
+            {
+                value = pressureMedian.add(value);
+            }
+            record(channel, &value, 1, capturedUs);
         }
-        _timeMod->setTimeFromHas(startTime);
     }
-}
+
+#if USE_EVENTS
+    EventSample sampleEvent()
+    {
+        // the values from the snapshot, the states straight from the pins, no bus traffic
+        SensorSnapshotStore* store = SensorSnapshotStore::getInstance();
+        EventSample sample;
+        for (uint8_t i = 0; i < EVENT_CHANNEL_COUNT; i++)
+        {
+            SensorReading reading = store->read(historyChannels[i].channel);
+            sample.values[i] = (reading.timestampUs != 0) ? reading.value : NAN;
+        }
+
+        sample.states = static_cast<uint8_t>(flyback.getMainSwitchState()) << EVENT_STATE_MAIN_SHIFT;
+        if (flyback.getHVState() == HVModule::powerSupply_ON) sample.states |= EVENT_STATE_HV_OUTPUT;
+        if (flyback.getHVSwitchState() == HVSwitchStates::HV_Module_ON) sample.states |= EVENT_STATE_HV_SWITCH;
+        if (vacControl.getPumpState() == PumpState::pump_ON) sample.states |= EVENT_STATE_PUMP;
+        return sample;
+    }
+#endif
+
+    void record(SensorChannel first, const float* values, uint8_t count, uint64_t timestampUs)
+    {
+        SensorSnapshotStore::getInstance()->publish(first, values, count, timestampUs);
+
+#if USE_TREND || USE_STATISTICS
+        // trend and statistics see every sample at its capture time, untracked channels are ignored
+        for (uint8_t i = 0; i < count; i++)
+        {
+            SensorChannel channel = static_cast<SensorChannel>(static_cast<uint8_t>(first) + i);
+#if USE_TREND
+            SensorTrend::getInstance()->add(channel, values[i], timestampUs);
+#endif
+#if USE_STATISTICS
+            SensorStatistics::getInstance()->add(channel, values[i], timestampUs);
+#endif
+        }
+#endif
+    }
+};
+AcquisitionTask acquisitionTask;
 
 /// @brief Class-Task to report system health and status periodically \class ReportTask
 class ReportTask final : public frt::Task<ReportTask, 512>
@@ -85,7 +475,7 @@ public:
             bool healthCheck = report.checkSystemHealth(3000, true, true, true, false, false);
             if (!healthCheck)
             {
-            	SerialMenu::printToSerial(SerialMenu::OutputLevel::CRITICAL, F("System health check failed!"));
+            	LOG_TOKEN(CRITICAL, HEALTH_CHECK_FAILED);
             }
     	}
     	else
@@ -107,6 +497,15 @@ public:
 		if (flyback.isInitialized())
 		{
 			flyback.run();
+
+#if USE_SCOPE
+			// the HV came on during a capture of another input, the PID gets its reading back
+			ScopeCapture* scope = ScopeCapture::getInstance();
+			if (AdcEngine::getInstance()->isCapturing() && !isScopeAllowed(scope->getConfig().pin))
+			{
+				scope->disarm();
+			}
+#endif
 			yield(); // DO NOT UNDER ANY CIRCUMSTANCE CHANGE THIS TO SLEEP WE NEED TO YIELD TO THE NEXT TASK
 		}
 
@@ -127,10 +526,12 @@ public:
 			}
 			else if (mainState == vacControlModule::MainSwitchStates::Main_Switch_MANUAL)
 			{
-				String response = getEthernetParameterWithLock(Compound2::ACTUAL_PRESSURE);
-
-                float rawValue = CalcModuleInternals::extractFloatFromResponse(response, Type::Pressure);
-                vacControl.setExternPressure(rawValue);
+				// sampled by the acquisitionTask
+				SensorReading pressure = SensorSnapshotStore::getInstance()->read(SensorChannel::VAT_PRESSURE);
+				if (pressure.timestampUs != 0)
+				{
+					vacControl.setExternPressure(pressure.value);
+				}
 
 				int scenario = vacControl.getScenario();
 				if (scenario != lastAppliedScenario)
@@ -157,50 +558,44 @@ private:
 
 	void setEthernetParamWithLock(Compound2 param, const String& value)
 	{
-		LockGuard lock(ethernetMutex);
+		SPIBusLock bus(SPIDevice::ETHERNET);
 		com.getEthernet().setParameter(param, value);
 	}
 
-	String getEthernetParameterWithLock(Compound2 param)
-	{
-		LockGuard lock(ethernetMutex);
-		return com.getEthernet().getParameter(param);
-	}
-
 	void applyScenario(int scenario)
 	{
 		switch (scenario)
 		{
 			case Scenarios::Scenario_1:
 			{
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, F("Scenario 1"));
+				LOG_TOKEN(DEBUG, SCENARIO_APPLIED, scenario);
 				setEthernetParamWithLock(Compound2::CONTROL_MODE, "3");  //CLOSE
 				break;
 			}
 			case Scenarios::Scenario_2:
 			{
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, F("Scenario 2"));
+				LOG_TOKEN(DEBUG, SCENARIO_APPLIED, scenario);
 				setEthernetParamWithLock(Compound2::CONTROL_MODE, "5"); // Pressure Control
 				setEthernetParamWithLock(Compound2::TARGET_PRESSURE, "0.1");
 				break;
 			}
 			case Scenarios::Scenario_3:
 			{
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, F("Scenario 3"));
+				LOG_TOKEN(DEBUG, SCENARIO_APPLIED, scenario);
 				setEthernetParamWithLock(Compound2::CONTROL_MODE, "5"); // Pressure Control
 				setEthernetParamWithLock(Compound2::TARGET_PRESSURE, "0.05");
 				break;
 			}
 			case Scenarios::Scenario_4:
 			{
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, F("Scenario 4"));
+				LOG_TOKEN(DEBUG, SCENARIO_APPLIED, scenario);
 				setEthernetParamWithLock(Compound2::CONTROL_MODE, "5"); // Pressure Control
 				setEthernetParamWithLock(Compound2::TARGET_PRESSURE, "0.03");
 				break;
 			}
 			case Scenarios::Scenario_5:
 			{
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, F("Scenario 5"));
+				LOG_TOKEN(DEBUG, SCENARIO_APPLIED, scenario);
 				setEthernetParamWithLock(Compound2::CONTROL_MODE, "4");
 				break;
 			}
@@ -229,7 +624,7 @@ public:
 	    // Read the requested endpoint
 	    String requestedEndpoint;
 	    {
-	    	LockGuard lock(ethernetMutex);
+	    	SPIBusLock bus(SPIDevice::ETHERNET);
 	    	requestedEndpoint = com.getEthernet().getRequestedEndpoint();
 	    }
 
@@ -240,6 +635,55 @@ public:
 	    }
 
 	    lastRequestTime = now;
+
+	    // Log-Endpoint, streams its own chunked response
+	    if (requestedEndpoint.startsWith("get_logs"))
+	    {
+	    	handleLogsGet(requestedEndpoint);
+	    	yield();
+	    	return true;
+	    }
+
+#if USE_HISTORY
+	    // History-Endpoint, streams its own chunked response
+	    if (requestedEndpoint.startsWith("get_history"))
+	    {
+	    	handleHistoryGet(requestedEndpoint);
+	    	yield();
+	    	return true;
+	    }
+#endif
+
+#if USE_TREND
+	    // Trend-Endpoint, streams its own chunked response
+	    if (requestedEndpoint.startsWith("get_trend"))
+	    {
+	    	handleTrendGet(requestedEndpoint);
+	    	yield();
+	    	return true;
+	    }
+#endif
+
+#if USE_SCOPE
+	    // Scope-Data-Endpoint, streams its own chunked response
+	    if (requestedEndpoint.startsWith("get_scope_data"))
+	    {
+	    	handleScopeDataGet();
+	    	yield();
+	    	return true;
+	    }
+#endif
+
+#if USE_EVENTS
+	    // Event-Data-Endpoint, streams its own chunked response
+	    if (requestedEndpoint.startsWith("get_event_data"))
+	    {
+	    	handleEventDataGet(requestedEndpoint);
+	    	yield();
+	    	return true;
+	    }
+#endif
+
 	    String jsonBody;
 	    bool processed = false;
 
@@ -276,6 +720,69 @@ public:
             processed = true;
         }
 
+#if USE_DATALOGGER
+        // DataLogger-Endpoints
+        if (requestedEndpoint.startsWith("set_datalog/"))
+        {
+        	jsonBody = handleDataLogSet(requestedEndpoint);
+        	processed = true;
+        }
+        else if (requestedEndpoint.startsWith("get_datalog_"))
+        {
+        	jsonBody = handleDataLogGet(requestedEndpoint);
+        	processed = true;
+        }
+#endif
+
+#if USE_STATISTICS
+        // Statistics-Endpoints
+        if (requestedEndpoint.startsWith("get_stats?"))
+        {
+        	jsonBody = handleStatsGet(requestedEndpoint);
+        	processed = true;
+        }
+#endif
+
+#if USE_SCOPE
+        // Scope-Endpoints
+        if (requestedEndpoint.startsWith("set_scope?"))
+        {
+        	jsonBody = handleScopeSet(requestedEndpoint);
+        	processed = true;
+        }
+        else if (requestedEndpoint.startsWith("get_scope_state"))
+        {
+        	jsonBody = handleScopeStateGet();
+        	processed = true;
+        }
+        else if (requestedEndpoint.startsWith("get_ripple"))
+        {
+        	jsonBody = handleRippleGet(requestedEndpoint);
+        	processed = true;
+        }
+#endif
+
+#if USE_EVENTS
+        // Event-Recorder-Endpoints
+        if (requestedEndpoint.startsWith("set_event?"))
+        {
+        	jsonBody = handleEventSet(requestedEndpoint);
+        	processed = true;
+        }
+        else if (requestedEndpoint.startsWith("get_event_state"))
+        {
+        	jsonBody = handleEventStateGet();
+        	processed = true;
+        }
+#endif
+
+        // SPI-Bus-Endpoints
+        if (requestedEndpoint.startsWith("get_spibus_"))
+        {
+        	jsonBody = handleSPIBusGet(requestedEndpoint);
+        	processed = true;
+        }
+
         // Vacuumpump-Endpoints
         if (requestedEndpoint.startsWith("set_pump/"))
         {
@@ -311,11 +818,17 @@ public:
 	    if (processed && jsonBody.length() > 0)
 	    {
 	    	{
-	    		LockGuard lock(ethernetMutex);
+	    		SPIBusLock bus(SPIDevice::ETHERNET);
 	    		com.getEthernet().sendJsonResponse(jsonBody);
 	    	}
 	        reportTask.post();
 	    }
+	    else
+	    {
+	    	// unknown endpoint or a handler without answer, the client must not wait for a body
+	    	SPIBusLock bus(SPIDevice::ETHERNET);
+	    	com.getEthernet().sendErrorResponse(processed ? F("400 Bad Request") : F("404 Not Found"));
+	    }
 
 	    yield();
 	    return true;
@@ -325,10 +838,342 @@ private:
 
 	uint32_t lastRequestTime = 0;
 	const uint32_t MIN_REQUEST_INTERVAL = 100;
+	uint8_t logChunk[128]; // not on the task stack
+
+    String getQueryParameter(const String& requestedEndpoint, const String& name)
+    {
+    	int start = requestedEndpoint.indexOf('?');
+    	while (start != -1)
+    	{
+    		start++;
+    		int end = requestedEndpoint.indexOf('&', start);
+    		String pair = requestedEndpoint.substring(start, end == -1 ? requestedEndpoint.length() : end);
+    		if (pair.startsWith(name + "="))
+    		{
+    			return pair.substring(name.length() + 1);
+    		}
+    		start = end;
+    	}
+    	return "";
+    }
+
+    void handleLogsGet(const String& requestedEndpoint)
+    {
+    	// get_logs?from=<epoch ms>&to=<epoch ms>, both optional
+    	String from = getQueryParameter(requestedEndpoint, "from");
+    	String to = getQueryParameter(requestedEndpoint, "to");
+    	uint64_t fromMs = TimeModuleInternals::stringToUint64(from);
+    	uint64_t toMs = (to.length() > 0) ? TimeModuleInternals::stringToUint64(to) : TimeModuleInternals::getInstance()->getEpochMillis();
+
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().beginChunkedResponse(F("application/octet-stream"));
+    	}
+
+    	// SD and Ethernet take turns on the SPI bus, one chunk at a time
+    	LogManager* logger = LogManager::getInstance();
+    	LogRange range = {};
+    	bool connected = true;
+    	while (connected && logger->findNextLogRange(fromMs, toMs, range))
+    	{
+    		int count;
+    		while (connected && (count = logger->readLogRange(range, logChunk, sizeof(logChunk))) > 0)
+    		{
+    			SPIBusLock bus(SPIDevice::ETHERNET);
+    			connected = com.getEthernet().sendChunk(logChunk, count);
+    		}
+    	}
+
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().endChunkedResponse();
+    	}
+    }
+
+#if USE_HISTORY
+    void handleHistoryGet(const String& requestedEndpoint)
+    {
+    	// get_history?ch=<name>&res=<raw|1s|10s>&since=<epoch ms>, res and since optional
+    	String name = getQueryParameter(requestedEndpoint, "ch");
+    	String res = getQueryParameter(requestedEndpoint, "res");
+    	uint64_t sinceMs = TimeModuleInternals::stringToUint64(getQueryParameter(requestedEndpoint, "since"));
+
+    	const HistoryChannel* entry = findHistoryChannel(name);
+
+    	HistoryResolution resolution = HistoryResolution::SECOND;
+    	if (res == "raw") resolution = HistoryResolution::RAW;
+    	else if (res == "10s") resolution = HistoryResolution::TEN_SECONDS;
+    	else if (res.length() > 0 && res != "1s") entry = nullptr;
+
+    	SensorHistory* history = SensorHistory::getInstance();
+    	if (entry == nullptr || !history->isTracked(entry->channel))
+    	{
+    		sendStreamError(F("unknown channel or resolution"));
+    		return;
+    	}
+
+    	// the time sync takes the bus, done before the response owns the socket
+    	updateTime();
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().beginChunkedResponse(F("application/json"));
+    	}
+
+    	// points: [epoch ms, min, max, mean], a gap is null
+    	String chunk = String("{\"channel\":\"") + entry->name + "\",\"unit\":\"" + entry->unit
+    		+ "\",\"resolution\":\"" + (res.length() > 0 ? res : String("1s"))
+    		+ "\",\"period_ms\":" + SensorHistory::getPeriodMs(resolution) + ",\"points\":[";
+
+    	uint32_t oldest;
+    	uint32_t next;
+    	history->getRange(resolution, oldest, next);
+    	bool connected = true;
+    	bool first = true;
+    	HistoryPoint point;
+    	for (uint32_t sequence = oldest; connected && sequence < next; sequence++)
+    	{
+    		// overwritten meanwhile, a slow client only loses the oldest points
+    		if (!history->getPoint(entry->channel, resolution, sequence, point))
+    		{
+    			continue;
+    		}
+
+    		uint64_t epochMs = _timeMod->monotonicToEpochMillis(point.timestampUs);
+    		if (epochMs < sinceMs)
+    		{
+    			continue;
+    		}
+
+    		chunk += first ? "[" : ",[";
+    		chunk += TimeModuleInternals::uint64ToString(epochMs);
+    		appendHistoryValue(chunk, point.min);
+    		appendHistoryValue(chunk, point.max);
+    		appendHistoryValue(chunk, point.mean);
+    		chunk += "]";
+    		first = false;
+
+    		if (chunk.length() >= sizeof(logChunk) - 64)
+    		{
+    			connected = sendHistoryChunk(chunk);
+    		}
+    	}
+
+    	chunk += "]}";
+    	if (connected)
+    	{
+    		sendHistoryChunk(chunk);
+    	}
+
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().endChunkedResponse();
+    	}
+    }
+#endif
 
-    String buildJsonResponse(const String& sensorName, float value, const String& unit)
+#if USE_TREND
+    void handleTrendGet(const String& requestedEndpoint)
     {
-        String timestamp = getCurrentTimestamp();
+    	// get_trend?ch=<name>&since=<epoch ms>, since optional
+    	const HistoryChannel* entry = findHistoryChannel(getQueryParameter(requestedEndpoint, "ch"));
+    	uint64_t sinceMs = TimeModuleInternals::stringToUint64(getQueryParameter(requestedEndpoint, "since"));
+
+    	SensorTrend* trend = SensorTrend::getInstance();
+    	if (entry == nullptr || !trend->isTracked(entry->channel))
+    	{
+    		sendStreamError(F("unknown channel"));
+    		return;
+    	}
+
+    	// the time sync takes the bus, done before the response owns the socket
+    	updateTime();
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().beginChunkedResponse(F("application/json"));
+    	}
+
+    	// points: [epoch ms, value], linear in between, a null value starts a gap
+    	TrendStats stats = trend->getStats(entry->channel);
+    	String chunk = String("{\"channel\":\"") + entry->name + "\",\"unit\":\"" + entry->unit
+    		+ "\",\"samples\":" + stats.samples + ",\"stored\":" + stats.points + ",\"depth\":" + stats.depth
+    		+ ",\"span_s\":" + (stats.spanMs / 1000) + ",\"points\":[";
+
+    	uint32_t oldest;
+    	uint32_t next;
+    	trend->getRange(entry->channel, oldest, next);
+    	bool connected = true;
+    	bool first = true;
+    	SensorReading point;
+    	for (uint32_t sequence = oldest; connected && sequence <= next; sequence++)
+    	{
+    		// the open end after the stored points, overwritten points are skipped
+    		bool found = (sequence < next) ? trend->getPoint(entry->channel, sequence, point) : trend->getTail(entry->channel, point);
+    		if (!found)
+    		{
+    			continue;
+    		}
+
+    		uint64_t epochMs = _timeMod->monotonicToEpochMillis(point.timestampUs);
+    		if (epochMs < sinceMs)
+    		{
+    			continue;
+    		}
+
+    		chunk += first ? "[" : ",[";
+    		chunk += TimeModuleInternals::uint64ToString(epochMs);
+    		appendHistoryValue(chunk, point.value);
+    		chunk += "]";
+    		first = false;
+
+    		if (chunk.length() >= sizeof(logChunk) - 64)
+    		{
+    			connected = sendHistoryChunk(chunk);
+    		}
+    	}
+
+    	chunk += "]}";
+    	if (connected)
+    	{
+    		sendHistoryChunk(chunk);
+    	}
+
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().endChunkedResponse();
+    	}
+    }
+#endif
+
+#if USE_SCOPE
+    void handleScopeDataGet()
+    {
+    	// get_scope_data, the frozen capture: SCOPE_HEADER_SIZE bytes header, then one byte per sample
+    	ScopeCapture* scope = ScopeCapture::getInstance();
+    	if (scope->getState() != ScopeState::CAPTURED)
+    	{
+    		sendStreamError(F("no capture"));
+    		return;
+    	}
+
+    	updateTime();
+    	scope->writeHeader(logChunk, _timeMod->monotonicToEpochMillis(scope->getTriggerUs()));
+
+    	bool connected;
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().beginChunkedResponse(F("application/octet-stream"));
+    		connected = com.getEthernet().sendChunk(logChunk, SCOPE_HEADER_SIZE);
+    	}
+
+    	// only this task arms the scope, the capture stays frozen meanwhile
+    	uint16_t offset = 0;
+    	uint16_t count;
+    	while (connected && (count = scope->readSamples(offset, logChunk, sizeof(logChunk))) > 0)
+    	{
+    		offset += count;
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		connected = com.getEthernet().sendChunk(logChunk, count);
+    	}
+
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().endChunkedResponse();
+    	}
+    }
+#endif
+
+#if USE_EVENTS
+    void handleEventDataGet(const String& requestedEndpoint)
+    {
+    	// get_event_data?id=<n>, the file of an event: EVENT_HEADER_SIZE bytes header, then the records, id optional
+    	EventRecorder* events = EventRecorder::getInstance();
+    	String id = getQueryParameter(requestedEndpoint, "id");
+    	uint32_t index = (id.length() > 0) ? id.toInt() : events->getLastIndex();
+
+    	// SD and Ethernet take turns on the SPI bus, one chunk at a time
+    	uint32_t offset = 0;
+    	int count = events->readFile(index, offset, logChunk, sizeof(logChunk));
+    	if (count <= 0)
+    	{
+    		sendStreamError(F("no event"));
+    		return;
+    	}
+
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().beginChunkedResponse(F("application/octet-stream"));
+    	}
+
+    	bool connected = true;
+    	while (connected && count > 0)
+    	{
+    		{
+    			SPIBusLock bus(SPIDevice::ETHERNET);
+    			connected = com.getEthernet().sendChunk(logChunk, count);
+    		}
+    		offset += count;
+    		count = events->readFile(index, offset, logChunk, sizeof(logChunk));
+    	}
+
+    	{
+    		SPIBusLock bus(SPIDevice::ETHERNET);
+    		com.getEthernet().endChunkedResponse();
+    	}
+    }
+#endif
+
+    const HistoryChannel* findHistoryChannel(const String& name)
+    {
+    	for (uint8_t i = 0; i < HISTORY_CHANNEL_COUNT; i++)
+    	{
+    		if (name == historyChannels[i].name)
+    		{
+    			return &historyChannels[i];
+    		}
+    	}
+    	return nullptr;
+    }
+
+    void sendStreamError(const __FlashStringHelper* message)
+    {
+    	json.clearJson();
+    	json.createJson("error", message);
+    	SPIBusLock bus(SPIDevice::ETHERNET);
+    	com.getEthernet().sendJsonResponse(json.getJsonString());
+    }
+
+    void appendHistoryValue(String& chunk, float value)
+    {
+    	if (isnan(value))
+    	{
+    		chunk += ",null";
+    		return;
+    	}
+
+    	// exponent notation keeps the resolution of the pressure in mbar
+    	char text[16];
+    	dtostre(value, text, 4, 0);
+    	chunk += ',';
+    	chunk += text;
+    }
+
+    bool sendHistoryChunk(String& chunk)
+    {
+    	SPIBusLock bus(SPIDevice::ETHERNET);
+    	bool connected = com.getEthernet().sendChunk(reinterpret_cast<const uint8_t*>(chunk.c_str()), chunk.length());
+    	chunk = "";
+    	return connected;
+    }
+
+    String buildJsonResponse(const String& sensorName, float value, const String& unit, uint64_t timestampUs = 0)
+    {
+    	// Values without a capture time are stamped now, e.g. setpoints and states
+    	if (timestampUs == 0)
+    	{
+    		timestampUs = TimeModuleInternals::getMonotonicMicros();
+    	}
+    	updateTime();
+        String timestamp = TimeModuleInternals::formatTimeStringMs(_timeMod->monotonicToEpochMillis(timestampUs));
 
         json.clearJson();
 
@@ -336,17 +1181,12 @@ private:
         json.createJson("value", value);
         json.createJson("unit", unit);
         json.createJson("timestamp", timestamp);
+        json.createJson("timestamp_us", TimeModuleInternals::uint64ToString(timestampUs));
 
         String jsonString = json.getJsonString();
-        SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, "Generated JSON: " + jsonString);
+        LOG_DEBUG("Generated JSON: " + jsonString);
 
-        return json.getJsonString();
-    }
-
-    String getCurrentTimestamp()
-    {
-    	updateTime();
-        return TimeModuleInternals::formatTimeString(_timeMod->getSystemTime());
+        return jsonString;
     }
 
     void processSetRequest(const String& requestedEndpoint, String& jsonBody)
@@ -380,7 +1220,7 @@ private:
         {
         	String response;
         	{
-        		LockGuard lock(ethernetMutex);
+        		SPIBusLock bus(SPIDevice::ETHERNET);
                 com.getEthernet().setParameter(param, valueStr);
                 response = com.getEthernet().getParameter(param);
         	}
@@ -389,7 +1229,7 @@ private:
         else if (command == "target_position")
         {
         	{
-        		LockGuard lock(ethernetMutex);
+        		SPIBusLock bus(SPIDevice::ETHERNET);
         		com.getEthernet().setParameter(param, valueStr);
         	}
             float rawVal = CalcModuleInternals::extractFloat(valueStr, 1);
@@ -398,7 +1238,7 @@ private:
         else if (command == "target_pressure")
         {
         	{
-        		LockGuard lock(ethernetMutex);
+        		SPIBusLock bus(SPIDevice::ETHERNET);
         		com.getEthernet().setParameter(param, valueStr);
         	}
             float rawVal = CalcModuleInternals::extractFloat(valueStr, 1);
@@ -409,47 +1249,42 @@ private:
     void processGetRequest(const String& requestedEndpoint, String& jsonBody)
     {
         String command = requestedEndpoint.substring(4);
-        Compound2 param;
+        SensorChannel channel;
 
         if (command == "actual_position")
         {
-            param = Compound2::ACTUAL_POSITION;
-
+            channel = SensorChannel::VAT_POSITION;
         }
         else if (command == "actual_pressure")
         {
-            param = Compound2::ACTUAL_PRESSURE;
+            channel = SensorChannel::VAT_PRESSURE;
         }
         else
         {
             return;
         }
 
-        String response;
-        {
-        	LockGuard lock(ethernetMutex);
-        	response = com.getEthernet().getParameter(param);
-        }
-
-        SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, "Response from VAT: " + response);
-
-        float rawVal = CalcModuleInternals::extractFloat(response, 0);
-        jsonBody = buildJsonResponse(requestedEndpoint, rawVal, command.endsWith("position") ? "position" : "mbar");
-        SerialMenu::printToSerial(jsonBody);
+        // sampled by the acquisitionTask, the timestamp is the time of the VAT answer
+        SensorReading reading = SensorSnapshotStore::getInstance()->read(channel);
+        jsonBody = buildJsonResponse(requestedEndpoint, reading.value, command.endsWith("position") ? "position" : "mbar", reading.timestampUs);
     }
 
     String handleFlybackGet(const String& cmd)
     {
         String command = cmd.substring(12);
-        Measurement result = flyback.measure();
-
-        if (command == "voltage") return buildJsonResponse("voltage", result.voltage, "V");
-        if (command == "current") return buildJsonResponse("current", result.current, "uA");
-        if (command == "power") return buildJsonResponse("power", result.power, "uW");
-        if (command == "digital_freq_value") return buildJsonResponse("digital_freq_value", result.digitalFreqValue, "");
-        if (command == "frequency") return buildJsonResponse("frequency", result.frequency, "Hz");
-        if (command == "digital_duty_value") return buildJsonResponse("digital_duty_value", result.digitalDutyValue, "");
-        if (command == "dutyCycle") return buildJsonResponse("dutyCycle", result.dutyCycle, "%");
+
+        // one copy, all values of the same flyback sample
+        SensorSnapshot snapshot = SensorSnapshotStore::getInstance()->read();
+        const SensorReading* hv = snapshot.readings;
+        uint64_t capturedUs = hv[static_cast<uint8_t>(SensorChannel::HV_VOLTAGE)].timestampUs;
+
+        if (command == "voltage") return buildJsonResponse("voltage", hv[static_cast<uint8_t>(SensorChannel::HV_VOLTAGE)].value, "V", capturedUs);
+        if (command == "current") return buildJsonResponse("current", hv[static_cast<uint8_t>(SensorChannel::HV_CURRENT)].value, "uA", capturedUs);
+        if (command == "power") return buildJsonResponse("power", hv[static_cast<uint8_t>(SensorChannel::HV_POWER)].value, "uW", capturedUs);
+        if (command == "digital_freq_value") return buildJsonResponse("digital_freq_value", hv[static_cast<uint8_t>(SensorChannel::HV_FREQUENCY_RAW)].value, "", capturedUs);
+        if (command == "frequency") return buildJsonResponse("frequency", hv[static_cast<uint8_t>(SensorChannel::HV_FREQUENCY)].value, "Hz", capturedUs);
+        if (command == "digital_duty_value") return buildJsonResponse("digital_duty_value", hv[static_cast<uint8_t>(SensorChannel::HV_DUTY_CYCLE_RAW)].value, "", capturedUs);
+        if (command == "dutyCycle") return buildJsonResponse("dutyCycle", hv[static_cast<uint8_t>(SensorChannel::HV_DUTY_CYCLE)].value, "%", capturedUs);
         if (command == "main_switch") return buildJsonResponse("main_switch", static_cast<int>(flyback.getMainSwitchState()), "state");
         if (command == "psu_state") return buildJsonResponse("psu_state", static_cast<int>(flyback.getHVState()), "state");
 
@@ -492,8 +1327,9 @@ private:
 
     	if(command == "targetpressure")
     	{
-    		float target = vacControl.getCurrentTargetPressure();
-    		return buildJsonResponse("target_pressure", target, "bar");
+    		// as the control task saw it in its last run()
+    		MillibarPressure target(vacControl.getStatus().targetPressure);
+    		return buildJsonResponse("target_pressure", target.value(), unitSymbol(target));
     	}
     	return "";
     }
@@ -501,10 +1337,289 @@ private:
     String handleVacuumPumpGet(const String& cmd)
     {
     	String command = cmd.substring(9);
-        if (command == "state") return buildJsonResponse("pump_state", static_cast<int>(vacControl.getPumpState()), "state");
+        if (command == "state") return buildJsonResponse("pump_state", static_cast<int>(vacControl.getStatus().pump), "state");
         return "";
     }
 
+#if USE_DATALOGGER
+    String handleDataLogSet(const String& cmd)
+    {
+    	// set_datalog/<rate Hz>/<seconds>, set_datalog/0 stops
+    	String valueStr = cmd.substring(12);
+    	int separatorIndex = valueStr.indexOf('/');
+    	long rateHz = valueStr.toInt();
+    	long seconds = (separatorIndex != -1) ? valueStr.substring(separatorIndex + 1).toInt() : 0;
+
+    	if (rateHz <= 0)
+    	{
+    		stopDataLogging();
+    		return buildJsonResponse("datalog", 0, "bool");
+    	}
+
+    	bool started = seconds > 0 && startDataLogging(static_cast<uint16_t>(rateHz), static_cast<uint32_t>(seconds));
+    	return buildJsonResponse("datalog", started ? 1 : 0, "bool");
+    }
+
+    String handleDataLogGet(const String& cmd)
+    {
+    	String command = cmd.substring(12);
+    	if (command == "running") return buildJsonResponse("datalog_running", DataLogger::isRunning() ? 1 : 0, "bool");
+
+    	DataLoggerStats stats = DataLogger::getInstance()->getStats();
+    	if (command == "samples") return buildJsonResponse("datalog_samples", stats.samples, "samples");
+    	if (command == "overruns") return buildJsonResponse("datalog_overruns", stats.overruns, "samples");
+    	if (command == "blocks") return buildJsonResponse("datalog_blocks", stats.blocksWritten, "blocks");
+    	if (command == "errors") return buildJsonResponse("datalog_errors", stats.writeErrors, "blocks");
+    	if (command == "throughput") return buildJsonResponse("datalog_throughput", stats.bytesPerSecond, "B/s");
+    	if (command == "max_write") return buildJsonResponse("datalog_max_write", stats.maxBlockWriteUs, "us");
+    	if (command == "busy") return buildJsonResponse("datalog_busy", stats.busyUs, "us");
+
+    	return "";
+    }
+#endif
+
+#if USE_STATISTICS
+    String handleStatsGet(const String& cmd)
+    {
+    	// get_stats?ch=<name>&reset=1, reset starts a new window after the answer
+    	const HistoryChannel* entry = findHistoryChannel(getQueryParameter(cmd, "ch"));
+    	SensorStatistics* statistics = SensorStatistics::getInstance();
+    	StatsSummary summary;
+    	if (entry == nullptr || !statistics->getSummary(entry->channel, summary)) return "";
+
+    	if (getQueryParameter(cmd, "reset") == "1")
+    	{
+    		statistics->reset(entry->channel);
+    	}
+
+    	updateTime();
+    	json.clearJson();
+    	json.createJson("channel", entry->name);
+    	json.createJson("unit", entry->unit);
+    	json.createJson("count", summary.count);
+    	json.createJson("mean", summary.mean);
+    	json.createJson("std", summary.standardDeviation);
+    	json.createJson("min", summary.min);
+    	json.createJson("max", summary.max);
+    	json.createJson("p50", summary.median);
+    	json.createJson("p95", summary.percentile95);
+    	json.createJson("since", TimeModuleInternals::formatTimeStringMs(_timeMod->monotonicToEpochMillis(summary.sinceUs)));
+    	return json.getJsonString();
+    }
+#endif
+
+#if USE_SCOPE
+    String handleScopeSet(const String& cmd)
+    {
+    	// set_scope?ch=<name>&trigger=<none|rising|falling|slope|ext>&level=<0..1023>&pre=<samples>
+    	//   &timeout=<ms>&div=<32|64|128>&auto=1&pin=<interrupt pin>, all but ch and trigger optional
+    	// set_scope?trigger=off disarms
+    	ScopeCapture* scope = ScopeCapture::getInstance();
+    	String trigger = getQueryParameter(cmd, "trigger");
+    	if (trigger == "off")
+    	{
+    		scope->disarm();
+    		return handleScopeStateGet();
+    	}
+
+    	const ScopeChannel* entry = nullptr;
+    	String name = getQueryParameter(cmd, "ch");
+    	for (uint8_t i = 0; i < SCOPE_CHANNEL_COUNT; i++)
+    	{
+    		if (name == scopeChannels[i].name)
+    		{
+    			entry = &scopeChannels[i];
+    		}
+    	}
+    	if (entry == nullptr) return "";
+    	if (!isScopeAllowed(entry->pin)) return "";
+
+    	ScopeConfig config = {};
+    	config.pin = entry->pin;
+    	if (trigger == "none") config.trigger = ScopeTrigger::NONE;
+    	else if (trigger == "rising") config.trigger = ScopeTrigger::RISING_LEVEL;
+    	else if (trigger == "falling") config.trigger = ScopeTrigger::FALLING_LEVEL;
+    	else if (trigger == "slope") config.trigger = ScopeTrigger::SLOPE;
+    	else if (trigger == "ext") config.trigger = ScopeTrigger::EXTERNAL_EDGE;
+    	else return "";
+
+    	String pre = getQueryParameter(cmd, "pre");
+    	String timeout = getQueryParameter(cmd, "timeout");
+    	String div = getQueryParameter(cmd, "div");
+    	config.level = getQueryParameter(cmd, "level").toInt();
+    	config.preTrigger = (pre.length() > 0) ? pre.toInt() : SCOPE_BUFFER_SIZE / 4;
+    	config.timeoutMs = (timeout.length() > 0) ? timeout.toInt() : 200;
+    	config.freezeOnTimeout = getQueryParameter(cmd, "auto") == "1";
+    	config.externalPin = getQueryParameter(cmd, "pin").toInt();
+    	config.prescaler = (div.length() > 0) ? div.toInt() : SCOPE_DEFAULT_PRESCALER;
+
+    	bool armed = scope->arm(config);
+    	json.clearJson();
+    	json.createJson("armed", armed ? 1 : 0);
+    	json.createJson("channel", entry->name);
+    	json.createJson("rate_hz", armed ? 1000000000UL / ScopeCapture::getSampleIntervalNs(config.prescaler) : 0);
+    	json.createJson("samples", scope->getSampleCount());
+    	json.createJson("pre", config.preTrigger);
+    	return json.getJsonString();
+    }
+
+    String handleScopeStateGet()
+    {
+    	// get_scope_state, trigger is the time of the trigger sample of a captured or triggered capture
+    	ScopeCapture* scope = ScopeCapture::getInstance();
+    	ScopeState state = scope->getState();
+    	const ScopeConfig& config = scope->getConfig();
+
+    	updateTime();
+    	json.clearJson();
+    	json.createJson("state", scopeStateNames[static_cast<uint8_t>(state)]);
+    	json.createJson("channel", static_cast<int>(AdcEngine::toChannel(config.pin)));
+    	json.createJson("triggered", scope->wasTriggered() ? 1 : 0);
+    	if (state == ScopeState::CAPTURED || state == ScopeState::TRIGGERED)
+    	{
+    		json.createJson("trigger", TimeModuleInternals::formatTimeStringMs(_timeMod->monotonicToEpochMillis(scope->getTriggerUs())));
+    	}
+    	uint32_t intervalNs = ScopeCapture::getSampleIntervalNs(config.prescaler);
+    	json.createJson("rate_hz", (intervalNs > 0) ? 1000000000UL / intervalNs : 0);
+    	json.createJson("samples", scope->getSampleCount());
+    	json.createJson("pre", config.preTrigger);
+    	json.createJson("overruns", AdcEngine::getInstance()->getCaptureOverruns());
+    	return json.getJsonString();
+    }
+#endif
+
+#if USE_EVENTS
+    String handleEventSet(const String& cmd)
+    {
+    	// set_event?trigger=<hv,switch,threshold,manual>&ch=<name>&level=<value>&dir=<above|below>
+    	//   &pre=<records>&period=<ms>, ch and level only with threshold, the others optional
+    	// set_event?trigger=off disarms, set_event?fire=1 records an event with the next record
+    	EventRecorder* events = EventRecorder::getInstance();
+    	if (getQueryParameter(cmd, "fire") == "1")
+    	{
+    		events->trigger();
+    		return handleEventStateGet();
+    	}
+
+    	String trigger = getQueryParameter(cmd, "trigger");
+    	if (trigger == "off")
+    	{
+    		events->disarm();
+    		return handleEventStateGet();
+    	}
+
+    	EventConfig config = {};
+    	if (trigger.indexOf("hv") != -1) config.sources |= 1 << static_cast<uint8_t>(EventSource::HV_ENABLE);
+    	if (trigger.indexOf("switch") != -1) config.sources |= 1 << static_cast<uint8_t>(EventSource::MAIN_SWITCH);
+    	if (trigger.indexOf("threshold") != -1) config.sources |= 1 << static_cast<uint8_t>(EventSource::THRESHOLD);
+    	if (trigger.indexOf("manual") != -1) config.sources |= 1 << static_cast<uint8_t>(EventSource::MANUAL);
+    	if (config.sources == 0) return "";
+
+    	if (config.sources & (1 << static_cast<uint8_t>(EventSource::THRESHOLD)))
+    	{
+    		const HistoryChannel* entry = findHistoryChannel(getQueryParameter(cmd, "ch"));
+    		String level = getQueryParameter(cmd, "level");
+    		if (entry == nullptr || level.length() == 0) return "";
+    		config.channel = static_cast<EventChannel>(entry - historyChannels);
+    		config.level = level.toFloat();
+    		config.above = getQueryParameter(cmd, "dir") != "below";
+    	}
+
+    	String pre = getQueryParameter(cmd, "pre");
+    	String period = getQueryParameter(cmd, "period");
+    	config.preRecords = (pre.length() > 0) ? pre.toInt() : events->getCapacity() / 2;
+    	config.periodMs = (period.length() > 0) ? period.toInt() : 50;
+
+    	bool armed = events->arm(config);
+    	json.clearJson();
+    	json.createJson("armed", armed ? 1 : 0);
+    	json.createJson("records", events->getCapacity());
+    	json.createJson("pre", config.preRecords);
+    	json.createJson("period_ms", config.periodMs);
+    	return json.getJsonString();
+    }
+
+    String handleEventStateGet()
+    {
+    	// get_event_state, last is the id of the newest file for get_event_data
+    	EventRecorder* events = EventRecorder::getInstance();
+    	const EventConfig& config = events->getConfig();
+
+    	json.clearJson();
+    	json.createJson("state", eventStateNames[static_cast<uint8_t>(events->getState())]);
+    	json.createJson("records", events->getCapacity());
+    	json.createJson("pre", config.preRecords);
+    	json.createJson("period_ms", config.periodMs);
+    	json.createJson("events", events->getEventCount());
+    	json.createJson("missed", events->getMissedCount());
+    	json.createJson("errors", events->getWriteErrors());
+    	json.createJson("last", events->getLastIndex());
+    	json.createJson("last_source", eventSourceNames[static_cast<uint8_t>(events->getLastSource())]);
+    	return json.getJsonString();
+    }
+#endif
+
+#if USE_SCOPE
+    String handleRippleGet(const String& cmd)
+    {
+    	// get_ripple?n=<64|128>, spectrum of the first n samples of the frozen capture, n optional
+    	String n = getQueryParameter(cmd, "n");
+    	uint16_t points = (n.length() > 0) ? n.toInt() : RIPPLE_MAX_POINTS;
+    	RippleResult result;
+    	if (!RippleAnalyzer::getInstance()->analyze(points, result)) return "";
+
+    	// the HV divider in V, the other inputs in ADC counts
+    	bool isHv = AdcEngine::toChannel(ScopeCapture::getInstance()->getConfig().pin) == AdcEngine::toChannel(A0);
+    	float scale = isHv ? Flyback::getVoltsPerCount() : 1.0f;
+
+    	// the PWM is faster than half the sample rate, its ripple shows up folded at alias_hz
+    	// the frequency as get_flyback_frequency reports it, 0 while the HV is off
+    	float pwmHz = SensorSnapshotStore::getInstance()->read(SensorChannel::HV_FREQUENCY).value;
+    	float aliasHz = fmod(pwmHz, result.sampleRateHz);
+    	if (aliasHz > result.sampleRateHz / 2) aliasHz = result.sampleRateHz - aliasHz;
+
+    	json.clearJson();
+    	json.createJson("unit", isHv ? "V" : "counts");
+    	json.createJson("points", result.points);
+    	json.createJson("rate_hz", result.sampleRateHz);
+    	json.createJson("bin_hz", result.binHz);
+    	json.createJson("mean", result.mean * scale);
+    	json.createJson("rms", result.rms * scale);
+    	json.createJson("pp", result.peakToPeak * scale);
+    	json.createJson("dominant_hz", result.dominantHz);
+    	json.createJson("dominant", result.dominantAmplitude * scale);
+    	json.createJson("thd_percent", result.thd * 100.0f);
+    	json.createJson("harmonics", result.harmonics);
+    	json.createJson("pwm_hz", pwmHz);
+    	json.createJson("alias_hz", aliasHz);
+    	return json.getJsonString();
+    }
+#endif
+
+    String handleSPIBusGet(const String& cmd)
+    {
+    	// get_spibus_<eth|sd>_<load|wait|max_hold|grants>
+    	String command = cmd.substring(11);
+    	int separatorIndex = command.indexOf('_');
+    	if (separatorIndex == -1) return "";
+
+    	String deviceName = command.substring(0, separatorIndex);
+    	String metric = command.substring(separatorIndex + 1);
+    	SPIDevice device;
+    	if (deviceName == "eth") device = SPIDevice::ETHERNET;
+    	else if (deviceName == "sd") device = SPIDevice::SD_CARD;
+    	else return "";
+
+    	SPIBusManager* bus = SPIBusManager::getInstance();
+    	SPIBusStats stats = bus->getStats(device);
+    	if (metric == "load") return buildJsonResponse(cmd.substring(4), bus->getOccupancy(device), "%");
+    	if (metric == "wait") return buildJsonResponse(cmd.substring(4), stats.waitUs, "us");
+    	if (metric == "max_hold") return buildJsonResponse(cmd.substring(4), stats.maxHoldUs, "us");
+    	if (metric == "grants") return buildJsonResponse(cmd.substring(4), stats.grants, "grants");
+
+    	return "";
+    }
+
     String handleVacuumPumpSet(const String& cmd)
     {
         String valueStr = cmd.substring(9);
@@ -519,13 +1634,13 @@ private:
 
         if (command == "MCP9601C_Indoor")
         {
-        	float value = sens.readSensor(SensorType::MCP9601_Celsius_Indoor);
-        	jsonBody = buildJsonResponse(requestedEndpoint, value, "C");
+        	SensorReading reading = SensorSnapshotStore::getInstance()->read(SensorChannel::TEMPERATURE_INDOOR);
+        	jsonBody = buildJsonResponse(requestedEndpoint, reading.value, "C", reading.timestampUs);
         }
         else if (command == "MCP9601C_Outdoor")
         {
-        	float value = sens.readSensor(SensorType::MCP9601_Celsius_Outdoor);
-        	jsonBody = buildJsonResponse(requestedEndpoint, value, "C");
+        	SensorReading reading = SensorSnapshotStore::getInstance()->read(SensorChannel::TEMPERATURE_OUTDOOR);
+        	jsonBody = buildJsonResponse(requestedEndpoint, reading.value, "C", reading.timestampUs);
         }
     }
 
@@ -591,7 +1706,7 @@ private:
     {
     	jsonBody = buildJsonResponse(requestedEndpoint, 1, "bool");
     	{
-    		LockGuard lock(ethernetMutex);
+    		SPIBusLock bus(SPIDevice::ETHERNET);
     		com.getEthernet().sendJsonResponse(jsonBody);
     	}
     	msleep(1000);
@@ -600,6 +1715,150 @@ private:
 };
 SensorActorEndpointTask sensorActorEndpointTask;
 
+/// @brief Implementation of the LoggerTask class, writes the queued log messages to serial and SD-Card \class LoggerTask
+class LoggerTask final : public frt::Task<LoggerTask, 256>
+{
+private:
+    static const uint32_t LOG_DRAIN_INTERVAL_MS = 20;
+
+public:
+    bool run()
+    {
+#if USE_DATALOGGER
+        // full data logger blocks first, the DataLoggerTask posts when one is ready
+        if (DataLogger::isRunning())
+        {
+            DataLogger::getInstance()->service();
+        }
+#endif
+
+#if USE_EVENTS
+        // then a frozen event record, found within one drain interval
+        EventRecorder* events = EventRecorder::getInstance();
+        if (events->hasPendingRecord())
+        {
+            events->service();
+        }
+#endif
+
+        if (SerialMenu::processLogQueue() == 0)
+        {
+            wait(LOG_DRAIN_INTERVAL_MS);
+        }
+        else
+        {
+            yield();
+        }
+        return true;
+    }
+};
+LoggerTask loggerTask;
+
+#if USE_DATALOGGER
+/// @brief Implementation of the DataLoggerTask class, samples the shot diagnostics for the DataLogger, paced by Timer3 \class DataLoggerTask
+class DataLoggerTask final : public frt::Task<DataLoggerTask, 384>
+{
+public:
+    bool run()
+    {
+        // posted by the Timer3 compare interrupt at the sample rate
+        wait();
+
+        if (!DataLogger::isRunning())
+        {
+            stopSampleTimer();
+            return true;
+        }
+
+        // the HV at the sample rate, the slow channels from the acquisitionTask
+        SensorSnapshot snapshot = SensorSnapshotStore::getInstance()->read();
+        Measurement hv = flyback.sample();
+        float values[] = {
+            hv.voltage, hv.current,
+            snapshot.readings[static_cast<uint8_t>(SensorChannel::VAT_PRESSURE)].value,
+            snapshot.readings[static_cast<uint8_t>(SensorChannel::TEMPERATURE_INDOOR)].value,
+            snapshot.readings[static_cast<uint8_t>(SensorChannel::TEMPERATURE_OUTDOOR)].value
+        };
+
+        DataLogger* logger = DataLogger::getInstance();
+        logger->logSample(values);
+        if (logger->hasPendingBlock())
+        {
+            loggerTask.post();
+        }
+        return true;
+    }
+};
+DataLoggerTask dataLoggerTask;
+
+// Timer3 paces the data logger, Timer1 is the flyback PWM
+ISR(TIMER3_COMPA_vect)
+{
+    dataLoggerTask.preemptableISRPost();
+}
+
+void startSampleTimer(uint16_t rateHz)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TCCR3A = 0;
+        TCCR3B = (1 << WGM32) | (1 << CS31) | (1 << CS30); // CTC, prescaler 64
+        OCR3A = static_cast<uint16_t>(F_CPU / 64UL / rateHz - 1);
+        TCNT3 = 0;
+        TIMSK3 = (1 << OCIE3A);
+    }
+}
+
+void stopSampleTimer()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TIMSK3 = 0;
+        TCCR3B = 0;
+    }
+}
+
+bool startDataLogging(uint16_t rateHz, uint32_t seconds)
+{
+    // Timer3 with prescaler 64 reaches down to 4 Hz
+    if (rateHz < DATALOG_MIN_RATE_HZ || rateHz > DATALOG_MAX_RATE_HZ)
+    {
+        return false;
+    }
+
+    DataLogger* logger = DataLogger::getInstance();
+    static bool schemaSet = false;
+    if (!schemaSet)
+    {
+        // the names of get_history, the logger keeps the pointers
+        for (uint8_t i = 0; i < HISTORY_CHANNEL_COUNT; i++)
+        {
+            logger->addChannel(historyChannels[i].name, historyChannels[i].unit);
+        }
+        schemaSet = true;
+    }
+
+    if (!logger->start(rateHz, seconds))
+    {
+        SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("DataLogger: could not preallocate the file"), true, true);
+        return false;
+    }
+
+    startSampleTimer(rateHz);
+    SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, "DataLogger: recording to " + logger->getFileName());
+    return true;
+}
+
+void stopDataLogging()
+{
+    stopSampleTimer();
+    if (DataLogger::isRunning())
+    {
+        DataLogger::getInstance()->stop();
+    }
+}
+#endif
+
 /// @brief Implementation of theStackMonitorTask Class, Handles the Stacks of all running tasks. \class StackMonitorTask
 class StackMonitorTask final : public frt::Task<StackMonitorTask, 256>
 {
@@ -608,15 +1867,34 @@ public:
     static const unsigned int MONITORING_TASK_STACK_LIMIT = 128;
     static const unsigned int SENSOR_ACTOR_TASK_STACK_LIMIT = 1024;
     static const unsigned int FLYBACK_VAC_TASK_STACK_LIMIT = 512;
+    static const unsigned int LOGGER_TASK_STACK_LIMIT = 256;
+    static const unsigned int DATALOGGER_TASK_STACK_LIMIT = 384;
+    static const unsigned int ACQUISITION_TASK_STACK_LIMIT = 384;
 
     static const float THRESHOLD = 0.8f;
     static const float ERR_THRESHOLD = 0.9f;
 
+    /// @brief IDs of the monitored tasks in the STACK_USAGE_HIGH log token. \enum MonitoredTask
+    enum MonitoredTask : uint8_t
+    {
+        REPORT_TASK,
+        SENSOR_ACTOR_TASK,
+        FLYBACK_VAC_TASK,
+        LOGGER_TASK,
+        DATALOGGER_TASK,
+        ACQUISITION_TASK
+    };
+
     bool run()
     {
-        checkAndReport("reportTask", reportTask.getUsedStackSize(), REPORT_TASK_STACK_LIMIT);
-        checkAndReport("sensorActorEndpointTask", sensorActorEndpointTask.getUsedStackSize(), SENSOR_ACTOR_TASK_STACK_LIMIT);
-        checkAndReport("flyBackVacControlTask", flyBackVacControlTask.getUsedStackSize(), FLYBACK_VAC_TASK_STACK_LIMIT);
+        checkAndReport(REPORT_TASK, reportTask.getUsedStackSize(), REPORT_TASK_STACK_LIMIT);
+        checkAndReport(SENSOR_ACTOR_TASK, sensorActorEndpointTask.getUsedStackSize(), SENSOR_ACTOR_TASK_STACK_LIMIT);
+        checkAndReport(FLYBACK_VAC_TASK, flyBackVacControlTask.getUsedStackSize(), FLYBACK_VAC_TASK_STACK_LIMIT);
+        checkAndReport(LOGGER_TASK, loggerTask.getUsedStackSize(), LOGGER_TASK_STACK_LIMIT);
+#if USE_DATALOGGER
+        checkAndReport(DATALOGGER_TASK, dataLoggerTask.getUsedStackSize(), DATALOGGER_TASK_STACK_LIMIT);
+#endif
+        checkAndReport(ACQUISITION_TASK, acquisitionTask.getUsedStackSize(), ACQUISITION_TASK_STACK_LIMIT);
 
         msleep(1000);
         reportTask.post();
@@ -624,11 +1902,11 @@ public:
     }
 
 private:
-    void checkAndReport(const String& taskName, unsigned int used, unsigned int limit)
+    void checkAndReport(MonitoredTask task, unsigned int used, unsigned int limit)
     {
         if (used >= static_cast<unsigned int>(limit * THRESHOLD))
         {
-            SerialMenu::printToSerial(SerialMenu::OutputLevel::WARNING, "Stack usage high for " + taskName + ": " + String(used) + " / " + String(limit));
+            LOG_TOKEN(WARNING, STACK_USAGE_HIGH, static_cast<unsigned int>(task), used, limit);
         }
         else if (used >= static_cast<unsigned int>(limit * ERR_THRESHOLD))
         {
@@ -642,6 +1920,7 @@ StackMonitorTask stackMonitorTask;
 void gracefulRestart()
 {
     if (flyBackVacControlTask.isRunning()) flyBackVacControlTask.stop();
+    if (acquisitionTask.isRunning()) acquisitionTask.stop();
     if (sensorActorEndpointTask.isRunning()) sensorActorEndpointTask.stop();
     if (reportTask.isRunning()) reportTask.stop();
     if (stackMonitorTask.isRunning()) stackMonitorTask.stop();
@@ -656,12 +1935,17 @@ void gracefulRestart()
 
     stackMonitorTask.start(1);
     reportTask.start(1);
+    acquisitionTask.start(2);
     sensorActorEndpointTask.start(2);
     flyBackVacControlTask.start(3);
 }
 
 void hardRestart()
 {
+#if USE_DATALOGGER
+    stopDataLogging();
+#endif
+    SerialMenu::processLogQueue();
     com.getSerial().endSerial();
     com.getI2C().endI2C();
     com.getSPI().endSPI();
@@ -669,6 +1953,30 @@ void hardRestart()
 	while (true) {}
 }
 
+// RAM of the enabled features, the storage above plus the singletons setup() creates
+#ifdef __AVR__
+static_assert(0
+#if USE_STATISTICS
+    + sizeof(SensorStatistics)
+#endif
+#if USE_HISTORY
+    + HISTORY_STORAGE_SIZE + sizeof(SensorHistory)
+#endif
+#if USE_TREND
+    + TREND_STORAGE_SIZE + sizeof(SensorTrend)
+#endif
+#if USE_SCOPE
+    + SCOPE_BUFFER_SIZE + sizeof(rippleWork) + sizeof(ScopeCapture) + sizeof(RippleAnalyzer)
+#endif
+#if USE_EVENTS
+    + EVENT_STORAGE_SIZE + sizeof(EventRecorder)
+#endif
+#if USE_DATALOGGER
+    + sizeof(DataLogger) + StackMonitorTask::DATALOGGER_TASK_STACK_LIMIT
+#endif
+    <= FEATURE_RAM_BUDGET, "the enabled features exceed FEATURE_RAM_BUDGET, disable one with -DUSE_<FEATURE>=0");
+#endif
+
 void setup()
 {
     com.getSerial().beginSerial(9600);
@@ -681,11 +1989,23 @@ void setup()
     }
     else
     {
+#ifdef LOG_BINARY_RECORDS
+    	// also set by LOG_TOKENIZED, decode with eSW/utils/logTool: logTool records <logTokens.h> LOG00001.BIN
+    	LogManager::getInstance()->setBinaryRecords(true);
+    	LogManager::getInstance()->setLogFileName("log.bin");
+#else
     	LogManager::getInstance()->setLogFileName("log.txt");
+#endif
     }
 
     SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("Starting up..."));
 
+    // before anything reads an analog input
+    if (!AdcEngine::getInstance()->begin(adcChannels, sizeof(adcChannels) / sizeof(adcChannels[0])))
+    {
+    	SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("ADC scan failed to start..."), true);
+    }
+
     // init all comModules
     sens.initialize();
     flyback.initialize();
@@ -703,17 +2023,63 @@ void setup()
     // activate the stackguard
     ReportSystem::initStackGuard();
 
+#if USE_HISTORY
+    SensorChannel channels[HISTORY_CHANNEL_COUNT];
+    for (uint8_t i = 0; i < HISTORY_CHANNEL_COUNT; i++)
+    {
+    	channels[i] = historyChannels[i].channel;
+    }
+    if (!SensorHistory::getInstance()->begin(historyStorage, sizeof(historyStorage), channels, HISTORY_CHANNEL_COUNT))
+    {
+    	SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("History storage too small..."), true);
+    }
+#endif
+#if USE_SCOPE
+    if (!ScopeCapture::getInstance()->begin(scopeStorage, sizeof(scopeStorage)))
+    {
+    	SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Scope storage too small..."), true);
+    }
+    RippleAnalyzer::getInstance()->begin(rippleWork, RIPPLE_MAX_POINTS);
+#endif
+#if USE_EVENTS
+    if (!EventRecorder::getInstance()->begin(eventStorage, sizeof(eventStorage)))
+    {
+    	SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Event storage too small..."), true);
+    }
+#endif
+#if USE_STATISTICS
+    SensorStatistics::getInstance()->begin(statsChannels, sizeof(statsChannels) / sizeof(statsChannels[0]));
+#endif
+#if USE_TREND
+    if (!SensorTrend::getInstance()->begin(trendStorage, sizeof(trendStorage), trendConfigs, sizeof(trendConfigs) / sizeof(trendConfigs[0])))
+    {
+    	SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Trend storage too small..."), true);
+    }
+#endif
+
     // Get latest time from HAS
-    String startTime = com.getEthernet().getSpecificEndpoint("time/");
-    _timeMod->setTimeFromHas(startTime);
+    syncTimeWithHas();
 
     SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("Setup complete."));
 
+    // from here on log calls only queue, the loggerTask prints them
+    SerialMenu::startAsyncLogging();
+
     // Start tasks
+    loggerTask.start(1);
+#if USE_DATALOGGER
+    dataLoggerTask.start(3);
+#endif
     stackMonitorTask.start(1);
     reportTask.start(1);
+    acquisitionTask.start(2);
     sensorActorEndpointTask.start(2); // was 2
     flyBackVacControlTask.start(3); // was 3
+
+    // all task stacks are in place now, static or on the heap, the rest is left for the Strings
+    unsigned int freeRam = getFreeMemSize();
+    SerialMenu::printToSerial((freeRam < RAM_RESERVE_BYTES) ? SerialMenu::OutputLevel::ERROR : SerialMenu::OutputLevel::INFO,
+    	"Free RAM after setup: " + String(freeRam) + " B, reserve " + String(RAM_RESERVE_BYTES) + " B");
 }
 
 void loop()
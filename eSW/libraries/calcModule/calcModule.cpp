@@ -9,6 +9,8 @@
  * 
  */
 #include "calcModule.h"
+#include "runningStats.h"
+#include "quantity.h"
 #include <Arduino.h>
 #include <math.h>
 
@@ -67,95 +69,123 @@ float CalcModuleInternals::findMinimum(const float* data, int length)
 float CalcModuleInternals::calculateStandardDeviation(const float* data, int length)
 {
     if (length <= 0 || data == nullptr) return 0.0;
-    float mean = calculateAverage(data, length);
-    float variance = 0.0;
+    // one pass, the mean is not rounded before it is used
+    RunningStats stats;
     for (int i = 0; i < length; ++i)
     {
-        variance += (data[i] - mean) * (data[i] - mean);
+        stats.add(data[i]);
     }
-    variance /= length;
-    return roundToPrecision(sqrtf(variance), 5);
+    return roundToPrecision(stats.getStandardDeviation(), 5);
 }
 
 float CalcModuleInternals::findMedian(float* data, int length)
 {
     if (length <= 0 || data == nullptr) return 0.0;
-    sortArray(data, length);
-    float result;
+    int middle = length / 2;
+    float result = selectKth(data, length, middle);
     if (length % 2 == 0)
     {
-        result = (data[length / 2 - 1] + data[length / 2]) / 2.0;
-        return roundToPrecision(result, 5);
-    }
-    else
-    {
-        result = data[length / 2];
-        return roundToPrecision(result, 5);
+        // the lower middle is the largest value left of the upper one
+        float lower = data[0];
+        for (int i = 1; i < middle; ++i)
+        {
+            if (data[i] > lower)
+            {
+                lower = data[i];
+            }
+        }
+        result = (lower + result) / 2.0;
     }
+    return roundToPrecision(result, 5);
 }
 
-void CalcModuleInternals::sortArray(float* data, int length)
+float CalcModuleInternals::selectKth(float* data, int length, int k)
 {
-    for (int i = 0; i < length - 1; ++i)
+    if (length <= 0 || data == nullptr || k < 0 || k >= length) return 0.0;
+    int left = 0;
+    int right = length - 1;
+    while (right > left)
     {
-        for (int j = 0; j < length - i - 1; ++j)
+        // median of three, sorted data does not degrade to O(n^2)
+        int mid = left + (right - left) / 2;
+        if (data[mid] < data[left]) swapValues(data, mid, left);
+        if (data[right] < data[left]) swapValues(data, right, left);
+        if (data[right] < data[mid]) swapValues(data, right, mid);
+        float pivot = data[mid];
+
+        int i = left;
+        int j = right;
+        while (i <= j)
         {
-            if (data[j] > data[j + 1])
+            while (data[i] < pivot) ++i;
+            while (data[j] > pivot) --j;
+            if (i <= j)
             {
-                // Swap data[j] and data[j + 1]
-                float temp = data[j];
-                data[j] = data[j + 1];
-                data[j + 1] = temp;
+                swapValues(data, i, j);
+                ++i;
+                --j;
             }
         }
+
+        if (k <= j) right = j;
+        else if (k >= i) left = i;
+        else break;
     }
+    return data[k];
+}
+
+void CalcModuleInternals::swapValues(float* data, int i, int j)
+{
+    float temp = data[i];
+    data[i] = data[j];
+    data[j] = temp;
 }
 
 float CalcModuleInternals::celsiusToFahrenheit(float celsius)
 {
-	float result = (celsius * 9.0 / 5.0) + 32.0;
+	float result = Temperature<units::Celsius>(celsius).to<units::Fahrenheit>().value();
     return roundToPrecision(result, 5);
 }
 
 float CalcModuleInternals::fahrenheitToCelsius(float fahrenheit)
 {
-	float result = (fahrenheit - 32.0) * 5.0 / 9.0;
+	float result = Temperature<units::Fahrenheit>(fahrenheit).to<units::Celsius>().value();
     return roundToPrecision(result, 5);
 }
 
 float CalcModuleInternals::celsiusToKelvin(float celsius)
 {
-	float result = celsius + 273.15;
+	float result = Temperature<units::Celsius>(celsius).to<units::Kelvin>().value();
     return roundToPrecision(result, 5);
 }
 
 float CalcModuleInternals::kelvinToCelsius(float kelvin)
 {
-	float result = kelvin - 273.15;
+	float result = Temperature<units::Kelvin>(kelvin).to<units::Celsius>().value();
     return roundToPrecision(result, 5);
 }
 
 float CalcModuleInternals::pascalToAtm(float pascal)
 {
-    float result =  pascal / 101325.0; // 1 atm = 101325 Pa
+    float result = Pressure<units::Pascal>(pascal).to<units::Atmosphere>().value();
     return roundToPrecision(result, 5);
 }
 
 float CalcModuleInternals::atmToPascal(float atm)
 {
-    float result = atm * 101325.0;
+    float result = Pressure<units::Atmosphere>(atm).to<units::Pascal>().value();
     return roundToPrecision(result, 5);
 }
 
 float CalcModuleInternals::pascalToPsi(float pascal)
 {
-	float result = pascal * 0.000145038; // 1 Pa = 0.000145038 psi
+	float result = Pressure<units::Pascal>(pascal).to<units::Psi>().value();
     return roundToPrecision(result, 5);
 }
 
 float CalcModuleInternals::psiToPascal(float psi)
 {
-	float result = psi * 6894.76; // 1 psi = 6894.76 Pa
+	float result = Pressure<units::Psi>(psi).to<units::Pascal>().value();
     return roundToPrecision(result, 5);
 }
 
@@ -166,27 +196,26 @@ float CalcModuleInternals::calculatePressureFromSensor(int sensorValue, Pressure
 		return NAN;
 	}
 
-	float voltage = (sensorValue * (5.0f / 1023.0f));
-	float pressurePascal = voltage * 10000.0f;
-
-	float result = pressurePascal;
+	// 5 V / 1023 counts * 10000 Pa/V, folded with the unit factor at compile time:
+	// one conversion and one multiply per reading, no division
+	constexpr Pressure<units::Pascal> perCount(5.0f / 1023.0f * 10000.0f);
+	float factor = perCount.value();
 	switch(unit)
 	{
 		case PressureUnit::Pascal:
-			result = pressurePascal;
 			break;
 		case PressureUnit::Atmosphere:
-			result = pascalToAtm(pressurePascal);
+			factor = perCount.to<units::Atmosphere>().value();
 			break;
 		case PressureUnit::Psi:
-			result = pascalToPsi(pressurePascal);
+			factor = perCount.to<units::Psi>().value();
 			break;
 		case PressureUnit::Bar:
-			result = pressurePascal / 100000.0f;
+			factor = perCount.to<units::Bar>().value();
 			break;
 	}
 
-	return roundToPrecision(result, 5);
+	return roundToPrecision(sensorValue * factor, 5);
 }
 
 float CalcModuleInternals::calculatePower(float voltage, float current)
@@ -331,7 +360,9 @@ float CalcModuleInternals::extractFloatFromResponse(const String& response, Type
 
 float CalcModuleInternals::roundToPrecision(float value, int precision)
 {
-	float factor = pow(10, precision);
+	// exact powers of ten from a table instead of pow()
+	static const float factors[] PROGMEM = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f, 1000000.0f };
+	float factor = (precision >= 0 && precision < 7) ? pgm_read_float(&factors[precision]) : pow(10, precision);
 	return round(value * factor) / factor;
 }
 
@@ -17,7 +17,7 @@
 namespace calcModule
 {
 	/// @brief Enum for the different Types we want to extract from a response \enum Type
-	enum Type
+	enum class Type
 	{
 		General,
 		Pressure,
@@ -77,7 +77,8 @@ namespace calcModule
         static float calculateStandardDeviation(const float* data, int length);
 
         /**
-         * @brief Function to calculate the median of a data set.
+         * @brief Function to calculate the median of a data set, O(n) on average.
+         * The data set is reordered, see selectKth().
          *
          * @param data -> The data set to calculate the median from.
          * @param length -> The length of the data set.
@@ -85,6 +86,17 @@ namespace calcModule
          */
         static float findMedian(float* data, int length);
 
+        /**
+         * @brief Function to find the k-th smallest value, quickselect with median of three pivots.
+         * Afterwards data[k] holds it, no value before it is larger and no value after it smaller.
+         *
+         * @param data -> The data set, reordered.
+         * @param length -> The length of the data set.
+         * @param k -> The rank, 0 for the minimum.
+         * @return float -> The k-th smallest value, 0 if k is out of range.
+         */
+        static float selectKth(float* data, int length, int k);
+
         /**
          * @brief Function to convert celsius to fahrenheit.
          *
@@ -206,12 +218,13 @@ namespace calcModule
     private:
 
         /**
-         * @brief Function to sort an array.
+         * @brief Function to swap two values of an array.
          *
-         * @param data -> The data array to sort.
-         * @param length -> The length of the data array.
+         * @param data -> The array.
+         * @param i -> The index of the first value.
+         * @param j -> The index of the second value.
          */
-        static void sortArray(float* data, int length);
+        static void swapValues(float* data, int i, int j);
 
         /**
          * @brief Function to round a given value with given precision
@@ -0,0 +1,180 @@
+/**
+ * @file fixedFft.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the in place radix-2 FFT on Q15 numbers.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "fixedFft.h"
+
+using namespace calcModule;
+
+// sin(2 pi i / FFT_MAX_POINTS) in Q15 for the first quarter, i = 0..64
+static const int16_t sineTable[FFT_MAX_POINTS / 4 + 1] PROGMEM = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+
+bool FixedFft::transform(int16_t* data, uint16_t n)
+{
+    if (n < 2 || n > FFT_MAX_POINTS / 2 || (n & (n - 1)) != 0)
+    {
+        return false;
+    }
+
+    // bit reversed order
+    for (uint16_t i = 1, j = 0; i < n; i++)
+    {
+        uint16_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j)
+        {
+            int16_t temp = data[2 * i];
+            data[2 * i] = data[2 * j];
+            data[2 * j] = temp;
+            temp = data[2 * i + 1];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j + 1] = temp;
+        }
+    }
+
+    for (uint16_t half = 1; half < n; half <<= 1)
+    {
+        uint8_t step = FFT_MAX_POINTS / (2 * half);
+        for (uint16_t m = 0; m < half; m++)
+        {
+            // W = cos - j sin of 2 pi m / (2 half)
+            uint8_t angle = m * step;
+            int16_t wr = sine(angle + FFT_MAX_POINTS / 4);
+            int16_t wi = -sine(angle);
+            for (uint16_t i = m; i < n; i += 2 * half)
+            {
+                int16_t* a = &data[2 * i];
+                int16_t* b = &data[2 * (i + half)];
+                int16_t tr = (static_cast<int32_t>(wr) * b[0] - static_cast<int32_t>(wi) * b[1]) >> 16;
+                int16_t ti = (static_cast<int32_t>(wr) * b[1] + static_cast<int32_t>(wi) * b[0]) >> 16;
+                int16_t ar = a[0] >> 1;
+                int16_t ai = a[1] >> 1;
+                b[0] = ar - tr;
+                b[1] = ai - ti;
+                a[0] = ar + tr;
+                a[1] = ai + ti;
+            }
+        }
+    }
+    return true;
+}
+
+bool FixedFft::transformReal(int16_t* data, uint16_t n)
+{
+    if (!isValidSize(n))
+    {
+        return false;
+    }
+
+    // even samples as real, odd ones as imaginary part: Z = FFT(x[2i] + j x[2i+1]) / (n / 2)
+    uint16_t half = n / 2;
+    transform(data, half);
+
+    // X[k] = E[k] + W^k O[k], X[half - k] = conj(E[k] - W^k O[k]) with
+    // E[k] = (Z[k] + conj Z[half - k]) / 2 and O[k] = (Z[k] - conj Z[half - k]) / 2j
+    int16_t z0r = data[0];
+    int16_t z0i = data[1];
+    data[0] = (static_cast<int32_t>(z0r) + z0i) >> 1;
+    data[1] = (static_cast<int32_t>(z0r) - z0i) >> 1;
+
+    uint8_t step = FFT_MAX_POINTS / n;
+    for (uint16_t k = 1; k <= half / 2; k++)
+    {
+        int16_t* a = &data[2 * k];
+        int16_t* b = &data[2 * (half - k)];
+        // twice E and O
+        int32_t er = static_cast<int32_t>(a[0]) + b[0];
+        int32_t ei = static_cast<int32_t>(a[1]) - b[1];
+        int32_t orr = static_cast<int32_t>(a[1]) + b[1];
+        int32_t oi = static_cast<int32_t>(b[0]) - a[0];
+
+        uint8_t angle = k * step;
+        int32_t c = sine(angle + FFT_MAX_POINTS / 4);
+        int32_t s = sine(angle);
+        // W^k O with W^k = c - j s, still twice
+        int32_t tr = ((c * orr) >> 15) + ((s * oi) >> 15);
+        int32_t ti = ((c * oi) >> 15) - ((s * orr) >> 15);
+
+        a[0] = (er + tr) >> 2;
+        a[1] = (ei + ti) >> 2;
+        b[0] = (er - tr) >> 2;
+        b[1] = (ti - ei) >> 2;
+    }
+    return true;
+}
+
+void FixedFft::applyHann(int16_t* data, uint16_t n)
+{
+    if (!isValidSize(n))
+    {
+        return;
+    }
+
+    // w[i] = (1 - cos(2 pi i / n)) / 2
+    uint8_t step = FFT_MAX_POINTS / n;
+    for (uint16_t i = 0; i < n; i++)
+    {
+        int16_t weight = (32767 - sine(static_cast<uint8_t>(i * step) + FFT_MAX_POINTS / 4)) >> 1;
+        data[i] = multiply(data[i], weight);
+    }
+}
+
+uint32_t FixedFft::power(const int16_t* data, uint16_t n, uint16_t bin)
+{
+    int32_t re;
+    int32_t im;
+    if (bin == 0)
+    {
+        re = data[0];
+        im = 0;
+    }
+    else if (bin >= n / 2)
+    {
+        re = data[1];
+        im = 0;
+    }
+    else
+    {
+        re = data[2 * bin];
+        im = data[2 * bin + 1];
+    }
+    return static_cast<uint32_t>(re * re) + static_cast<uint32_t>(im * im);
+}
+
+bool FixedFft::isValidSize(uint16_t n)
+{
+    return n >= FFT_MIN_POINTS && n <= FFT_MAX_POINTS && (n & (n - 1)) == 0;
+}
+
+int16_t FixedFft::sine(uint8_t index)
+{
+    // the table covers 0..pi/2, the other quadrants mirror it
+    uint8_t quadrant = index >> 6;
+    uint8_t offset = index & 0x3F;
+    if (quadrant & 1)
+    {
+        offset = 64 - offset;
+    }
+    int16_t value = pgm_read_word(&sineTable[offset]);
+    return (quadrant & 2) ? -value : value;
+}
+
+int16_t FixedFft::multiply(int16_t a, int16_t b)
+{
+    return (static_cast<int32_t>(a) * b) >> 15;
+}
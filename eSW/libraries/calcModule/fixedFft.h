@@ -0,0 +1,89 @@
+/**
+ * @file fixedFft.h
+ * @author Adrian Goessl
+ * @brief Header file for the in place radix-2 FFT on Q15 numbers.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef FIXEDFFT_H
+#define FIXEDFFT_H
+
+#include <Arduino.h>
+
+#define FFT_MAX_POINTS 256      // resolution of the sine table
+#define FFT_MIN_POINTS 8
+
+/// @brief Namespace for the calculation module. \namespace calcModule
+namespace calcModule
+{
+    /// @brief Class for the discrete Fourier transform of Q15 data without FPU. \class FixedFft
+    /// Decimation in time with one bit reversal pass, the twiddle factors come from a quarter
+    /// wave sine table in flash. Every stage halves its results, the output is the transform
+    /// divided by the number of points and never overflows, 16 x 16 -> 32 bit multiplies only.
+    /// A real signal of n points is transformed as n / 2 complex points and split afterwards,
+    /// half the time and no imaginary buffer.
+    class FixedFft
+    {
+    public:
+
+        /**
+         * @brief Function to transform complex data in place.
+         *
+         * @param data -> n complex numbers interleaved, real and imaginary part, Q15.
+         * @param n -> The number of points, a power of two, 2..FFT_MAX_POINTS / 2.
+         * @return true -> if transformed, data holds X[k] / n in natural order
+         * @return false -> if n is invalid
+         */
+        static bool transform(int16_t* data, uint16_t n);
+
+        /**
+         * @brief Function to transform real data in place.
+         *
+         * @param data -> n real samples, Q15.
+         * @param n -> The number of points, a power of two, FFT_MIN_POINTS..FFT_MAX_POINTS.
+         * @return true -> if transformed, data holds the bins 0..n/2-1 of X[k] / n interleaved,
+         *         the real bin n/2 in place of the imaginary part of bin 0
+         * @return false -> if n is invalid
+         */
+        static bool transformReal(int16_t* data, uint16_t n);
+
+        /**
+         * @brief Function to apply a Hann window, against the leakage of tones between two bins.
+         * The amplitude of a tone drops to half, its power spreads over 1.5 bins.
+         *
+         * @param data -> n real samples, Q15.
+         * @param n -> The number of points, a power of two, FFT_MIN_POINTS..FFT_MAX_POINTS.
+         */
+        static void applyHann(int16_t* data, uint16_t n);
+
+        /**
+         * @brief Function to get the squared magnitude of a bin of transformReal().
+         *
+         * @param data -> The transformed data.
+         * @param n -> The number of points of the transform.
+         * @param bin -> The bin, 0..n/2.
+         * @return uint32_t -> re^2 + im^2 in Q30.
+         */
+        static uint32_t power(const int16_t* data, uint16_t n, uint16_t bin);
+
+        /**
+         * @brief Function to check a number of points.
+         *
+         * @param n -> The number of points of a real transform.
+         * @return true -> if it is a power of two within FFT_MIN_POINTS..FFT_MAX_POINTS
+         * @return false -> if not
+         */
+        static bool isValidSize(uint16_t n);
+
+    private:
+        FixedFft() = delete;
+
+        static int16_t sine(uint8_t index);
+        static int16_t multiply(int16_t a, int16_t b);
+    };
+}
+
+#endif // FIXEDFFT_H
@@ -0,0 +1,163 @@
+/**
+ * @file fixedPoint.h
+ * @author Adrian Goessl
+ * @brief Signed 32 bit fixed point numbers for the conversion hot paths, no FPU on the AVR.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <Arduino.h>
+
+/// @brief Namespace for the calculation module. \namespace calcModule
+namespace calcModule
+{
+    /**
+     * @brief Signed fixed point number, FRAC fractional bits in an int32_t. \class Fixed
+     *
+     * Constants are built from a float literal at compile time (constexpr), a conversion then
+     * uses integer multiplies only, no float and no division. Products of two Fixed use a
+     * 32 x 32 -> 64 bit multiply, scale() multiplies an integer, e.g. an ADC count, with a
+     * 32 bit product: the caller picks FRAC so that count * factor stays below 2^31. The value range is
+     * +-2^(31 - FRAC), the resolution 2^-FRAC. Nothing saturates, toFloat() is meant for the
+     * presentation boundary.
+     *
+     * @tparam FRAC -> The number of fractional bits, 1..30.
+     */
+    template <uint8_t FRAC>
+    class Fixed
+    {
+        static_assert(FRAC > 0 && FRAC < 31, "Fixed needs 1..30 fractional bits");
+
+    public:
+        static constexpr int32_t one = static_cast<int32_t>(1) << FRAC;
+
+        constexpr Fixed() : _raw(0) {}
+
+        /**
+         * @brief Constructor for compile time constants, rounds to the nearest step.
+         *
+         * @param value -> The value, must be inside the range.
+         */
+        constexpr explicit Fixed(double value)
+            : _raw(static_cast<int32_t>(value * one + (value < 0 ? -0.5 : 0.5)))
+        {
+        }
+
+        /**
+         * @brief Function to build a number from its raw representation.
+         *
+         * @param raw -> The value times 2^FRAC.
+         * @return Fixed -> The number.
+         */
+        static constexpr Fixed fromRaw(int32_t raw)
+        {
+            return Fixed(raw, RawTag());
+        }
+
+        /**
+         * @brief Function to build a number from an integer.
+         *
+         * @param value -> The integer, must be inside the range.
+         * @return Fixed -> The number.
+         */
+        static constexpr Fixed fromInt(int32_t value)
+        {
+            return Fixed(value * one, RawTag());
+        }
+
+        /**
+         * @brief Function to multiply an integer with a factor, one 32 bit multiply.
+         *
+         * @param value -> The integer, |value * factor.raw()| must stay below 2^31.
+         * @param factor -> The factor.
+         * @return Fixed -> The product.
+         */
+        static constexpr Fixed scale(int32_t value, Fixed factor)
+        {
+            return Fixed(value * factor._raw, RawTag());
+        }
+
+        constexpr int32_t raw() const { return _raw; }
+
+        /**
+         * @brief Function to get the integer part, rounds towards minus infinity.
+         *
+         * @return int32_t -> The integer part.
+         */
+        constexpr int32_t toInt() const { return _raw >> FRAC; }
+
+        /**
+         * @brief Function to get the value as float, one conversion and one multiply.
+         *
+         * @return float -> The value.
+         */
+        float toFloat() const { return static_cast<float>(_raw) * (1.0f / one); }
+
+        /**
+         * @brief Function to change the number of fractional bits, truncates when it drops bits.
+         *
+         * @tparam TO -> The fractional bits of the result.
+         * @return Fixed<TO> -> The number, must be inside the new range.
+         */
+        template <uint8_t TO>
+        Fixed<TO> convert() const
+        {
+            return Fixed<TO>::fromRaw((TO >= FRAC) ? _raw * (static_cast<int32_t>(1) << (TO >= FRAC ? TO - FRAC : 0))
+                                                   : _raw >> (TO >= FRAC ? 0 : FRAC - TO));
+        }
+
+        Fixed operator+(Fixed other) const { return fromRaw(_raw + other._raw); }
+        Fixed operator-(Fixed other) const { return fromRaw(_raw - other._raw); }
+        Fixed operator-() const { return fromRaw(-_raw); }
+        Fixed operator*(int32_t value) const { return fromRaw(_raw * value); }
+        Fixed& operator+=(Fixed other) { _raw += other._raw; return *this; }
+        Fixed& operator-=(Fixed other) { _raw -= other._raw; return *this; }
+
+        Fixed operator*(Fixed other) const
+        {
+            return fromRaw(static_cast<int32_t>((static_cast<int64_t>(_raw) * other._raw) >> FRAC));
+        }
+
+        /**
+         * @brief Function to multiply with a number of another format, one rounding step.
+         *
+         * @tparam TO -> The fractional bits of the product, this format by default.
+         * @tparam OTHER -> The fractional bits of the factor.
+         * @param other -> The factor.
+         * @return Fixed<TO> -> The product, must be inside the range of TO.
+         */
+        template <uint8_t TO = FRAC, uint8_t OTHER>
+        Fixed<TO> multiply(Fixed<OTHER> other) const
+        {
+            static_assert(FRAC + OTHER >= TO, "Fixed::multiply would need more fractional bits");
+            return Fixed<TO>::fromRaw(static_cast<int32_t>((static_cast<int64_t>(_raw) * other.raw()) >> (FRAC + OTHER - TO)));
+        }
+
+        bool operator==(Fixed other) const { return _raw == other._raw; }
+        bool operator!=(Fixed other) const { return _raw != other._raw; }
+        bool operator<(Fixed other) const { return _raw < other._raw; }
+        bool operator>(Fixed other) const { return _raw > other._raw; }
+        bool operator<=(Fixed other) const { return _raw <= other._raw; }
+        bool operator>=(Fixed other) const { return _raw >= other._raw; }
+
+    private:
+        struct RawTag {};
+
+        constexpr Fixed(int32_t raw, RawTag) : _raw(raw) {}
+
+        int32_t _raw;
+    };
+
+    /// @brief Range +-32768, resolution 15 ppm of a unit, ADC derived quantities.
+    typedef Fixed<16> Q16_16;
+
+    /// @brief Range +-128, resolution 0.06 ppm of a unit, ratios and unit factors.
+    typedef Fixed<24> Q8_24;
+}
+
+#endif // FIXEDPOINT_H
@@ -0,0 +1,199 @@
+/**
+ * @file quantity.h
+ * @author Adrian Goessl
+ * @brief Unit tagged physical quantities, conversions are folded at compile time.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef QUANTITY_H
+#define QUANTITY_H
+
+#include <Arduino.h>
+
+/// @brief Namespace for the calculation module. \namespace calcModule
+namespace calcModule
+{
+    /// @brief Namespace for the units and dimensions of Quantity. \namespace units
+    /// A unit is a tag with its dimension and the affine map to the base unit of the dimension,
+    /// base = value * scale() + offset(). Only the temperatures have an offset.
+    namespace units
+    {
+        struct PressureDimension {};
+        struct TemperatureDimension {};
+        struct VoltageDimension {};
+        struct CurrentDimension {};
+        struct PowerDimension {};
+
+        /// @brief Base for the units without offset, FACTOR_NUM / FACTOR_DEN of the base unit. \struct LinearUnit
+        template <typename DIMENSION, long FACTOR_NUM, long FACTOR_DEN = 1>
+        struct LinearUnit
+        {
+            typedef DIMENSION Dimension;
+            static constexpr double scale() { return static_cast<double>(FACTOR_NUM) / FACTOR_DEN; }
+            static constexpr double offset() { return 0.0; }
+            static constexpr bool hasOffset() { return false; }
+        };
+
+        struct Pascal : LinearUnit<PressureDimension, 1> {};
+        struct Millibar : LinearUnit<PressureDimension, 100> {};
+        struct Bar : LinearUnit<PressureDimension, 100000> {};
+        struct Atmosphere : LinearUnit<PressureDimension, 101325> {};
+        struct Psi : LinearUnit<PressureDimension, 689475729, 100000> {};
+
+        struct Volt : LinearUnit<VoltageDimension, 1> {};
+        struct Millivolt : LinearUnit<VoltageDimension, 1, 1000> {};
+        struct Kilovolt : LinearUnit<VoltageDimension, 1000> {};
+
+        struct Ampere : LinearUnit<CurrentDimension, 1> {};
+        struct Milliampere : LinearUnit<CurrentDimension, 1, 1000> {};
+        struct Microampere : LinearUnit<CurrentDimension, 1, 1000000> {};
+
+        struct Watt : LinearUnit<PowerDimension, 1> {};
+        struct Milliwatt : LinearUnit<PowerDimension, 1, 1000> {};
+
+        struct Kelvin : LinearUnit<TemperatureDimension, 1> {};
+
+        /// @brief Degree Celsius, K = C + 273.15. \struct Celsius
+        struct Celsius
+        {
+            typedef TemperatureDimension Dimension;
+            static constexpr double scale() { return 1.0; }
+            static constexpr double offset() { return 273.15; }
+            static constexpr bool hasOffset() { return true; }
+        };
+
+        /// @brief Degree Fahrenheit, K = (F + 459.67) * 5 / 9. \struct Fahrenheit
+        struct Fahrenheit
+        {
+            typedef TemperatureDimension Dimension;
+            static constexpr double scale() { return 5.0 / 9.0; }
+            static constexpr double offset() { return 459.67 * 5.0 / 9.0; }
+            static constexpr bool hasOffset() { return true; }
+        };
+
+        template <typename A, typename B> struct SameDimension { static constexpr bool value = false; };
+        template <typename A> struct SameDimension<A, A> { static constexpr bool value = true; };
+    }
+
+    /**
+     * @brief A float tagged with its unit. \class Quantity
+     *
+     * Same size and code as a bare float, every member is inline and constexpr. Values of
+     * different units do not mix: adding Pressure<Pascal> to Pressure<Millibar> or assigning
+     * one to the other does not compile, to<>() converts explicitly with one multiply (and one
+     * add for the temperatures) whose constants the compiler folds. Converting between
+     * dimensions fails a static_assert.
+     *
+     * @tparam UNIT -> The unit tag, see calcModule::units.
+     */
+    template <typename UNIT>
+    class Quantity
+    {
+    public:
+        typedef UNIT Unit;
+        typedef typename UNIT::Dimension Dimension;
+
+        constexpr Quantity() : _value(0.0f) {}
+        constexpr explicit Quantity(float value) : _value(value) {}
+
+        /**
+         * @brief Getter for the number in this unit, for the presentation boundary.
+         *
+         * @return float -> The value.
+         */
+        constexpr float value() const { return _value; }
+
+        /**
+         * @brief Function to convert to another unit of the same dimension.
+         *
+         * @tparam TO -> The unit of the result.
+         * @return Quantity<TO> -> The converted quantity.
+         */
+        template <typename TO>
+        constexpr Quantity<TO> to() const
+        {
+            static_assert(units::SameDimension<Dimension, typename TO::Dimension>::value,
+                          "Quantity::to() between different dimensions");
+            // factor and offset are rounded to float once, the multiply stays single precision
+            return Quantity<TO>((UNIT::hasOffset() || TO::hasOffset())
+                ? _value * static_cast<float>(UNIT::scale() / TO::scale())
+                    + static_cast<float>((UNIT::offset() - TO::offset()) / TO::scale())
+                : _value * static_cast<float>(UNIT::scale() / TO::scale()));
+        }
+
+        constexpr Quantity operator+(Quantity other) const { return Quantity(_value + other._value); }
+        constexpr Quantity operator-(Quantity other) const { return Quantity(_value - other._value); }
+        constexpr Quantity operator-() const { return Quantity(-_value); }
+        constexpr Quantity operator*(float factor) const { return Quantity(_value * factor); }
+        constexpr Quantity operator/(float divisor) const { return Quantity(_value / divisor); }
+        constexpr float operator/(Quantity other) const { return _value / other._value; }
+        Quantity& operator+=(Quantity other) { _value += other._value; return *this; }
+        Quantity& operator-=(Quantity other) { _value -= other._value; return *this; }
+
+        constexpr bool operator==(Quantity other) const { return _value == other._value; }
+        constexpr bool operator!=(Quantity other) const { return _value != other._value; }
+        constexpr bool operator<(Quantity other) const { return _value < other._value; }
+        constexpr bool operator>(Quantity other) const { return _value > other._value; }
+        constexpr bool operator<=(Quantity other) const { return _value <= other._value; }
+        constexpr bool operator>=(Quantity other) const { return _value >= other._value; }
+
+    private:
+        float _value;
+    };
+
+    template <typename UNIT>
+    constexpr Quantity<UNIT> operator*(float factor, Quantity<UNIT> quantity)
+    {
+        return quantity * factor;
+    }
+
+    /**
+     * @brief Function to get the unit symbol used in the JSON responses.
+     *
+     * @tparam UNIT -> The unit tag.
+     * @return const char* -> The symbol.
+     */
+    template <typename UNIT> const char* unitSymbol();
+    template <> inline const char* unitSymbol<units::Pascal>() { return "Pa"; }
+    template <> inline const char* unitSymbol<units::Millibar>() { return "mbar"; }
+    template <> inline const char* unitSymbol<units::Bar>() { return "bar"; }
+    template <> inline const char* unitSymbol<units::Atmosphere>() { return "atm"; }
+    template <> inline const char* unitSymbol<units::Psi>() { return "psi"; }
+    template <> inline const char* unitSymbol<units::Volt>() { return "V"; }
+    template <> inline const char* unitSymbol<units::Millivolt>() { return "mV"; }
+    template <> inline const char* unitSymbol<units::Kilovolt>() { return "kV"; }
+    template <> inline const char* unitSymbol<units::Ampere>() { return "A"; }
+    template <> inline const char* unitSymbol<units::Milliampere>() { return "mA"; }
+    template <> inline const char* unitSymbol<units::Microampere>() { return "uA"; }
+    template <> inline const char* unitSymbol<units::Watt>() { return "W"; }
+    template <> inline const char* unitSymbol<units::Milliwatt>() { return "mW"; }
+    template <> inline const char* unitSymbol<units::Kelvin>() { return "K"; }
+    template <> inline const char* unitSymbol<units::Celsius>() { return "C"; }
+    template <> inline const char* unitSymbol<units::Fahrenheit>() { return "F"; }
+
+    template <typename UNIT>
+    inline const char* unitSymbol(Quantity<UNIT>)
+    {
+        return unitSymbol<UNIT>();
+    }
+
+    /// @brief Quantity<UNIT> after checking that UNIT measures DIMENSION. \struct QuantityOf
+    template <typename DIMENSION, typename UNIT>
+    struct QuantityOf
+    {
+        static_assert(units::SameDimension<DIMENSION, typename UNIT::Dimension>::value,
+                      "unit of another dimension");
+        typedef Quantity<UNIT> type;
+    };
+
+    template <typename UNIT> using Pressure = typename QuantityOf<units::PressureDimension, UNIT>::type;
+    template <typename UNIT> using Temperature = typename QuantityOf<units::TemperatureDimension, UNIT>::type;
+    template <typename UNIT> using Voltage = typename QuantityOf<units::VoltageDimension, UNIT>::type;
+    template <typename UNIT> using Current = typename QuantityOf<units::CurrentDimension, UNIT>::type;
+    template <typename UNIT> using Power = typename QuantityOf<units::PowerDimension, UNIT>::type;
+}
+
+#endif // QUANTITY_H
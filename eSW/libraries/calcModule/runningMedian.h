@@ -0,0 +1,194 @@
+/**
+ * @file runningMedian.h
+ * @author Adrian Goessl
+ * @brief Sliding window median filter, O(log n) per sample.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef RUNNINGMEDIAN_H
+#define RUNNINGMEDIAN_H
+
+#include <Arduino.h>
+
+/// @brief Namespace for the calculation module. \namespace calcModule
+namespace calcModule
+{
+    /**
+     * @brief Median of the last N samples, spike rejection for noisy channels.
+     *
+     * The window is a ring buffer, a max heap of the lower half and a min heap of the upper
+     * half share one index array with the median at position 0 (negative positions for the
+     * max heap). A new sample replaces the oldest one in place and sifts up or down its heap,
+     * O(log N) compares, no allocation. A spike shorter than N / 2 samples never reaches the
+     * output, a step is delayed by N / 2 samples.
+     *
+     * @tparam T -> The sample type, needs operator<.
+     * @tparam N -> The window, odd sizes give a sample of the window, at most 127.
+     */
+    template <typename T, uint8_t N>
+    class RunningMedian
+    {
+        static_assert(N > 0 && N < 128, "RunningMedian window must be 1..127");
+
+    public:
+        RunningMedian()
+        {
+            reset();
+        }
+
+        /**
+         * @brief Function to empty the window.
+         */
+        void reset()
+        {
+            _index = 0;
+            _count = 0;
+            _heap = _heapStorage + N / 2;
+
+            // fill pattern median, max heap, min heap, max heap, ...
+            for (int8_t i = N - 1; i >= 0; i--)
+            {
+                _positions[i] = ((i + 1) / 2) * ((i & 1) ? -1 : 1);
+                _heap[_positions[i]] = i;
+            }
+        }
+
+        /**
+         * @brief Function to add a sample, replaces the oldest one when the window is full.
+         *
+         * @param value -> The sample, must be comparable (no NAN).
+         * @return T -> The median after the sample.
+         */
+        T add(T value)
+        {
+            bool isNew = _count < N;
+            int8_t position = _positions[_index];
+            T old = _data[_index];
+            _data[_index] = value;
+            _index = (_index + 1) % N;
+            if (isNew)
+            {
+                _count++;
+            }
+
+            if (position > 0)
+            {
+                // in the min heap
+                if (!isNew && old < value) minSortDown(position * 2);
+                else if (minSortUp(position)) maxSortDown(-1);
+            }
+            else if (position < 0)
+            {
+                // in the max heap
+                if (!isNew && value < old) maxSortDown(position * 2);
+                else if (maxSortUp(position)) minSortDown(1);
+            }
+            else
+            {
+                // at the median
+                if (maxCount()) maxSortDown(-1);
+                if (minCount()) minSortDown(1);
+            }
+            return getMedian();
+        }
+
+        /**
+         * @brief Getter for the median of the window.
+         *
+         * @return T -> The median, the mean of the two middle samples for an even count, T() if empty.
+         */
+        T getMedian() const
+        {
+            if (_count == 0)
+            {
+                return T();
+            }
+
+            T median = _data[_heap[0]];
+            if ((_count & 1) == 0)
+            {
+                median = (median + _data[_heap[-1]]) / 2;
+            }
+            return median;
+        }
+
+        /**
+         * @brief Getter for the number of samples in the window.
+         *
+         * @return uint8_t -> The count, N once the window is full.
+         */
+        uint8_t getCount() const
+        {
+            return _count;
+        }
+
+    private:
+        T _data[N];                 // ring buffer of the window
+        int8_t _positions[N];       // heap position of every sample
+        int8_t _heapStorage[N];     // indices into _data
+        int8_t* _heap;              // _heapStorage + N / 2, median at 0
+        uint8_t _index;             // next sample to replace
+        uint8_t _count;
+
+        int8_t minCount() const { return (_count - 1) / 2; }
+        int8_t maxCount() const { return _count / 2; }
+
+        bool less(int8_t i, int8_t j) const
+        {
+            return _data[_heap[i]] < _data[_heap[j]];
+        }
+
+        bool exchange(int8_t i, int8_t j)
+        {
+            int8_t temp = _heap[i];
+            _heap[i] = _heap[j];
+            _heap[j] = temp;
+            _positions[_heap[i]] = i;
+            _positions[_heap[j]] = j;
+            return true;
+        }
+
+        bool compareExchange(int8_t i, int8_t j)
+        {
+            return less(i, j) && exchange(i, j);
+        }
+
+        void minSortDown(int8_t i)
+        {
+            for (; i <= minCount(); i *= 2)
+            {
+                if (i > 1 && i < minCount() && less(i + 1, i)) ++i;
+                if (!compareExchange(i, i / 2)) break;
+            }
+        }
+
+        void maxSortDown(int8_t i)
+        {
+            for (; i >= -maxCount(); i *= 2)
+            {
+                if (i < -1 && i > -maxCount() && less(i, i - 1)) --i;
+                if (!compareExchange(i / 2, i)) break;
+            }
+        }
+
+        bool minSortUp(int8_t i)
+        {
+            while (i > 0 && compareExchange(i, i / 2)) i /= 2;
+            return i == 0;
+        }
+
+        bool maxSortUp(int8_t i)
+        {
+            while (i < 0 && compareExchange(i / 2, i)) i /= 2;
+            return i == 0;
+        }
+
+        RunningMedian(const RunningMedian&) = delete;
+        RunningMedian& operator=(const RunningMedian&) = delete;
+    };
+}
+
+#endif // RUNNINGMEDIAN_H
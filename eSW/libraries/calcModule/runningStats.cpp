@@ -0,0 +1,206 @@
+/**
+ * @file runningStats.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the streaming statistics of a signal.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "runningStats.h"
+#include <math.h>
+
+using namespace calcModule;
+
+RunningStats::RunningStats()
+{
+    reset();
+}
+
+void RunningStats::reset()
+{
+    _count = 0;
+    _mean = 0.0f;
+    _m2 = 0.0f;
+    _min = NAN;
+    _max = NAN;
+}
+
+void RunningStats::add(float value)
+{
+    if (isnan(value))
+    {
+        return;
+    }
+
+    _count++;
+    float delta = value - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (value - _mean);
+
+    if (_count == 1 || value < _min) _min = value;
+    if (_count == 1 || value > _max) _max = value;
+}
+
+uint32_t RunningStats::getCount() const
+{
+    return _count;
+}
+
+float RunningStats::getMean() const
+{
+    return (_count > 0) ? _mean : NAN;
+}
+
+float RunningStats::getVariance() const
+{
+    return (_count > 0) ? _m2 / _count : NAN;
+}
+
+float RunningStats::getStandardDeviation() const
+{
+    return (_count > 0) ? sqrtf(_m2 / _count) : NAN;
+}
+
+float RunningStats::getMin() const
+{
+    return _min;
+}
+
+float RunningStats::getMax() const
+{
+    return _max;
+}
+
+P2Quantile::P2Quantile(float quantile)
+    : _quantile(constrain(quantile, 0.0f, 1.0f))
+{
+    reset();
+}
+
+void P2Quantile::reset()
+{
+    _count = 0;
+}
+
+void P2Quantile::add(float value)
+{
+    if (isnan(value))
+    {
+        return;
+    }
+
+    // the first five samples are kept sorted, they become the markers
+    if (_count < markers)
+    {
+        uint8_t i = _count;
+        while (i > 0 && _heights[i - 1] > value)
+        {
+            _heights[i] = _heights[i - 1];
+            i--;
+        }
+        _heights[i] = value;
+        _count++;
+        for (uint8_t m = 0; m < markers; m++)
+        {
+            _positions[m] = m + 1;
+        }
+        return;
+    }
+
+    // cell of the sample, the extreme markers follow min and max
+    uint8_t cell;
+    if (value < _heights[0])
+    {
+        _heights[0] = value;
+        cell = 0;
+    }
+    else if (value >= _heights[markers - 1])
+    {
+        _heights[markers - 1] = value;
+        cell = markers - 2;
+    }
+    else
+    {
+        cell = 0;
+        while (value >= _heights[cell + 1])
+        {
+            cell++;
+        }
+    }
+
+    for (uint8_t m = cell + 1; m < markers; m++)
+    {
+        _positions[m]++;
+    }
+    _count++;
+
+    // move the middle markers towards their desired positions by one
+    for (uint8_t m = 1; m < markers - 1; m++)
+    {
+        float offset = desiredPosition(m) - _positions[m];
+        int32_t toNext = static_cast<int32_t>(_positions[m + 1] - _positions[m]);
+        int32_t toPrevious = static_cast<int32_t>(_positions[m - 1]) - static_cast<int32_t>(_positions[m]);
+        if ((offset >= 1.0f && toNext > 1) || (offset <= -1.0f && toPrevious < -1))
+        {
+            int8_t direction = (offset > 0.0f) ? 1 : -1;
+            float height = parabolic(m, direction);
+            if (height <= _heights[m - 1] || height >= _heights[m + 1])
+            {
+                // parabola leaves the neighbours, linear instead
+                uint8_t neighbour = m + direction;
+                height = _heights[m] + direction * (_heights[neighbour] - _heights[m])
+                    / (static_cast<float>(_positions[neighbour]) - _positions[m]);
+            }
+            _heights[m] = height;
+            _positions[m] += direction;
+        }
+    }
+}
+
+float P2Quantile::getValue() const
+{
+    if (_count == 0)
+    {
+        return NAN;
+    }
+
+    if (_count < markers)
+    {
+        // exact, nearest rank of the sorted samples
+        uint8_t rank = static_cast<uint8_t>(_quantile * (_count - 1) + 0.5f);
+        return _heights[rank];
+    }
+    return _heights[2];
+}
+
+float P2Quantile::getQuantile() const
+{
+    return _quantile;
+}
+
+float P2Quantile::desiredPosition(uint8_t marker) const
+{
+    float increment;
+    switch (marker)
+    {
+        case 0: increment = 0.0f; break;
+        case 1: increment = _quantile * 0.5f; break;
+        case 2: increment = _quantile; break;
+        case 3: increment = (1.0f + _quantile) * 0.5f; break;
+        default: increment = 1.0f; break;
+    }
+    return 1.0f + (_count - 1) * increment;
+}
+
+float P2Quantile::parabolic(uint8_t marker, int8_t direction) const
+{
+    float n = _positions[marker];
+    float nPrevious = _positions[marker - 1];
+    float nNext = _positions[marker + 1];
+    float q = _heights[marker];
+
+    return q + direction / (nNext - nPrevious)
+        * ((n - nPrevious + direction) * (_heights[marker + 1] - q) / (nNext - n)
+         + (nNext - n - direction) * (q - _heights[marker - 1]) / (n - nPrevious));
+}
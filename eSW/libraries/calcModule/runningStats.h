@@ -0,0 +1,155 @@
+/**
+ * @file runningStats.h
+ * @author Adrian Goessl
+ * @brief Header file for the streaming statistics of a signal, constant memory per channel.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef RUNNINGSTATS_H
+#define RUNNINGSTATS_H
+
+#include <Arduino.h>
+
+/// @brief Namespace for the calculation module. \namespace calcModule
+namespace calcModule
+{
+    /// @brief Class for count, mean, variance, min and max of a stream in one pass. \class RunningStats
+    /// Welford's update, the variance does not suffer from the cancellation of sum(x^2) - n * mean^2.
+    class RunningStats
+    {
+    public:
+        RunningStats();
+
+        /**
+         * @brief Function to forget all samples.
+         */
+        void reset();
+
+        /**
+         * @brief Function to add a sample, O(1). NAN is ignored.
+         *
+         * @param value -> The sample.
+         */
+        void add(float value);
+
+        /**
+         * @brief Getter for the number of samples.
+         *
+         * @return uint32_t -> The count.
+         */
+        uint32_t getCount() const;
+
+        /**
+         * @brief Getter for the mean.
+         *
+         * @return float -> The mean, NAN without samples.
+         */
+        float getMean() const;
+
+        /**
+         * @brief Getter for the population variance, like calculateStandardDeviation().
+         *
+         * @return float -> The variance, NAN without samples.
+         */
+        float getVariance() const;
+
+        /**
+         * @brief Getter for the population standard deviation.
+         *
+         * @return float -> The standard deviation, NAN without samples.
+         */
+        float getStandardDeviation() const;
+
+        /**
+         * @brief Getter for the smallest sample.
+         *
+         * @return float -> The minimum, NAN without samples.
+         */
+        float getMin() const;
+
+        /**
+         * @brief Getter for the largest sample.
+         *
+         * @return float -> The maximum, NAN without samples.
+         */
+        float getMax() const;
+
+    private:
+        uint32_t _count;
+        float _mean;
+        float _m2;      // sum of squared differences from the current mean
+        float _min;
+        float _max;
+    };
+
+    /// @brief Class to estimate a quantile of a stream without storing it, P² algorithm (Jain, Chlamtac 1985). \class P2Quantile
+    /// Five markers follow the minimum, p/2, p, (1+p)/2 and the maximum, the middle ones are moved
+    /// by piecewise parabolic interpolation. Exact for the first five samples.
+    class P2Quantile
+    {
+    public:
+
+        /**
+         * @brief Constructor
+         *
+         * @param quantile -> The quantile to estimate, 0.5 for the median.
+         */
+        explicit P2Quantile(float quantile = 0.5f);
+
+        /**
+         * @brief Function to forget all samples, keeps the quantile.
+         */
+        void reset();
+
+        /**
+         * @brief Function to add a sample, O(1). NAN is ignored.
+         *
+         * @param value -> The sample.
+         */
+        void add(float value);
+
+        /**
+         * @brief Getter for the estimate.
+         *
+         * @return float -> The quantile, NAN without samples.
+         */
+        float getValue() const;
+
+        /**
+         * @brief Getter for the quantile that is estimated.
+         *
+         * @return float -> The quantile, 0..1.
+         */
+        float getQuantile() const;
+
+    private:
+        static const uint8_t markers = 5;
+
+        float _quantile;
+        uint32_t _count;
+        float _heights[markers];
+        uint32_t _positions[markers];
+
+        /**
+         * @brief Function to get the desired position of a marker, 1 + (count - 1) * increment.
+         *
+         * @param marker -> The marker, 0..4.
+         * @return float -> The desired position.
+         */
+        float desiredPosition(uint8_t marker) const;
+
+        /**
+         * @brief Function to get the piecewise parabolic prediction for moving a marker.
+         *
+         * @param marker -> The marker, 1..3.
+         * @param direction -> +1 or -1.
+         * @return float -> The new height.
+         */
+        float parabolic(uint8_t marker, int8_t direction) const;
+    };
+}
+
+#endif // RUNNINGSTATS_H
@@ -0,0 +1,129 @@
+/**
+ * @file swingingDoor.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the deadband and swinging door compression of a signal.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "swingingDoor.h"
+
+using namespace calcModule;
+
+SwingingDoor::SwingingDoor()
+{
+
+}
+
+void SwingingDoor::configure(float deadband, float deviation, uint32_t maxIntervalMs)
+{
+    _deadband = (deadband > 0.0f) ? deadband : 0.0f;
+    _deviation = (deviation > 0.0f) ? deviation : 0.0f;
+    _maxIntervalMs = (maxIntervalMs > 0) ? maxIntervalMs : 0xFFFFFFFF;
+    reset();
+}
+
+void SwingingDoor::reset()
+{
+    _started = false;
+    _hasHeld = false;
+}
+
+uint8_t SwingingDoor::add(uint32_t timeMs, float value, TrendPoint* archived)
+{
+    uint8_t count = 0;
+
+    // a gap ends the segment at the last passed sample
+    if (isnan(value))
+    {
+        if (_started)
+        {
+            if (_hasHeld)
+            {
+                archived[count++] = _held;
+            }
+            archived[count++] = { timeMs, NAN };
+            reset();
+        }
+        return count;
+    }
+
+    if (!_started)
+    {
+        _pivot = { timeMs, value };
+        archived[count++] = _pivot;
+        _reference = value;
+        _started = true;
+        _hasHeld = false;
+        return count;
+    }
+
+    uint32_t sincePivot = timeMs - _pivot.timeMs;
+    if (sincePivot == 0)
+    {
+        return 0;
+    }
+
+    // exception test against the last passed sample, a dropped sample gets deviation + deadband
+    bool dropped = _deadband > 0.0f && fabs(value - _reference) <= _deadband && sincePivot < _maxIntervalMs;
+    float tolerance = dropped ? _deviation + _deadband : _deviation;
+
+    float lower = (value - tolerance - _pivot.value) / sincePivot;
+    float upper = (value + tolerance - _pivot.value) / sincePivot;
+
+    if (_hasHeld)
+    {
+        float slopeMin = max(_slopeMin, lower);
+        float slopeMax = min(_slopeMax, upper);
+        if (slopeMin <= slopeMax && sincePivot < _maxIntervalMs)
+        {
+            _slopeMin = slopeMin;
+            _slopeMax = slopeMax;
+            hold(timeMs, value, dropped);
+            return 0;
+        }
+
+        // doors crossed, archive the previous sample on a line that fits all samples since the pivot
+        _pivot = onLine();
+        archived[count++] = _pivot;
+
+        sincePivot = timeMs - _pivot.timeMs;
+        lower = (value - tolerance - _pivot.value) / sincePivot;
+        upper = (value + tolerance - _pivot.value) / sincePivot;
+    }
+
+    _slopeMin = lower;
+    _slopeMax = upper;
+    hold(timeMs, value, dropped);
+    return count;
+}
+
+void SwingingDoor::hold(uint32_t timeMs, float value, bool dropped)
+{
+    _held = { timeMs, value };
+    _hasHeld = true;
+    if (!dropped)
+    {
+        _reference = value;
+    }
+}
+
+TrendPoint SwingingDoor::onLine() const
+{
+    uint32_t sincePivot = _held.timeMs - _pivot.timeMs;
+    float slope = (_held.value - _pivot.value) / sincePivot;
+    slope = constrain(slope, _slopeMin, _slopeMax);
+    return { _held.timeMs, _pivot.value + slope * sincePivot };
+}
+
+bool SwingingDoor::getHeld(TrendPoint& point) const
+{
+    if (!_started || !_hasHeld)
+    {
+        return false;
+    }
+
+    point = onLine();
+    return true;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file swingingDoor.h
+ * @author Adrian Goessl
+ * @brief Header file for the deadband and swinging door compression of a signal.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SWINGINGDOOR_H
+#define SWINGINGDOOR_H
+
+#include <Arduino.h>
+
+/// @brief Namespace for the calculation module. \namespace calcModule
+namespace calcModule
+{
+    /// @brief Structure for a point of a compressed signal. \struct TrendPoint
+    struct TrendPoint
+    {
+        uint32_t timeMs;    // monotonic, wraps after 49 days, only differences are used
+        float value;        // NAN marks the start of a gap
+    };
+
+    /// @brief Class to compress a signal to the points needed to reconstruct it by linear interpolation. \class SwingingDoor
+    /// Compression test: the samples since the last archived point (pivot) are kept as long as one
+    /// line through the pivot stays within the deviation of all of them, the slopes of the two
+    /// doors narrow with every sample. When they cross, the previous sample is archived on that
+    /// line and becomes the new pivot.
+    /// Exception test: a sample within the deadband of the last passed sample is dropped, it
+    /// narrows the doors by deviation + deadband only, so noise around a plateau does not
+    /// close them. The reconstruction error stays below deviation for passed samples and
+    /// below deadband + deviation for dropped ones.
+    class SwingingDoor
+    {
+    public:
+        SwingingDoor();
+
+        /**
+         * @brief Function to set the error bounds, restarts the compression.
+         *
+         * @param deadband -> The exception deviation, 0 passes every sample.
+         * @param deviation -> The compression deviation, 0 keeps every change of slope.
+         * @param maxIntervalMs -> The longest time without an archived point.
+         */
+        void configure(float deadband, float deviation, uint32_t maxIntervalMs);
+
+        /**
+         * @brief Function to restart, the next sample is archived.
+         */
+        void reset();
+
+        /**
+         * @brief Function to compress one sample.
+         *
+         * @param timeMs -> The capture time, later than the previous sample.
+         * @param value -> The value, NAN for a missing sample.
+         * @param archived -> Receives the points to store, room for two.
+         * @return uint8_t -> The number of points to store, 0..2.
+         */
+        uint8_t add(uint32_t timeMs, float value, TrendPoint* archived);
+
+        /**
+         * @brief Function to get the newest sample, the open end of the reconstruction.
+         *
+         * @param point -> The sample, on the line through the pivot that fits all samples since.
+         * @return true -> if there was a sample since the last archived point
+         * @return false -> if not
+         */
+        bool getHeld(TrendPoint& point) const;
+
+    private:
+        float _deadband = 0.0f;
+        float _deviation = 0.0f;
+        uint32_t _maxIntervalMs = 0xFFFFFFFF;
+
+        bool _started = false;
+        bool _hasHeld = false;
+        TrendPoint _pivot;      // last archived point
+        TrendPoint _held;       // last sample since the pivot
+        float _reference;       // value of the last sample that passed the exception test
+        float _slopeMin;        // per ms, lower door
+        float _slopeMax;        // per ms, upper door
+
+        /**
+         * @brief Function to keep a sample as the end of the current segment.
+         *
+         * @param timeMs -> The capture time.
+         * @param value -> The value.
+         * @param dropped -> true if the sample failed the exception test.
+         */
+        void hold(uint32_t timeMs, float value, bool dropped);
+
+        /**
+         * @brief Function to place the held sample on the line through the pivot that fits all samples since.
+         *
+         * @return TrendPoint -> The point on the line, the held sample itself if it fits.
+         */
+        TrendPoint onLine() const;
+    };
+}
+
+#endif // SWINGINGDOOR_H
@@ -2,10 +2,12 @@
  * @file EthernetCommunication.cpp
  * @brief Implementation of the Ethernet communication class.
  */
+#define LOG_SOURCE LogSource::COM
+
 #include "ETHH.h"
 #include <Ethernet.h>
 #include <Arduino.h>
-//#include <serialMenu.h>
+#include <serialMenu.h>
 
 using namespace comModule;
 
@@ -114,10 +116,7 @@ String EthernetCommunication::getRequestedEndpoint()
                     requestedEndpoint.trim();
                 }
 
-                client.println(F("HTTP/1.1 200 OK"));
-                client.println(F("Content-Type: application/json"));
-                client.println(F("Connection: close"));
-                client.println();
+                // the header follows with the response, its type depends on the endpoint
             }
         }
     }
@@ -128,42 +127,63 @@ String EthernetCommunication::getRequestedEndpoint()
 // TODO: CHECK THIS METHOD, CHECK THE ENDPOINT!!
 String EthernetCommunication::getSpecificEndpoint(const String& endpoint)
 {
-    if (!ethernetInitialized) return "";
+    return getSpecificEndpoint(endpoint, nullptr, nullptr);
+}
 
-    String response = "";
-    bool redirected = false;
-    String newLocation = "";
+String EthernetCommunication::getSpecificEndpoint(const String& endpoint, unsigned long* requestMillis, unsigned long* responseMillis)
+{
+    if (!ethernetInitialized) return "";
 
-    if (client.connect("192.168.1.1", 5000)) // Verbindung zu HAS
+    if (!connectHas())
     {
-        delay(100);
-        client.print("GET /" + endpoint + " HTTP/1.1\r\n");
-        client.print("Host: 192.168.1.1:5000\r\n");
-        client.print("Connection: close\r\n\r\n");
-        delay(100);
+        return "[ERROR] Connection Failed";
+    }
 
-        unsigned long timeout = millis();
-        while (client.available() == 0)
-        {
-            if (millis() - timeout > 5000)
-            {
-                client.stop();
-                return "[ERROR] Timeout";
-            }
-        }
+    delay(100);
+    sendHasRequest(endpoint, requestMillis);
 
-        while (client.available())
+    // No fixed delay here, the arrival time of the response is part of the time sync
+    unsigned long timeout = millis();
+    while (!isHasResponseAvailable())
+    {
+        if (millis() - timeout > HAS_RESPONSE_TIMEOUT_MS)
         {
-            char c = client.read();
-            response += c;
+            abortHasRequest();
+            return "[ERROR] Timeout";
         }
-
-        client.stop();
     }
-    else
+    if (responseMillis) *responseMillis = millis();
+
+    return readHasResponse();
+}
+
+bool EthernetCommunication::connectHas()
+{
+    return ethernetInitialized && hasClient.connect("192.168.1.1", 5000); // Verbindung zu HAS
+}
+
+void EthernetCommunication::sendHasRequest(const String& endpoint, unsigned long* requestMillis)
+{
+    if (requestMillis) *requestMillis = millis();
+    hasClient.print("GET /" + endpoint + " HTTP/1.1\r\n");
+    hasClient.print("Host: 192.168.1.1:5000\r\n");
+    hasClient.print("Connection: close\r\n\r\n");
+}
+
+bool EthernetCommunication::isHasResponseAvailable()
+{
+    return hasClient.available() > 0;
+}
+
+String EthernetCommunication::readHasResponse()
+{
+    String response = "";
+    while (hasClient.available())
     {
-        return "[ERROR] Connection Failed";
+        char c = hasClient.read();
+        response += c;
     }
+    hasClient.stop();
 
     // Extrahiere die eigentliche JSON-Antwort (nach den HTTP-Headern)
     int headerEnd = response.indexOf("\r\n\r\n");
@@ -175,17 +195,84 @@ String EthernetCommunication::getSpecificEndpoint(const String& endpoint)
     return response;
 }
 
+void EthernetCommunication::abortHasRequest()
+{
+    hasClient.stop();
+}
+
 void EthernetCommunication::sendJsonResponse(const String& jsonBody)
 {
     EthernetClient activeClient = getClient();
 
     if (activeClient && activeClient.connected())
     {
+        sendResponseHeader(F("application/json"), false);
         activeClient.println(jsonBody.c_str());
         activeClient.stop();
     }
 }
 
+void EthernetCommunication::beginChunkedResponse(const __FlashStringHelper* contentType)
+{
+    if (client && client.connected())
+    {
+        sendResponseHeader(contentType, true);
+    }
+}
+
+bool EthernetCommunication::sendChunk(const uint8_t* data, size_t length)
+{
+    if (!client || !client.connected())
+    {
+        return false;
+    }
+    if (length == 0)
+    {
+        return true;
+    }
+
+    client.print(static_cast<unsigned long>(length), HEX);
+    client.print(F("\r\n"));
+    bool written = client.write(data, length) == length;
+    client.print(F("\r\n"));
+    return written;
+}
+
+void EthernetCommunication::endChunkedResponse()
+{
+    if (client && client.connected())
+    {
+        client.print(F("0\r\n\r\n"));
+        client.stop();
+    }
+}
+
+void EthernetCommunication::sendErrorResponse(const __FlashStringHelper* status)
+{
+    if (client && client.connected())
+    {
+        client.print(F("HTTP/1.1 "));
+        client.println(status);
+        client.println(F("Content-Length: 0"));
+        client.println(F("Connection: close"));
+        client.println();
+        client.stop();
+    }
+}
+
+void EthernetCommunication::sendResponseHeader(const __FlashStringHelper* contentType, bool chunked)
+{
+    client.println(F("HTTP/1.1 200 OK"));
+    client.print(F("Content-Type: "));
+    client.println(contentType);
+    if (chunked)
+    {
+        client.println(F("Transfer-Encoding: chunked"));
+    }
+    client.println(F("Connection: close"));
+    client.println();
+}
+
 void EthernetCommunication::handleEthernetClient()
 {
     EthernetClient newClient = server.available();
@@ -496,20 +583,22 @@ Vector<float> EthernetCommunication::parseCompoundResponse(String response)
 {
     if (response.length() == 0)
     {
-    	Serial.println("[ERROR] No valid response received.");
+    	LOG_TOKEN(ERROR, ETH_NO_RESPONSE);
         return Vector<float>();
     }
 
     Vector<float> parsedResponse = parseResponse(response);
 
-    Serial.println("Parsed Values: ");
-
-    for (size_t i = 0; i < parsedResponse.size(); i++)
+    if (LOG_IS_ENABLED(DEBUG))
     {
-        Serial.print(parsedResponse[i], 6);
-        Serial.println(" ");
+        String values = "Parsed Values:";
+        for (size_t i = 0; i < parsedResponse.size(); i++)
+        {
+            values += ' ';
+            values += String(parsedResponse[i], 6);
+        }
+        LOG_DEBUG(values);
     }
-    Serial.print(" ");
 
     return parsedResponse;
 }
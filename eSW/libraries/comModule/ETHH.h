@@ -106,6 +106,8 @@ namespace comModule
 	class EthernetCommunication
 	{
 	public:
+		static const unsigned long HAS_RESPONSE_TIMEOUT_MS = 5000;
+
 		EthernetCommunication();
 		~EthernetCommunication();
 
@@ -154,6 +156,53 @@ namespace comModule
 		 */
 		String getSpecificEndpoint(const String& jsonBody);
 
+		/**
+		 * @brief Function to get the specific endpoint and timestamp the exchange, used for the NTP-style time sync
+		 *
+		 * @param endpoint -> The endpoint to request from the HAS
+		 * @param requestMillis -> millis() right before the request was sent
+		 * @param responseMillis -> millis() when the first byte of the response arrived
+		 * @return String -> The specific endpoint
+		 */
+		String getSpecificEndpoint(const String& endpoint, unsigned long* requestMillis, unsigned long* responseMillis);
+
+		/**
+		 * @brief Function to connect to the HAS, the first step of getSpecificEndpoint().
+		 * Every step is one W5100 access, a task that shares the bus holds it per step and waits without it.
+		 *
+		 * @return true -> if the connection to the HAS is open
+		 * @return false -> if the HAS could not be reached
+		 */
+		bool connectHas();
+
+		/**
+		 * @brief Function to send the GET request on the connection of connectHas().
+		 *
+		 * @param endpoint -> The endpoint to request from the HAS
+		 * @param requestMillis -> millis() right before the request was sent, may be nullptr
+		 */
+		void sendHasRequest(const String& endpoint, unsigned long* requestMillis);
+
+		/**
+		 * @brief Function to check if the response of the HAS started to arrive.
+		 *
+		 * @return true -> if bytes of the response are available
+		 * @return false -> if nothing arrived yet
+		 */
+		bool isHasResponseAvailable();
+
+		/**
+		 * @brief Function to read the response of the HAS and close the connection.
+		 *
+		 * @return String -> The body of the response without the HTTP headers
+		 */
+		String readHasResponse();
+
+		/**
+		 * @brief Function to close the connection to the HAS without reading the response, e.g. after a timeout.
+		 */
+		void abortHasRequest();
+
 		/**
 		 * @brief Function to send the json response with the measurment data
 		 *
@@ -161,6 +210,35 @@ namespace comModule
 		 */
 		void sendJsonResponse(const String& jsonBody);
 
+		/**
+		 * @brief Function to start a response of unknown length, the body follows with sendChunk()
+		 *
+		 * @param contentType -> The content type of the body
+		 */
+		void beginChunkedResponse(const __FlashStringHelper* contentType);
+
+		/**
+		 * @brief Function to send one chunk of a chunked response
+		 *
+		 * @param data -> The bytes to send
+		 * @param length -> The number of bytes, 0 is skipped as it would end the body
+		 * @return true -> if the chunk was sent
+		 * @return false -> if the client is gone
+		 */
+		bool sendChunk(const uint8_t* data, size_t length);
+
+		/**
+		 * @brief Function to end a chunked response and close the connection
+		 */
+		void endChunkedResponse();
+
+		/**
+		 * @brief Function to answer a request without body and close the connection
+		 *
+		 * @param status -> The status line after the HTTP version, e.g. F("404 Not Found")
+		 */
+		void sendErrorResponse(const __FlashStringHelper* status);
+
 		/**
 		 * @brief Get the currently active Ethernet client
 		 *
@@ -326,6 +404,7 @@ namespace comModule
 	private:
 		EthernetServer server;
 		EthernetClient client;
+		EthernetClient hasClient;   // own socket, client still carries the request that is being answered
 		bool ethernetInitialized = false;
 		bool sendDataFlag = false;
 
@@ -337,6 +416,14 @@ namespace comModule
 		 */
 		String floatToIEEE754(float value);
 
+		/**
+		 * @brief Sends the HTTP response header to the active client.
+		 *
+		 * @param contentType -> The content type of the body
+		 * @param chunked -> Whether the body uses chunked transfer encoding
+		 */
+		void sendResponseHeader(const __FlashStringHelper* contentType, bool chunked);
+
 		/**
 		 * @brief Parses the response and extracts IEEE-754 float values.
 		 *
@@ -8,6 +8,8 @@
 #include <Wire.h>
 #include <Arduino.h>
 #include <serialMenu.h>
+#include <ptrUtils.h>
+#include <util/atomic.h>
 
 using namespace comModule;
 
@@ -39,18 +41,150 @@ void SPICommunication::endSPI()
 	spiInitialized = false;
 }
 
-void SPICommunication::spiWrite(uint8_t* data, size_t length)
+void SPICommunication::spiWrite(const uint8_t* data, size_t length)
 {
-    for (size_t i = 0; i < length; ++i)
+    // the buffer transfer of the SPI library overwrites its input, so the data goes through a copy
+    uint8_t chunk[32];
+    while (length > 0)
     {
-        SPI.transfer(data[i]);
+        size_t count = (length < sizeof(chunk)) ? length : sizeof(chunk);
+        memcpy(chunk, data, count);
+        SPI.transfer(chunk, count);
+        data += count;
+        length -= count;
     }
 }
 
 void SPICommunication::spiRead(uint8_t* buffer, size_t length)
 {
-    for (size_t i = 0; i < length; ++i)
+    memset(buffer, 0x00, length);
+    SPI.transfer(buffer, length);
+}
+
+void SPICommunication::spiTransfer(SPIDevice device, uint8_t* buffer, size_t length)
+{
+    SPIBusLock lock(device);
+    SPI.transfer(buffer, length);
+}
+
+SPIBusManager* SPIBusManager::_instance = nullptr;
+
+SPIBusManager::SPIBusManager()
+{
+    for (uint8_t i = 0; i < static_cast<uint8_t>(SPIDevice::COUNT); i++)
+    {
+        _devices[i].chipSelectPin = noPin;
+        _devices[i].managedSelect = false;
+    }
+    resetStats();
+
+    // both chips of the Ethernet shield, the SD card can not be used with the W5100 selected
+    registerDevice(SPIDevice::ETHERNET, 10, SPISettings(14000000, MSBFIRST, SPI_MODE0), false);
+    registerDevice(SPIDevice::SD_CARD, 4, SPISettings(4000000, MSBFIRST, SPI_MODE0), false);
+}
+
+SPIBusManager* SPIBusManager::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new SPIBusManager();
+    }
+    return _instance;
+}
+
+void SPIBusManager::registerDevice(SPIDevice device, uint8_t chipSelectPin, const SPISettings& settings, bool managedSelect)
+{
+    DeviceEntry& entry = _devices[static_cast<uint8_t>(device)];
+    entry.chipSelectPin = chipSelectPin;
+    entry.managedSelect = managedSelect;
+    entry.settings = settings;
+
+    pinMode(chipSelectPin, OUTPUT);
+    digitalWrite(chipSelectPin, HIGH);
+}
+
+void SPIBusManager::acquire(SPIDevice device)
+{
+    unsigned long requested = micros();
+    _busMutex.lock();
+    _grantedMicros = micros();
+
+    deselectAll();
+
+    const DeviceEntry& entry = _devices[static_cast<uint8_t>(device)];
+    if (entry.managedSelect)
+    {
+        SPI.beginTransaction(entry.settings);
+        digitalWrite(entry.chipSelectPin, LOW);
+    }
+
+    SPIBusStats& stats = _stats[static_cast<uint8_t>(device)];
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stats.grants++;
+        stats.waitUs += _grantedMicros - requested;
+    }
+}
+
+void SPIBusManager::release(SPIDevice device)
+{
+    const DeviceEntry& entry = _devices[static_cast<uint8_t>(device)];
+    if (entry.managedSelect)
+    {
+        digitalWrite(entry.chipSelectPin, HIGH);
+        SPI.endTransaction();
+    }
+
+    unsigned long held = micros() - _grantedMicros;
+    SPIBusStats& stats = _stats[static_cast<uint8_t>(device)];
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stats.busyUs += held;
+        if (held > stats.maxHoldUs)
+        {
+            stats.maxHoldUs = held;
+        }
+    }
+
+    _busMutex.unlock();
+}
+
+SPIBusStats SPIBusManager::getStats(SPIDevice device)
+{
+    SPIBusStats stats;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stats = _stats[static_cast<uint8_t>(device)];
+    }
+    return stats;
+}
+
+float SPIBusManager::getOccupancy(SPIDevice device)
+{
+    unsigned long elapsedMs = millis() - _statsSinceMillis;
+    if (elapsedMs == 0)
+    {
+        return 0.0f;
+    }
+    return 0.1f * static_cast<float>(getStats(device).busyUs) / static_cast<float>(elapsedMs);
+}
+
+void SPIBusManager::resetStats()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        memset(_stats, 0, sizeof(_stats));
+        _statsSinceMillis = millis();
+    }
+}
+
+void SPIBusManager::deselectAll()
+{
+    for (uint8_t i = 0; i < static_cast<uint8_t>(SPIDevice::COUNT); i++)
     {
-        buffer[i] = SPI.transfer(0x00);
+        if (_devices[i].chipSelectPin != noPin)
+        {
+            digitalWrite(_devices[i].chipSelectPin, HIGH);
+        }
     }
 }
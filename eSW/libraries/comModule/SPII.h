@@ -11,10 +11,29 @@
 #include "SPII.h"
 
 #include <Arduino.h>
+#include <SPI.h>
+#include <frt.h>
 
 /// @brief Namespace for the communication module \namespace comModule
 namespace comModule
 {
+	/// @brief Devices on the shared SPI bus of the Ethernet shield. \enum SPIDevice
+	enum class SPIDevice : uint8_t
+	{
+		ETHERNET,   // W5100, select on pin 10
+		SD_CARD,    // SD slot of the shield, select on pin 4
+		COUNT
+	};
+
+	/// @brief Bus occupancy of one device, times in microseconds. \struct SPIBusStats
+	struct SPIBusStats
+	{
+		uint32_t grants;        // number of times the device got the bus
+		uint64_t busyUs;        // time the device held the bus, 64 bit as 32 bit wrap after 71 min
+		uint64_t waitUs;        // time the device waited for another device
+		uint32_t maxHoldUs;     // longest single hold
+	};
+
 	/// @brief Class to handle SPI communication \class SPICommunication
 	class SPICommunication
 	{
@@ -35,21 +54,30 @@ namespace comModule
 		void endSPI();
 
 		/**
-		 * @brief Function to write data over SPI
+		 * @brief Function to write data over SPI, the bus must be granted
 		 *
 		 * @param data -> The data to write
 		 * @param length -> The length of the data
 		 */
-		void spiWrite(uint8_t* data, size_t length);
+		void spiWrite(const uint8_t* data, size_t length);
 
 		/**
-		 * @brief Function to read data over SPI
+		 * @brief Function to read data over SPI, the bus must be granted
 		 *
 		 * @param buffer -> The buffer to read the data into
 		 * @param length -> The length of the data to read
 		 */
 		void spiRead(uint8_t* buffer, size_t length);
 
+		/**
+		 * @brief Function to exchange a buffer with a device, takes the bus for the transfer
+		 *
+		 * @param device -> The device to talk to, registered with a managed select line
+		 * @param buffer -> The data to send, replaced by the received data
+		 * @param length -> The length of the data
+		 */
+		void spiTransfer(SPIDevice device, uint8_t* buffer, size_t length);
+
 		/**
 		 * @brief Function to check if the SPI communication is initialized
 		 *
@@ -61,6 +89,120 @@ namespace comModule
 	private:
 		bool spiInitialized = false;
 	};
+
+	/// @brief Class to share the SPI bus between the tasks, owns the select lines of all devices. \class SPIBusManager
+	/// Only one device holds the bus, every other select line is kept high meanwhile.
+	/// The lock is an frt::Mutex: a waiting task of higher priority gets the bus first and
+	/// lends its priority to the holder (priority inheritance). It is not recursive.
+	class SPIBusManager
+	{
+	public:
+
+		/**
+		 * @brief Get the Instance object
+		 *
+		 * @return SPIBusManager*
+		 */
+		static SPIBusManager* getInstance();
+
+		/**
+		 * @brief Function to set the select line and the bus settings of a device.
+		 * Ethernet and SD card are registered with the pins of the shield.
+		 *
+		 * @param device -> The device.
+		 * @param chipSelectPin -> The select pin, set to output and high.
+		 * @param settings -> The clock, bit order and mode of the device.
+		 * @param managedSelect -> true if the manager drives the select line and the transaction,
+		 *                         false if the driver of the device does (Ethernet and SD library).
+		 */
+		void registerDevice(SPIDevice device, uint8_t chipSelectPin, const SPISettings& settings, bool managedSelect);
+
+		/**
+		 * @brief Function to take the bus for a device, waits for the current holder.
+		 *
+		 * @param device -> The device that gets the bus.
+		 */
+		void acquire(SPIDevice device);
+
+		/**
+		 * @brief Function to give the bus back, deselects the device.
+		 *
+		 * @param device -> The device that holds the bus.
+		 */
+		void release(SPIDevice device);
+
+		/**
+		 * @brief Getter for the occupancy counters of a device.
+		 *
+		 * @param device -> The device.
+		 * @return SPIBusStats -> The counters since boot or the last reset.
+		 */
+		SPIBusStats getStats(SPIDevice device);
+
+		/**
+		 * @brief Function to get the share of time a device held the bus.
+		 *
+		 * @param device -> The device.
+		 * @return float -> The occupancy in percent since boot or the last reset.
+		 */
+		float getOccupancy(SPIDevice device);
+
+		/**
+		 * @brief Function to reset the occupancy counters of all devices.
+		 */
+		void resetStats();
+
+	private:
+		SPIBusManager();
+		~SPIBusManager() = default;
+
+		/**
+		 * @brief Function to drive every registered select line high.
+		 */
+		void deselectAll();
+
+		/// @brief Select line and settings of a registered device. \struct DeviceEntry
+		struct DeviceEntry
+		{
+			uint8_t chipSelectPin;
+			bool managedSelect;
+			SPISettings settings;
+		};
+
+		static SPIBusManager* _instance;
+
+		frt::Mutex _busMutex;
+		DeviceEntry _devices[static_cast<uint8_t>(SPIDevice::COUNT)];
+		SPIBusStats _stats[static_cast<uint8_t>(SPIDevice::COUNT)];
+		unsigned long _grantedMicros = 0;
+		unsigned long _statsSinceMillis = 0;   // the window in ms, micros() wraps after 71 min
+
+		static const uint8_t noPin = 0xFF;
+
+		SPIBusManager(const SPIBusManager&) = delete;
+		SPIBusManager& operator=(const SPIBusManager&) = delete;
+	};
+
+	/// @brief Class to hold the SPI bus for the scope of a block, like LockGuard. \class SPIBusLock
+	class SPIBusLock
+	{
+	public:
+		explicit SPIBusLock(SPIDevice device) : _device(device)
+		{
+			SPIBusManager::getInstance()->acquire(_device);
+		}
+
+		~SPIBusLock()
+		{
+			SPIBusManager::getInstance()->release(_device);
+		}
+
+	private:
+		SPIDevice _device;
+
+		SPIBusLock(const SPIBusLock&) = delete;
+		SPIBusLock& operator=(const SPIBusLock&) = delete;
+	};
 }
 
 #endif // SPI_COMMUNICATION_H
@@ -1,8 +1,14 @@
+#define LOG_SOURCE LogSource::FLYBACK
+
 #include <Wire.h>
 #include <SPI.h>
 #include <Arduino.h>
 #include <flyback.h>
 #include <serialMenu.h>
+#include <timeModule.h>
+#include <fixedPoint.h>
+#include <adcEngine.h>
+#include <util/atomic.h>
 
 using namespace flybackModule;
 
@@ -92,6 +98,12 @@ bool Flyback::isInitialized() const
 
 void Flyback::setPWMFrequency(uint32_t frequency, int dutyCycle)
 {
+	// no setpoint from the HAS yet
+	if (frequency == 0)
+	{
+		return;
+	}
+
 	ICR1 = static_cast<uint16_t>(16000000 / frequency); // Setze Top-Wert für Frequenz
 	uint16_t ocrValue = (ICR1 * dutyCycle) / 100;       // Berechne Duty Cycle
 	OCR1A = ocrValue;                                   // OC1A (Pin 11, nicht-invertiert)
@@ -115,6 +127,8 @@ void Flyback::setTimerState(bool state)
 		// Turn timer off
 		TCCR1B &= ~(1 << CS10);
 		_timerInitialized = false;
+		// the HV input waits for Timer1 events, it converts free running now
+		sensorModule::AdcEngine::getInstance()->onTriggerStopped();
 	}
 	lastTimerState = state; // update the last settet timer state
 }
@@ -167,45 +181,77 @@ HVModule Flyback::getHVState()
 
 Measurement Flyback::measure()
 {
-	int adcValue = analogRead(Measure_ADC);
+	Measurement result = sample();
+
+	if (digitalRead(Main_Switch_REMOTE) == LOW && digitalRead(PSU) == HIGH)
+	{
+		uint32_t freq = getExternFrequency();
+		int dutycycle = getExternDutyCycle();
+		setPWMFrequency(freq, dutycycle);
+	}
+    return result;
+}
+
+void Flyback::publish(const Measurement& measurement)
+{
+	_published.publish(measurement);
+}
+
+Measurement Flyback::getLastMeasurement() const
+{
+	return _published.read();
+}
+
+Measurement Flyback::sample()
+{
+	Measurement result = {};
+	int adcValue = sensorModule::AdcEngine::getInstance()->read(Measure_ADC);
+	result.timestampUs = timeModule::TimeModuleInternals::getMonotonicMicros();
 	int psuState = digitalRead(PSU);
 	int manualState = digitalRead(Main_Switch_MANUAL);
 	int remoteState = digitalRead(Main_Switch_REMOTE);
 
 
+	// Fixed point from the ADC count to the Measurement, the divisions are folded into
+	// constants at compile time. Q16.16 mV and uA, Q20.12 V for up to 50 kV.
+	constexpr calcModule::Q16_16 milliVoltsPerCount(Vcc * 1000.0 / ADC_Max_Value);
+	constexpr calcModule::Q8_24 microAmpsPerMilliVolt(1000.0 / R2);
+	constexpr calcModule::Fixed<12> voltsPerMicroAmp(R1 / 1000000.0);
+
 	// Wird kontinuierlich Bearbeitet
-	//float reducedVoltage = adcValue * (Vcc / ADC_Max_Value);
+	//calcModule::Q16_16 reducedMilliVolts = calcModule::Q16_16::scale(adcValue, milliVoltsPerCount);
 	// Testing Voltage for simulation!
-	float reducedVoltage = 1.25;
-	meas.current = (reducedVoltage / R2) * 1000000;
-	meas.voltage = (meas.current / 1000000) * R1;
-	meas.power = (meas.voltage * meas.current) / 1000000;
+	calcModule::Q16_16 reducedMilliVolts = calcModule::Q16_16::fromInt(1250);
+	calcModule::Q16_16 current = reducedMilliVolts.multiply(microAmpsPerMilliVolt);
+	calcModule::Fixed<12> voltage = current.multiply<12>(voltsPerMicroAmp);
+
+	// float from here on, the Measurement is what tasks and endpoints read
+	result.current = current.toFloat();
+	result.voltage = voltage.toFloat();
+	result.power = result.voltage * (result.current * 0.000001f);
 
 	if (manualState == LOW && psuState == HIGH)
 	{
 		// Read in digitValue from poti
-		meas.digitalFreqValue = analogRead(PWM_Frequency);
-		meas.digitalDutyValue = analogRead(PWM_DutyCycle);
+		result.digitalFreqValue = sensorModule::AdcEngine::getInstance()->read(PWM_Frequency);
+		result.digitalDutyValue = sensorModule::AdcEngine::getInstance()->read(PWM_DutyCycle);
 
 		// Maping out the digitValues
-		meas.frequency = map(meas.digitalFreqValue, 0, 1023, 25000, 250000);
-		meas.dutyCycle = map(meas.digitalDutyValue, 0, 1023, 1, 50);
+		result.frequency = map(result.digitalFreqValue, 0, 1023, 25000, 250000);
+		result.dutyCycle = map(result.digitalDutyValue, 0, 1023, 1, 50);
 	}
 	else if (remoteState == LOW && psuState == HIGH)
 	{
-		uint32_t freq = getExternFrequency();
-		int dutycycle = getExternDutyCycle();
-		setPWMFrequency(freq, dutycycle);
+		result.frequency = getExternFrequency();
+		result.dutyCycle = getExternDutyCycle();
 	}
 	else
 	{
-		meas.frequency = NULL;
-		meas.dutyCycle = NULL;
-		meas.current = NULL;
-		meas.voltage = NULL;
-		meas.power = NULL;
+		result.current = 0;
+		result.voltage = 0;
+		result.power = 0;
 	}
-    return meas;
+    return result;
 }
 
 void Flyback::run()
@@ -217,16 +263,16 @@ void Flyback::run()
 		switch (currentState)
 		{
 			case MainSwitchStates::Main_Switch_OFF:
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("System is OFF."));
+				LOG_TOKEN(INFO, HV_SYSTEM_OFF);
 				break;
 			case MainSwitchStates::Main_Switch_MANUAL:
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("System is ON - Manual Mode."));
+				LOG_TOKEN(INFO, HV_MANUAL_MODE);
 				break;
 			case MainSwitchStates::Main_Switch_REMOTE:
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("System is ON - Remote Mode."));
+				LOG_TOKEN(INFO, HV_REMOTE_MODE);
 				break;
 			case MainSwitchStates::Main_switch_INVALID:
-				SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("HV:Invalid Switch Position."));
+				LOG_TOKEN(ERROR, HV_INVALID_SWITCH);
 				break;
 		}
 	}
@@ -268,8 +314,8 @@ void Flyback::handleManualState()
 	{
 		setTimerState(true);
 		setHVandPSU(HIGH, HIGH);
-		int potFreqValue = analogRead(PWM_Frequency);
-		int potDutyValue = analogRead(PWM_DutyCycle);
+		int potFreqValue = sensorModule::AdcEngine::getInstance()->read(PWM_Frequency);
+		int potDutyValue = sensorModule::AdcEngine::getInstance()->read(PWM_DutyCycle);
 		uint32_t frequency = map(potFreqValue, 0, 1023, 25000, 250000);
 		int dutyCycle = map(potDutyValue, 0, 1023, 1, 50);
 		if (frequency != lastPWMFrequency || dutyCycle != lastPWMDutyCycle)
@@ -339,7 +385,7 @@ void Flyback::setExternPSU(int state)
 {
 	if (state < 0 || state > 1)
 	{
-		SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Invalid PSU state"));
+		LOG_TOKEN(ERROR, HV_INVALID_PSU_STATE, state);
 		return;
 	}
 	currentPsuState = state;
@@ -348,7 +394,12 @@ void Flyback::setExternPSU(int state)
 
 uint32_t Flyback::getExternFrequency()
 {
-	return meas.frequency;
+	uint32_t frequency;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		frequency = _externFrequency;
+	}
+	return frequency;
 }
 
 void Flyback::setExternFrequency(uint32_t frequency)
@@ -357,12 +408,20 @@ void Flyback::setExternFrequency(uint32_t frequency)
 	{
 		return;
 	}
-	meas.frequency = frequency;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_externFrequency = frequency;
+	}
 }
 
 int Flyback::getExternDutyCycle()
 {
-	return meas.dutyCycle;
+	int dutyCycle;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		dutyCycle = _externDutyCycle;
+	}
+	return dutyCycle;
 }
 
 void Flyback::setExternDutyCycle(int dutyCycle)
@@ -371,7 +430,10 @@ void Flyback::setExternDutyCycle(int dutyCycle)
 	{
 		return;
 	}
-	meas.dutyCycle = dutyCycle;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_externDutyCycle = dutyCycle;
+	}
 }
 
 void Flyback::regulateVoltage(float targetVoltage, float hysteresis)
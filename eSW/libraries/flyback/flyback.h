@@ -12,6 +12,7 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <snapshot.h>
 
 /// @brief Namespace for the Flyback module \namespace flybackModule
 namespace flybackModule
@@ -41,6 +42,7 @@ namespace flybackModule
 
 	/// @brief Structure to store the measured values of the system \struct Measurement
 	/// This structure holds the voltage, current, power, frequency and dutycycle values measured from the system.
+	/// timestampUs is the monotonic capture time of the ADC sample, see TimeModuleInternals::getMonotonicMicros().
 	typedef struct Measurement
 	{
 		float voltage;
@@ -50,6 +52,7 @@ namespace flybackModule
 		int digitalDutyValue;
 		int dutyCycle;
 		uint32_t frequency;
+		uint64_t timestampUs;
 	} meas;
 
 	/// @brief Flyback class to manage the Flyback system \class Flyback
@@ -127,6 +130,29 @@ namespace flybackModule
          */
 		Measurement measure();
 
+        /**
+         * @brief Reads voltage, current, power, frequency and dutycycle without touching the PWM
+         * Used by the acquisition and the data logger, unlike measure() it leaves the remote PWM setpoint alone.
+         *
+         * @return Measurement -> A Measurement object containing voltage, current, and power
+         */
+		Measurement sample();
+
+        /**
+         * @brief Publishes a Measurement for getLastMeasurement(), only the acquisition task may call it
+         *
+         * @param measurement -> The result of sample().
+         */
+		void publish(const Measurement& measurement);
+
+        /**
+         * @brief Returns the last Measurement of the acquisition task, without touching the ADC
+         * Lock free and never torn, see Snapshot.
+         *
+         * @return Measurement -> The last published Measurement, all zero before the first publish()
+         */
+		Measurement getLastMeasurement() const;
+
         /**
          * @brief Executes logic depending on which Main-Switch state is active
          *
@@ -204,9 +230,23 @@ namespace flybackModule
 		 */
 		float getHysteresis() const;
 
+		/**
+		 * @brief Getter for the HV per ADC count of the measurement input, for raw captures of it.
+		 * @return The factor in V per count of the 10 bit result.
+		 */
+		static constexpr float getVoltsPerCount()
+		{
+			return Vcc / ADC_Max_Value * (R1 / R2);
+		}
+
 
 	private:
-		Measurement meas;
+		// published by publish(), the acquisition task is the only producer
+		Snapshot<Measurement> _published;
+
+		// setpoints of the HAS, written by the endpoint task, read with interrupts off
+		uint32_t _externFrequency = 0;
+		int _externDutyCycle = 0;
 
 		//Define Pins -->Inputs
 		static const int Main_Switch_OFF = 27;
@@ -224,10 +264,10 @@ namespace flybackModule
 		static const int HV_Module_Working = 35; //Signal LED
 
 		//Variables for calculating HV
-		const float R1 = 100000000;
-		const float R2 = 10000;
-		const float ADC_Max_Value = 1023.0;
-		const float Vcc = 5.0;
+		static constexpr float R1 = 100000000;
+		static constexpr float R2 = 10000;
+		static constexpr float ADC_Max_Value = 1023.0;
+		static constexpr float Vcc = 5.0;
 
 		bool _flybackInitialized;
 		bool _timerInitialized;
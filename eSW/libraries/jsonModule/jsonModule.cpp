@@ -6,6 +6,8 @@
  *
  * @copyright Copyright (c) 2025
  */
+#define LOG_SOURCE LogSource::JSON
+
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <jsonModule.h>
@@ -27,13 +29,13 @@ String JsonModuleInternals::getJsonString() const
     String output;
     if (jsonDoc.isNull() || jsonDoc.size() == 0)
     {
-        SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("JSON document is empty."));
+        LOG_TOKEN(ERROR, JSON_EMPTY);
         return "";
     }
 
     if (serializeJson(jsonDoc, output) == 0)
     {
-        SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Failed to serialize JSON."));
+        LOG_TOKEN(ERROR, JSON_SERIALIZE_FAILED);
     }
 
     return output;
@@ -52,12 +54,15 @@ void JsonModuleInternals::clearJson()
 
 void JsonModuleInternals::printJsonDocMemory()
 {
+	// called on every clearJson(), skip building the message unless it is printed
+    if (!LOG_IS_ENABLED(DEBUG)) return;
+
     String jsonDocMem = "Memory usage of jsonDoc:";
     jsonDocMem += " Capacity: ";
     jsonDocMem += jsonDoc.capacity();
     jsonDocMem += " Overflowed: ";
     jsonDocMem += jsonDoc.overflowed() ? "Yes" : "No";
-    SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, jsonDocMem);
+    LOG_DEBUG(jsonDocMem);
 }
 
 bool JsonModuleInternals::hasCapacityFor(size_t additionalSize) const
@@ -0,0 +1,150 @@
+/**
+ * @file snapshot.h
+ * @author Adrian Goessl
+ * @brief Lock free sharing of a value between one producer and any number of readers.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <Arduino.h>
+#include <string.h>
+
+/**
+ * @brief Double buffered seqlock, the producer writes the slot the readers do not use.
+ *
+ * publish() writes slot (sequence + 1) & 1 and then increments the sequence, a single byte
+ * store on the AVR. A reader copies slot sequence & 1 and checks that the sequence did not
+ * change meanwhile, otherwise the producer may have started on its slot and it copies again.
+ * The byte wraps after 256 publishes, so the reader also checks the 32 bit version of its
+ * slot before and after the copy, every publish into the slot changes it.
+ * A reader that preempts the producer always succeeds at the first try, so neither side waits
+ * for the other and there is no priority inversion. A reader only retries when a whole publish
+ * completed during its copy.
+ *
+ * Only one task or ISR may publish, T must be copyable with memcpy.
+ */
+template <typename T>
+class Snapshot
+{
+public:
+    Snapshot()
+    {
+        memset(_slots, 0, sizeof(_slots));
+    }
+
+    /**
+     * @brief Function to publish a new value, producer only.
+     *
+     * @param value -> The value, copied into the free slot.
+     */
+    void publish(const T& value)
+    {
+        beginWrite() = value;
+        commit();
+    }
+
+    /**
+     * @brief Function to change some fields of the value, producer only.
+     * The free slot gets a copy of the current value, commit() publishes it.
+     *
+     * @return T& -> The free slot.
+     */
+    T& beginWrite()
+    {
+        const uint8_t sequence = _sequence;
+        Slot& next = _slots[(sequence + 1) & 1];
+        memcpy(&next.value, &_slots[sequence & 1].value, sizeof(T));
+        return next.value;
+    }
+
+    /**
+     * @brief Function to publish the slot of beginWrite(), producer only.
+     */
+    void commit()
+    {
+        const uint8_t sequence = _sequence;
+        Slot& next = _slots[(sequence + 1) & 1];
+        next.version = _slots[sequence & 1].version + 1;
+        barrier();
+        _sequence = sequence + 1;
+    }
+
+    /**
+     * @brief Function to copy the newest value.
+     *
+     * @param value -> The copy.
+     * @return uint32_t -> The version of the copy, 0 if nothing was published.
+     */
+    uint32_t read(T& value) const
+    {
+        uint32_t version;
+        uint8_t before;
+        do
+        {
+            before = _sequence;
+            barrier();
+            version = _slots[before & 1].version;
+            barrier();
+            memcpy(&value, &_slots[before & 1].value, sizeof(T));
+            barrier();
+        } while (_sequence != before || _slots[before & 1].version != version);
+        return version;
+    }
+
+    /**
+     * @brief Function to copy the newest value.
+     *
+     * @return T -> The copy.
+     */
+    T read() const
+    {
+        T value;
+        read(value);
+        return value;
+    }
+
+    /**
+     * @brief Getter for the version, counts the publishes.
+     *
+     * @return uint32_t -> The version of the newest value.
+     */
+    uint32_t getVersion() const
+    {
+        uint32_t version;
+        uint8_t before;
+        do
+        {
+            before = _sequence;
+            barrier();
+            version = _slots[before & 1].version;
+            barrier();
+        } while (_sequence != before || _slots[before & 1].version != version);
+        return version;
+    }
+
+private:
+    /// @brief A value with the number of its publish. \struct Slot
+    struct Slot
+    {
+        T value;
+        uint32_t version;
+    };
+
+    static inline void barrier()
+    {
+        __asm__ __volatile__("" ::: "memory");
+    }
+
+    Slot _slots[2];
+    volatile uint8_t _sequence = 0;
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,341 @@
+/**
+ * @file dataLogger.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the high rate binary data logger.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <dataLogger.h>
+#include <logManager.h>
+#include <ptrUtils.h>
+#include <SPII.h>
+#include <util/atomic.h>
+
+using namespace comModule;
+
+// card, volume and root of the LogManager, see logManager.cpp
+extern Sd2Card card;
+extern SdVolume volume;
+extern SdFile root;
+
+DataLogger* DataLogger::_instance = nullptr;
+volatile bool DataLogger::_running = false;
+
+DataLogger::DataLogger()
+{
+
+}
+
+DataLogger::~DataLogger()
+{
+    stop();
+}
+
+DataLogger* DataLogger::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new DataLogger();
+    }
+    return _instance;
+}
+
+bool DataLogger::isRunning()
+{
+    return _running;
+}
+
+bool DataLogger::addChannel(const char* name, const char* unit)
+{
+    if (_running || _channelCount >= DATALOG_MAX_CHANNELS)
+    {
+        return false;
+    }
+
+    _channelNames[_channelCount] = name;
+    _channelUnits[_channelCount] = unit;
+    _channelCount++;
+    return true;
+}
+
+bool DataLogger::start(uint16_t sampleRateHz, uint32_t durationSeconds)
+{
+    LogManager* logger = LogManager::getInstance();
+    if (_running || _channelCount == 0 || sampleRateHz == 0 || !logger->isSDCardInitialized())
+    {
+        return false;
+    }
+
+    _recordSize = 4 + 4 * _channelCount;
+    _recordsPerBlock = (DATALOG_BLOCK_SIZE - DATALOG_BLOCK_HEADER_SIZE) / _recordSize;
+    _sampleRateHz = sampleRateHz;
+
+    // header block + data blocks, FAT32 files end at 4 GB
+    uint32_t samples = static_cast<uint32_t>(sampleRateHz) * durationSeconds;
+    uint32_t dataBlocks = (samples + _recordsPerBlock - 1) / _recordsPerBlock;
+    if (dataBlocks == 0 || dataBlocks > 8388600UL)
+    {
+        return false;
+    }
+    _blockCount = dataBlocks + 1;
+
+    SPIBusLock bus(SPIDevice::SD_CARD);
+    SD.mkdir(LOG_DIRECTORY);
+
+    uint32_t index = 1;
+    char name[13];
+    do
+    {
+        snprintf(name, sizeof(name), "DAT%05lu.BIN", static_cast<unsigned long>(index));
+        _fileName = LOG_DIRECTORY "/";
+        _fileName += name;
+    } while (SD.exists(_fileName) && ++index <= maxFileIndex);
+
+    // the blocks of a contiguous file can be written raw, without touching the FAT
+    bool created = false;
+    if (index <= maxFileIndex && (root.isOpen() || root.openRoot(&volume)))
+    {
+        SdFile directory;
+        SdFile file;
+        uint32_t lastBlock = 0;
+
+        if (directory.open(&root, LOG_DIRECTORY, O_READ))
+        {
+            created = file.createContiguous(&directory, name, _blockCount * DATALOG_BLOCK_SIZE)
+                   && file.contiguousRange(&_firstBlock, &lastBlock);
+            file.close();
+            directory.close();
+        }
+    }
+
+    if (!created)
+    {
+        return false;
+    }
+
+    _stats = {};
+    _fill = 0;
+    _write = 0;
+    _fillRecords = 0;
+    _queuedBlocks = 0;
+    _nextBlock = 1;
+    _sequence = 0;
+    _ready[0] = false;
+    _ready[1] = false;
+    _startEpochMs = timeModule::TimeModuleInternals::getInstance()->getEpochMillis();
+    _startMicros = micros();
+
+    beginBlock();
+    _running = true;
+    return true;
+}
+
+bool DataLogger::logSample(const float* values)
+{
+    // every data block of the file is queued, service() closes the recording
+    if (!_running || _queuedBlocks >= _blockCount - 1)
+    {
+        return false;
+    }
+
+    if (_fillRecords == _recordsPerBlock)
+    {
+        // the block is full, but the other buffer is still waiting for the card
+        if (_ready[_fill ^ 1])
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                _stats.overruns++;
+            }
+            return false;
+        }
+
+        _ready[_fill] = true;
+        _queuedBlocks++;
+        _fill ^= 1;
+        beginBlock();
+
+        if (_queuedBlocks >= _blockCount - 1)
+        {
+            return false;
+        }
+    }
+
+    uint8_t* record = &_buffers[_fill][DATALOG_BLOCK_HEADER_SIZE + _fillRecords * _recordSize];
+    uint32_t elapsedUs = micros() - _startMicros;
+    memcpy(record, &elapsedUs, 4);
+    memcpy(record + 4, values, 4 * _channelCount);
+
+    _fillRecords++;
+    _buffers[_fill][2] = static_cast<uint8_t>(_fillRecords);
+    _buffers[_fill][3] = static_cast<uint8_t>(_fillRecords >> 8);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _stats.samples++;
+    }
+    return true;
+}
+
+bool DataLogger::hasPendingBlock() const
+{
+    return _ready[0] || _ready[1];
+}
+
+void DataLogger::service()
+{
+    if (!hasPendingBlock())
+    {
+        return;
+    }
+
+    SPIBusLock bus(SPIDevice::SD_CARD);
+    writePendingBlocks();
+
+    // the file is full, close the recording
+    if (_running && _nextBlock >= _blockCount)
+    {
+        _running = false;
+        finish();
+    }
+}
+
+void DataLogger::stop()
+{
+    if (!_running)
+    {
+        return;
+    }
+    _running = false;
+
+    SPIBusLock bus(SPIDevice::SD_CARD);
+    writePendingBlocks();
+    finish();
+}
+
+void DataLogger::writePendingBlocks()
+{
+    uint8_t count = 0;
+    if (_ready[_write])
+    {
+        count = _ready[_write ^ 1] ? 2 : 1;
+    }
+    if (count == 0 || _nextBlock + count > _blockCount)
+    {
+        return;
+    }
+
+    // pre-erase the rest of the file, the card can then write without erasing first
+    unsigned long started = micros();
+    bool written = card.writeStart(_firstBlock + _nextBlock, _blockCount - _nextBlock);
+    for (uint8_t i = 0; i < count && written; i++)
+    {
+        written = card.writeData(_buffers[(_write + i) & 1]);
+    }
+    written = card.writeStop() && written;
+    unsigned long elapsed = micros() - started;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        _ready[_write] = false;
+        _write ^= 1;
+    }
+    _nextBlock += count;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (written)
+        {
+            _stats.blocksWritten += count;
+        }
+        else
+        {
+            _stats.writeErrors++;
+        }
+        _stats.busyUs += elapsed;
+        if (elapsed > _stats.maxBlockWriteUs)
+        {
+            _stats.maxBlockWriteUs = elapsed;
+        }
+
+        uint32_t recordingMs = (micros() - _startMicros) / 1000UL;
+        if (recordingMs > 0)
+        {
+            _stats.bytesPerSecond = static_cast<uint32_t>(
+                static_cast<uint64_t>(_stats.blocksWritten) * DATALOG_BLOCK_SIZE * 1000ULL / recordingMs);
+        }
+    }
+}
+
+void DataLogger::finish()
+{
+    // the partial block goes out like a full one, its record count tells the reader where it ends
+    if (_fillRecords > 0 && !_ready[_fill] && _nextBlock < _blockCount)
+    {
+        _ready[_fill] = true;
+        _fillRecords = 0;
+        writePendingBlocks();
+    }
+
+    // the header buffer is free, nothing is queued any more
+    uint8_t* header = _buffers[_write];
+    buildHeader(header);
+
+    if (!card.writeBlock(_firstBlock, header))
+    {
+        _stats.writeErrors++;
+    }
+}
+
+void DataLogger::beginBlock()
+{
+    uint8_t* block = _buffers[_fill];
+    memset(block, 0, DATALOG_BLOCK_SIZE);
+    block[0] = 'D';
+    block[1] = 'B';
+    memcpy(&block[4], &_sequence, 4);
+    _sequence++;
+    _fillRecords = 0;
+}
+
+void DataLogger::buildHeader(uint8_t* buffer)
+{
+    memset(buffer, 0, DATALOG_BLOCK_SIZE);
+    memcpy(buffer, "FFDL", 4);
+    buffer[4] = DATALOG_VERSION;
+    buffer[5] = _channelCount;
+    memcpy(&buffer[6], &_recordSize, 2);
+    memcpy(&buffer[8], &_recordsPerBlock, 2);
+    memcpy(&buffer[10], &_sampleRateHz, 2);
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        buffer[12 + i] = static_cast<uint8_t>(_startEpochMs >> (8 * i));
+    }
+    memcpy(&buffer[18], &_stats.samples, 4);
+    memcpy(&buffer[22], &_stats.overruns, 4);
+    memcpy(&buffer[26], &_stats.blocksWritten, 4);
+
+    for (uint8_t i = 0; i < _channelCount; i++)
+    {
+        uint8_t* channel = &buffer[DATALOG_HEADER_SIZE + i * DATALOG_CHANNEL_SIZE];
+        strncpy(reinterpret_cast<char*>(channel), _channelNames[i], DATALOG_NAME_SIZE - 1);
+        strncpy(reinterpret_cast<char*>(channel + DATALOG_NAME_SIZE), _channelUnits[i], DATALOG_UNIT_SIZE - 1);
+    }
+}
+
+DataLoggerStats DataLogger::getStats()
+{
+    DataLoggerStats stats;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stats = _stats;
+    }
+    return stats;
+}
+
+String DataLogger::getFileName() const
+{
+    return _fileName;
+}
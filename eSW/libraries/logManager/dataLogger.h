@@ -0,0 +1,199 @@
+/**
+ * @file dataLogger.h
+ * @author Adrian Goessl
+ * @brief Header file for the high rate binary data logger.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef DATALOGGER_H
+#define DATALOGGER_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+/*
+ * Recordings go to a preallocated contiguous file, LOGS/DAT00001.BIN, LOGS/DAT00002.BIN, ...
+ * The blocks are written raw with multi block writes, no FAT or directory update while recording.
+ * All numbers little endian.
+ *
+ * Block 0, schema header, rewritten with the final counters by stop():
+ *   0  'F' 'F' 'D' 'L'
+ *   4  version (1) | channel count (1) | record size (2) | records per block (2) | sample rate Hz (2)
+ *   12 start epoch ms (6)
+ *   18 records (4) | overruns (4) | data blocks (4)
+ *   32 channels, DATALOG_CHANNEL_SIZE bytes each: name (12) | unit (8) | reserved (4)
+ *
+ * Data blocks:
+ *   'D' 'B' | record count (2) | block sequence (4) | records
+ *   record: micros since start (4) | one float per channel
+ * The sequence starts at 0 and has no gaps, a reader stops at the first block that breaks it.
+ */
+#define DATALOG_BLOCK_SIZE 512
+#define DATALOG_HEADER_SIZE 32
+#define DATALOG_BLOCK_HEADER_SIZE 8
+#define DATALOG_CHANNEL_SIZE 24
+#define DATALOG_NAME_SIZE 12
+#define DATALOG_UNIT_SIZE 8
+#define DATALOG_MAX_CHANNELS 8
+#define DATALOG_VERSION 1
+#define DATALOG_MIN_RATE_HZ 4       // Timer3 with prescaler 64 at 16 MHz
+#define DATALOG_MAX_RATE_HZ 1000
+
+/// @brief Counters of the data logger, for the throughput and the overruns. \struct DataLoggerStats
+struct DataLoggerStats
+{
+    uint32_t samples;           // samples in the buffers
+    uint32_t overruns;          // samples dropped, both buffers waiting for the card
+    uint32_t blocksWritten;     // data blocks on the card
+    uint32_t writeErrors;       // failed block writes
+    uint32_t maxBlockWriteUs;   // slowest multi block write, card busy time included
+    uint32_t busyUs;            // time spent writing to the card
+    uint32_t bytesPerSecond;    // sustained rate, written bytes per second of recording
+};
+
+/// @brief Class to record fixed size samples at a high rate to the SD card. \class DataLogger
+class DataLogger
+{
+public:
+
+    /**
+     * @brief Get the Instance object, the buffers are only allocated when the data logger is used.
+     *
+     * @return DataLogger*
+     */
+    static DataLogger* getInstance();
+
+    /**
+     * @brief Function to check if a recording is running, without creating the instance.
+     *
+     * @return true -> if a recording is running
+     * @return false -> if no recording is running
+     */
+    static bool isRunning();
+
+    /**
+     * @brief Function to add a channel to the schema, only before start().
+     * The strings are not copied, they must outlive the recordings, e.g. string literals.
+     *
+     * @param name -> The name of the channel, up to 11 chars in the header.
+     * @param unit -> The unit of the channel, up to 7 chars in the header.
+     * @return true -> if the channel was added
+     * @return false -> if a recording is running or DATALOG_MAX_CHANNELS is reached
+     */
+    bool addChannel(const char* name, const char* unit);
+
+    /**
+     * @brief Function to start a recording, preallocates a contiguous file for all samples.
+     * The LogManager must have initialized the SD card.
+     *
+     * @param sampleRateHz -> The rate logSample() is called at, stored in the header.
+     * @param durationSeconds -> The length of the recording, sizes the file.
+     * @return true -> if the file was created and the recording started
+     * @return false -> if there are no channels, no SD card or not enough contiguous space
+     */
+    bool start(uint16_t sampleRateHz, uint32_t durationSeconds);
+
+    /**
+     * @brief Function to add a sample, called by the sampling task.
+     * Never waits for the card, a sample that finds both buffers full is counted as overrun.
+     *
+     * @param values -> One value per channel, in the order of addChannel().
+     * @return true -> if the sample was stored
+     * @return false -> if no recording is running, the file is full or the sample was dropped
+     */
+    bool logSample(const float* values);
+
+    /**
+     * @brief Function to check if a full buffer waits for service().
+     *
+     * @return true -> if a block is ready to write
+     * @return false -> if nothing is to write
+     */
+    bool hasPendingBlock() const;
+
+    /**
+     * @brief Function to write the full buffers to the card, called by a lower priority task than logSample().
+     */
+    void service();
+
+    /**
+     * @brief Function to stop the recording, writes the partial block and the final header.
+     */
+    void stop();
+
+    /**
+     * @brief Getter for the counters of the current or last recording.
+     *
+     * @return DataLoggerStats -> The counters.
+     */
+    DataLoggerStats getStats();
+
+    /**
+     * @brief Getter for the file of the current or last recording.
+     *
+     * @return String -> The path, e.g. LOGS/DAT00001.BIN
+     */
+    String getFileName() const;
+
+private:
+    DataLogger();
+    ~DataLogger();
+
+    /**
+     * @brief Function to write the full buffers with one multi block write, the SD card must hold the SPI bus.
+     */
+    void writePendingBlocks();
+
+    /**
+     * @brief Function to write the partial block and the final header, the SD card must hold the SPI bus.
+     */
+    void finish();
+
+    /**
+     * @brief Function to build the schema header block in the given buffer.
+     *
+     * @param buffer -> The DATALOG_BLOCK_SIZE destination.
+     */
+    void buildHeader(uint8_t* buffer);
+
+    /**
+     * @brief Function to start a new data block in the fill buffer.
+     */
+    void beginBlock();
+
+    static DataLogger* _instance;
+    static volatile bool _running;
+
+    const char* _channelNames[DATALOG_MAX_CHANNELS];
+    const char* _channelUnits[DATALOG_MAX_CHANNELS];
+    uint8_t _channelCount = 0;
+    uint16_t _recordSize = 0;
+    uint16_t _recordsPerBlock = 0;
+    uint16_t _sampleRateHz = 0;
+
+    uint8_t _buffers[2][DATALOG_BLOCK_SIZE];
+    volatile bool _ready[2] = { false, false };
+    uint8_t _fill = 0;              // buffer logSample() writes to
+    uint8_t _write = 0;             // next buffer service() writes
+    uint16_t _fillRecords = 0;
+    uint32_t _queuedBlocks = 0;     // data blocks handed to service()
+
+    uint32_t _firstBlock = 0;       // card block of the header
+    uint32_t _blockCount = 0;       // blocks of the file
+    uint32_t _nextBlock = 1;        // next data block in the file
+    uint32_t _sequence = 0;
+    uint32_t _startMicros = 0;
+    uint64_t _startEpochMs = 0;
+    String _fileName;
+    DataLoggerStats _stats = {};
+
+    static const uint32_t maxFileIndex = 99999;
+
+    DataLogger(const DataLogger&) = delete;
+    DataLogger& operator=(const DataLogger&) = delete;
+};
+
+#endif // DATALOGGER_H
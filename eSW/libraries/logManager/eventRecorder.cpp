@@ -0,0 +1,381 @@
+/**
+ * @file eventRecorder.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the multi channel event recorder with pre-trigger history.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include <eventRecorder.h>
+#include <logManager.h>
+#include <ptrUtils.h>
+#include <SPII.h>
+#include <util/atomic.h>
+
+using namespace comModule;
+using namespace timeModule;
+
+EventRecorder* EventRecorder::_instance = nullptr;
+
+EventRecorder::EventRecorder()
+{
+
+}
+
+EventRecorder* EventRecorder::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new EventRecorder();
+    }
+    return _instance;
+}
+
+bool EventRecorder::begin(uint8_t* storage, uint16_t size)
+{
+    if (PtrUtils::IsNullPtr(storage) || size < EVENT_MIN_RECORDS * EVENT_RECORD_SIZE)
+    {
+        return false;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _buffer = storage;
+        _capacity = size / EVENT_RECORD_SIZE;
+        _armed = false;
+        _state = EventState::IDLE;
+    }
+    return true;
+}
+
+bool EventRecorder::arm(const EventConfig& config)
+{
+    if (PtrUtils::IsNullPtr(_buffer) || config.channel >= EventChannel::COUNT || config.preRecords >= _capacity
+        || config.periodMs < EVENT_MIN_PERIOD_MS || config.periodMs > EVENT_MAX_PERIOD_MS)
+    {
+        return false;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (_state == EventState::PENDING)
+        {
+            return false;
+        }
+
+        _config = config;
+        _write = 0;
+        _count = 0;
+        _manual = false;
+        _hasPrevious = false;
+        _armed = true;
+        _state = EventState::ARMED;
+    }
+    return true;
+}
+
+void EventRecorder::disarm()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _armed = false;
+        if (_state != EventState::PENDING)
+        {
+            _state = EventState::IDLE;
+        }
+    }
+}
+
+bool EventRecorder::trigger()
+{
+    if (_state != EventState::ARMED)
+    {
+        return false;
+    }
+    _manual = true;
+    return true;
+}
+
+bool EventRecorder::add(const EventSample& sample)
+{
+    uint64_t nowUs = TimeModuleInternals::getMonotonicMicros();
+    uint32_t timeMs = static_cast<uint32_t>(nowUs / 1000ULL);
+
+    // short and without bus access, arm() and disarm() of the endpoint task see a consistent ring
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        EventState state = _state;
+        if (state == EventState::IDLE)
+        {
+            return false;
+        }
+
+        EventSource source = detect(sample);
+        if (state == EventState::PENDING)
+        {
+            // the ring is frozen until service() wrote it
+            if (source != EventSource::NONE)
+            {
+                _missed++;
+            }
+            return false;
+        }
+
+        uint8_t* record = &_buffer[_write * EVENT_RECORD_SIZE];
+        memcpy(record, &timeMs, 4);
+        record[4] = sample.states;
+        memcpy(record + 5, sample.values, 4 * EVENT_CHANNEL_COUNT);
+        if (++_write == _capacity)
+        {
+            _write = 0;
+        }
+
+        if (state == EventState::TRIGGERED)
+        {
+            // later events of the same shot are part of this record
+            if (--_count == 0)
+            {
+                _state = EventState::PENDING;
+                return true;
+            }
+        }
+        else if (source != EventSource::NONE)
+        {
+            // this record is the first after the event, the ring is full once the rest is in
+            _preRecords = _count;
+            _source = source;
+            _triggerUs = nowUs;
+            _triggerMs = timeMs;
+            _count = _capacity - _preRecords - 1;
+            if (_count == 0)
+            {
+                _state = EventState::PENDING;
+                return true;
+            }
+            _state = EventState::TRIGGERED;
+        }
+        else if (_count < _config.preRecords)
+        {
+            _count++;
+        }
+    }
+    return false;
+}
+
+bool EventRecorder::hasPendingRecord() const
+{
+    return _state == EventState::PENDING;
+}
+
+void EventRecorder::service()
+{
+    if (_state != EventState::PENDING)
+    {
+        return;
+    }
+
+    // the ring stays frozen while writing, add() does not touch it
+    bool written = false;
+    if (LogManager::getInstance()->isSDCardInitialized())
+    {
+        SPIBusLock bus(SPIDevice::SD_CARD);
+
+        // the first event continues after the files of the previous boots
+        if (_fileIndex == 0)
+        {
+            SD.mkdir(LOG_DIRECTORY);
+            while (_fileIndex < maxFileIndex && SD.exists(getFileName(_fileIndex + 1)))
+            {
+                _fileIndex++;
+            }
+        }
+
+        if (_fileIndex < maxFileIndex)
+        {
+            File file = SD.open(getFileName(_fileIndex + 1), FILE_WRITE);
+            if (file)
+            {
+                // the oldest record is the next one the ring would have overwritten
+                uint16_t first = (_capacity - _write) * EVENT_RECORD_SIZE;
+                uint16_t second = _write * EVENT_RECORD_SIZE;
+                buildHeader(_header);
+                written = file.write(_header, EVENT_HEADER_SIZE) == EVENT_HEADER_SIZE
+                       && file.write(&_buffer[second], first) == first
+                       && (second == 0 || file.write(_buffer, second) == second);
+                file.close();
+
+                // a broken file is not overwritten by the next event
+                _fileIndex++;
+            }
+        }
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (written)
+        {
+            _events++;
+            _lastIndex = _fileIndex;
+            _lastSource = _source;
+        }
+        else
+        {
+            _writeErrors++;
+        }
+
+        _write = 0;
+        _count = 0;
+        _manual = false;
+        _state = _armed ? EventState::ARMED : EventState::IDLE;
+    }
+}
+
+int EventRecorder::readFile(uint32_t index, uint32_t offset, uint8_t* buffer, uint16_t length)
+{
+    if (index == 0 || index > maxFileIndex || !LogManager::getInstance()->isSDCardInitialized())
+    {
+        return -1;
+    }
+
+    SPIBusLock bus(SPIDevice::SD_CARD);
+    File file = SD.open(getFileName(index), FILE_READ);
+    if (!file)
+    {
+        return -1;
+    }
+
+    int count = 0;
+    if (offset < file.size())
+    {
+        count = file.seek(offset) ? file.read(buffer, length) : -1;
+    }
+    file.close();
+    return count;
+}
+
+EventState EventRecorder::getState() const
+{
+    return _state;
+}
+
+const EventConfig& EventRecorder::getConfig() const
+{
+    return _config;
+}
+
+uint16_t EventRecorder::getPeriodMs() const
+{
+    return _armed ? _config.periodMs : 0;
+}
+
+uint16_t EventRecorder::getCapacity() const
+{
+    return _capacity;
+}
+
+uint32_t EventRecorder::getLastIndex() const
+{
+    return _lastIndex;
+}
+
+EventSource EventRecorder::getLastSource() const
+{
+    return _lastSource;
+}
+
+uint32_t EventRecorder::getEventCount() const
+{
+    return _events;
+}
+
+uint32_t EventRecorder::getMissedCount() const
+{
+    return _missed;
+}
+
+uint32_t EventRecorder::getWriteErrors() const
+{
+    return _writeErrors;
+}
+
+String EventRecorder::getFileName(uint32_t index)
+{
+    char name[13];
+    snprintf(name, sizeof(name), "EVT%05lu.BIN", static_cast<unsigned long>(index));
+    String path = LOG_DIRECTORY "/";
+    path += name;
+    return path;
+}
+
+EventSource EventRecorder::detect(const EventSample& sample)
+{
+    bool breach = isBreach(sample);
+    uint8_t changed = sample.states ^ _previousStates;
+    EventSource source = EventSource::NONE;
+
+    // edges need the previous record, the first one after arm() only sets the states
+    if (_hasPrevious)
+    {
+        if ((_config.sources & (1 << static_cast<uint8_t>(EventSource::HV_ENABLE)))
+            && (changed & sample.states & EVENT_STATE_HV_OUTPUT))
+        {
+            source = EventSource::HV_ENABLE;
+        }
+        else if ((_config.sources & (1 << static_cast<uint8_t>(EventSource::MAIN_SWITCH)))
+            && (changed & EVENT_STATE_MAIN_MASK))
+        {
+            source = EventSource::MAIN_SWITCH;
+        }
+        else if ((_config.sources & (1 << static_cast<uint8_t>(EventSource::THRESHOLD)))
+            && breach && !_previousBreach)
+        {
+            source = EventSource::THRESHOLD;
+        }
+    }
+
+    if (_manual)
+    {
+        _manual = false;
+        if (source == EventSource::NONE)
+        {
+            source = EventSource::MANUAL;
+        }
+    }
+
+    _previousStates = sample.states;
+    _previousBreach = breach;
+    _hasPrevious = true;
+    return source;
+}
+
+bool EventRecorder::isBreach(const EventSample& sample) const
+{
+    // NAN compares false both ways, a channel without samples never breaches
+    float value = sample.values[static_cast<uint8_t>(_config.channel)];
+    return _config.above ? value > _config.level : value < _config.level;
+}
+
+void EventRecorder::buildHeader(uint8_t* buffer)
+{
+    uint16_t records = _capacity;
+    uint64_t triggerEpochMs = TimeModuleInternals::getInstance()->monotonicToEpochMillis(_triggerUs);
+
+    memset(buffer, 0, EVENT_HEADER_SIZE);
+    memcpy(buffer, "FFEV", 4);
+    buffer[4] = EVENT_VERSION;
+    buffer[5] = static_cast<uint8_t>(_source);
+    buffer[6] = EVENT_CHANNEL_COUNT;
+    buffer[7] = EVENT_RECORD_SIZE;
+    memcpy(&buffer[8], &records, 2);
+    memcpy(&buffer[10], &_preRecords, 2);
+    memcpy(&buffer[12], &_config.periodMs, 2);
+    buffer[14] = static_cast<uint8_t>(_config.channel);
+    buffer[15] = _config.above ? 1 : 0;
+    memcpy(&buffer[16], &_config.level, 4);
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        buffer[20 + i] = static_cast<uint8_t>(triggerEpochMs >> (8 * i));
+    }
+    memcpy(&buffer[26], &_triggerMs, 4);
+}
@@ -0,0 +1,314 @@
+/**
+ * @file eventRecorder.h
+ * @author Adrian Goessl
+ * @brief Header file for the multi channel event recorder with pre-trigger history.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef EVENTRECORDER_H
+#define EVENTRECORDER_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+/*
+ * Every event goes to its own file, LOGS/EVT00001.BIN, LOGS/EVT00002.BIN, ...
+ * All numbers little endian.
+ *
+ * Header:
+ *   0  'F' 'F' 'E' 'V'
+ *   4  version (1) | source (1) | channel count (1) | record size (1)
+ *   8  records (2) | records before the trigger (2) | period ms (2) | threshold channel (1) | threshold above (1)
+ *   16 threshold level (4, float)
+ *   20 trigger epoch ms (6)
+ *   26 trigger time ms (4), the time of the first record after the pre-trigger records
+ *   30 reserved (2)
+ *
+ * Records, oldest first:
+ *   time ms (4) | states (1) | one float per EventChannel, NAN if not sampled yet
+ * The time is the low 32 bits of the monotonic clock in ms, the epoch of a record is
+ * trigger epoch ms + (int32_t)(time - trigger time).
+ */
+#define EVENT_HEADER_SIZE 32
+#define EVENT_VERSION 1
+#define EVENT_MIN_RECORDS 8
+#define EVENT_MIN_PERIOD_MS 15      // one FreeRTOS tick
+#define EVENT_MAX_PERIOD_MS 60000
+
+// bits of the states byte
+#define EVENT_STATE_HV_OUTPUT 0x01      // power supply of the HV module on
+#define EVENT_STATE_HV_SWITCH 0x02      // HV switch on, manual mode only
+#define EVENT_STATE_PUMP 0x04           // pump relay on
+#define EVENT_STATE_MAIN_SHIFT 3        // 2 bits, MainSwitchStates: off, manual, remote, invalid
+#define EVENT_STATE_MAIN_MASK 0x18
+
+/// @brief Enum of the recorded channels, in the order of the record. \enum EventChannel
+enum class EventChannel : uint8_t
+{
+    HV_VOLTAGE,             // V
+    HV_CURRENT,             // uA
+    VAT_PRESSURE,           // mbar
+    TEMPERATURE_INDOOR,     // C
+    TEMPERATURE_OUTDOOR,    // C
+    COUNT
+};
+
+#define EVENT_CHANNEL_COUNT static_cast<uint8_t>(EventChannel::COUNT)
+#define EVENT_RECORD_SIZE (5 + 4 * EVENT_CHANNEL_COUNT)
+
+/// @brief Enum of the causes of an event, also the bits of EventConfig::sources. \enum EventSource
+enum class EventSource : uint8_t
+{
+    NONE,
+    HV_ENABLE,              // the HV output switches on
+    MAIN_SWITCH,            // the main switch changes its position
+    THRESHOLD,              // a channel crosses the threshold level
+    MANUAL                  // requested with trigger()
+};
+
+/// @brief Enum of the states of the recorder. \enum EventState
+enum class EventState : uint8_t
+{
+    IDLE,                   // not configured or disarmed
+    ARMED,                  // filling the pre-trigger window, watching for an event
+    TRIGGERED,              // recording the records after the event
+    PENDING                 // frozen, waits for service() to write the file
+};
+
+/// @brief Structure of one sample of all channels, filled by the sampling task. \struct EventSample
+struct EventSample
+{
+    float values[EVENT_CHANNEL_COUNT];
+    uint8_t states;
+};
+
+/// @brief Structure for the configuration of the recorder. \struct EventConfig
+struct EventConfig
+{
+    uint8_t sources;            // bit (1 << EventSource) per enabled source
+    EventChannel channel;       // channel of the threshold
+    float level;                // threshold level, in the unit of the channel
+    bool above;                 // breach when the channel rises above the level, else when it falls below
+    uint16_t periodMs;          // time between two records
+    uint16_t preRecords;        // records kept before the event, less than the capacity
+};
+
+/// @brief Class to keep a rolling window of all shot channels and freeze it around an event. \class EventRecorder
+/// The sampling task adds one EventSample per period to a ring in caller provided storage. An event
+/// stops the ring after the records that follow it, service() then writes the frozen ring as one
+/// file from a lower priority task and arms again. The sampling task never waits for the card,
+/// events during the write are counted as missed. Edges are only seen between two records.
+class EventRecorder
+{
+public:
+
+    /**
+     * @brief Get the Instance object
+     *
+     * @return EventRecorder*
+     */
+    static EventRecorder* getInstance();
+
+    /**
+     * @brief Function to hand over the storage of the ring.
+     *
+     * @param storage -> The buffer, EVENT_RECORD_SIZE bytes per record.
+     * @param size -> Its size in bytes, at least EVENT_MIN_RECORDS records.
+     * @return true -> if the storage is usable
+     * @return false -> if it is too small
+     */
+    bool begin(uint8_t* storage, uint16_t size);
+
+    /**
+     * @brief Function to set the configuration and arm the recorder, the ring starts empty.
+     *
+     * @param config -> The configuration.
+     * @return true -> if armed
+     * @return false -> if not begun, a record is pending or the configuration is invalid
+     */
+    bool arm(const EventConfig& config);
+
+    /**
+     * @brief Function to stop the recording, a pending record is still written.
+     */
+    void disarm();
+
+    /**
+     * @brief Function to request an event with the next record.
+     *
+     * @return true -> if the recorder is armed
+     * @return false -> if not
+     */
+    bool trigger();
+
+    /**
+     * @brief Function to add a sample, called by the sampling task every getPeriodMs().
+     *
+     * @param sample -> The values and states.
+     * @return true -> if the record is complete and waits for service()
+     * @return false -> if the recording goes on or nothing is armed
+     */
+    bool add(const EventSample& sample);
+
+    /**
+     * @brief Function to check if a frozen record waits for service().
+     *
+     * @return true -> if a record is pending
+     * @return false -> if nothing is to write
+     */
+    bool hasPendingRecord() const;
+
+    /**
+     * @brief Function to write the pending record to the SD card, called by a lower priority task than add().
+     * The LogManager must have initialized the SD card, the recorder arms again afterwards.
+     */
+    void service();
+
+    /**
+     * @brief Function to read a part of a written event file, opens and closes the file for every call.
+     *
+     * @param index -> The number of the file, see getLastIndex().
+     * @param offset -> The offset in the file.
+     * @param buffer -> The destination.
+     * @param length -> The size of the destination.
+     * @return int -> The bytes read, 0 at the end of the file, -1 if the file does not exist
+     */
+    int readFile(uint32_t index, uint32_t offset, uint8_t* buffer, uint16_t length);
+
+    /**
+     * @brief Getter for the state.
+     *
+     * @return EventState -> The state.
+     */
+    EventState getState() const;
+
+    /**
+     * @brief Getter for the configuration.
+     *
+     * @return const EventConfig& -> The configuration of the last arm().
+     */
+    const EventConfig& getConfig() const;
+
+    /**
+     * @brief Getter for the time between two records.
+     *
+     * @return uint16_t -> The period in ms, 0 if not armed.
+     */
+    uint16_t getPeriodMs() const;
+
+    /**
+     * @brief Getter for the number of records per event.
+     *
+     * @return uint16_t -> The capacity of the ring.
+     */
+    uint16_t getCapacity() const;
+
+    /**
+     * @brief Getter for the number of the last written file.
+     *
+     * @return uint32_t -> The number, 0 if nothing was written since the start.
+     */
+    uint32_t getLastIndex() const;
+
+    /**
+     * @brief Getter for the cause of the last written event.
+     *
+     * @return EventSource -> The source, NONE if nothing was written.
+     */
+    EventSource getLastSource() const;
+
+    /**
+     * @brief Getter for the number of written events.
+     *
+     * @return uint32_t -> The events on the card since the start.
+     */
+    uint32_t getEventCount() const;
+
+    /**
+     * @brief Getter for the number of events that came while a record was pending.
+     *
+     * @return uint32_t -> The missed events.
+     */
+    uint32_t getMissedCount() const;
+
+    /**
+     * @brief Getter for the number of failed writes.
+     *
+     * @return uint32_t -> The failed writes, the record is lost.
+     */
+    uint32_t getWriteErrors() const;
+
+    /**
+     * @brief Getter for the path of an event file.
+     *
+     * @param index -> The number of the file.
+     * @return String -> The path, e.g. LOGS/EVT00001.BIN
+     */
+    static String getFileName(uint32_t index);
+
+private:
+    EventRecorder();
+    ~EventRecorder() = default;
+
+    /**
+     * @brief Function to find the cause of an event between the previous and this sample.
+     *
+     * @param sample -> The new sample.
+     * @return EventSource -> The enabled source that fired, NONE if none.
+     */
+    EventSource detect(const EventSample& sample);
+
+    /**
+     * @brief Function to check a sample against the threshold.
+     *
+     * @param sample -> The sample.
+     * @return true -> if the threshold channel is beyond the level
+     * @return false -> if not or not sampled
+     */
+    bool isBreach(const EventSample& sample) const;
+
+    /**
+     * @brief Function to build the header of the pending record.
+     *
+     * @param buffer -> The EVENT_HEADER_SIZE destination.
+     */
+    void buildHeader(uint8_t* buffer);
+
+    static EventRecorder* _instance;
+
+    uint8_t* _buffer = nullptr;
+    uint16_t _capacity = 0;
+    EventConfig _config = {};
+
+    volatile EventState _state = EventState::IDLE;
+    volatile bool _manual = false;
+    uint16_t _write = 0;            // next record of the ring
+    uint16_t _count = 0;            // records in the ring before the event, after it the records left
+    uint16_t _preRecords = 0;       // records before the event of the frozen ring
+    EventSource _source = EventSource::NONE;
+    uint64_t _triggerUs = 0;
+    uint32_t _triggerMs = 0;
+
+    uint8_t _previousStates = 0;
+    bool _previousBreach = false;
+    bool _hasPrevious = false;
+
+    bool _armed = false;
+    uint8_t _header[EVENT_HEADER_SIZE];
+    uint32_t _fileIndex = 0;        // last file on the card, found by the first service()
+    uint32_t _lastIndex = 0;
+    EventSource _lastSource = EventSource::NONE;
+    uint32_t _events = 0;
+    uint32_t _missed = 0;
+    uint32_t _writeErrors = 0;
+
+    static const uint32_t maxFileIndex = 99999;
+
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+};
+
+#endif // EVENTRECORDER_H
@@ -6,11 +6,116 @@
  *
  * @copyright Copyright (c) 2024
  */
+#define LOG_SOURCE LogSource::LOGMANAGER
+
 #include <logManager.h>
 #include <ptrUtils.h>
+#include <lockGuard.h>
+#include <serialMenu.h>
+#include <SPII.h>
+
+using namespace comModule;
 
 LogManager* LogManager::_instance = nullptr;
 
+/**
+ * @brief Function to read one line of a file, without the timeout of Stream::readBytesUntil() at the end of the file.
+ *
+ * @param file -> The file to read from.
+ * @param line -> The destination, the rest of a longer line is skipped.
+ * @param size -> The size of the destination.
+ * @return int -> The length of the line without line end, -1 at the end of the file.
+ */
+static int readLine(File& file, char* line, size_t size)
+{
+    int c = file.read();
+    if (c < 0)
+    {
+        return -1;
+    }
+
+    size_t length = 0;
+    while (c >= 0 && c != '\n')
+    {
+        if (c != '\r' && length + 1 < size)
+        {
+            line[length++] = static_cast<char>(c);
+        }
+        c = file.read();
+    }
+    line[length] = '\0';
+    return static_cast<int>(length);
+}
+
+/**
+ * @brief Function to split a manifest row, segment,start_ms,end_ms,bytes
+ *
+ * @param line -> The row, the commas are replaced by terminators.
+ * @param startMs -> The start of the segment.
+ * @param endMs -> The end of the segment, the largest value while it is open.
+ * @return const char* -> The segment file name, nullptr for the header or a broken row.
+ */
+static const char* parseManifestRow(char* line, uint64_t& startMs, uint64_t& endMs)
+{
+    using namespace timeModule;
+
+    char* start = strchr(line, ',');
+    char* end = start ? strchr(start + 1, ',') : nullptr;
+    if (end == nullptr || !isDigit(start[1]))
+    {
+        return nullptr;
+    }
+
+    *start = '\0';
+    *end = '\0';
+    startMs = TimeModuleInternals::stringToUint64(String(start + 1));
+    endMs = isDigit(end[1]) ? TimeModuleInternals::stringToUint64(String(end + 1)) : ~0ULL;
+    return line;
+}
+
+/**
+ * @brief Function to read one entry of a time index file.
+ *
+ * @param index -> The index file.
+ * @param entry -> The number of the entry.
+ * @param epochMs -> The time of the entry.
+ * @param offset -> The offset of the entry.
+ * @return true -> if the entry was read
+ * @return false -> if the entry could not be read
+ */
+static bool readIndexEntry(File& index, uint32_t entry, uint64_t& epochMs, uint32_t& offset)
+{
+    uint8_t raw[LOG_INDEX_ENTRY_SIZE];
+    if (!index.seek(entry * LOG_INDEX_ENTRY_SIZE) || index.read(raw, sizeof(raw)) != sizeof(raw))
+    {
+        return false;
+    }
+
+    epochMs = 0;
+    for (int8_t i = 5; i >= 0; i--)
+    {
+        epochMs = (epochMs << 8) | raw[i];
+    }
+    offset = static_cast<uint32_t>(raw[6])
+           | (static_cast<uint32_t>(raw[7]) << 8)
+           | (static_cast<uint32_t>(raw[8]) << 16)
+           | (static_cast<uint32_t>(raw[9]) << 24);
+    return true;
+}
+
+#ifdef LOG_COMPRESSED
+/**
+ * @brief Function to hash the first LOG_LZ_MIN_MATCH bytes of a match candidate.
+ *
+ * @param data -> The bytes, at least LOG_LZ_MIN_MATCH.
+ * @return uint8_t -> The hash, 0..LOG_LZ_HASH_SIZE - 1.
+ */
+static inline uint8_t lzHash(const uint8_t* data)
+{
+    return static_cast<uint8_t>(((data[0] << 4) ^ (data[1] << 2) ^ data[2]) & (LOG_LZ_HASH_SIZE - 1));
+}
+#endif
+
 Sd2Card card;
 SdVolume volume;
 SdFile root;
@@ -39,34 +144,22 @@ LogManager* LogManager::getInstance()
 void LogManager::initSDCard(int cs)
 {
 	// WHY ALL THIS? -> https://stackoverflow.com/questions/17503094/arduinio-sd-on-ethernet-shield-not-working-at-all
-    pinMode(cs, OUTPUT);
-    digitalWrite(cs, HIGH); // Disable SD-Card
-    pinMode(chipSelectPinEth, OUTPUT);
-    digitalWrite(chipSelectPinEth, HIGH);  // Disable Ethernet
-
-    if (!card.init(SPI_HALF_SPEED, cs))
-    {
-    	digitalWrite(chipSelectPinEth, LOW);  // Re-enable Ethernet before returning
-        sdCardInitialized = false;
-        return;
-    }
-
-    if (!volume.init(card))
-    {
-    	digitalWrite(chipSelectPinEth, LOW);  // Re-enable Ethernet before returning
-        sdCardInitialized = false;
-        return;
-    }
+	// the bus manager keeps the W5100 deselected while the SD card holds the bus
+    SPIBusManager::getInstance()->registerDevice(SPIDevice::SD_CARD, cs, SPISettings(4000000, MSBFIRST, SPI_MODE0), false);
+    SPIBusLock bus(SPIDevice::SD_CARD);
 
-    // Re-enable Ethernet after SD initialization
-    digitalWrite(chipSelectPinEth, LOW);
-    sdCardInitialized = true;
+    // SD.open() works on the volume of the SD class, card and volume below are only for the card info
+    sdCardInitialized = card.init(SPI_HALF_SPEED, cs) && volume.init(card) && SD.begin(cs);
 }
 
 void LogManager::shutdownSDCard()
 {
     if (logFile)
     {
+        LockGuard lock(_bufferMutex);
+        flushBuffer(true);
+
+        SPIBusLock bus(SPIDevice::SD_CARD);
         logFile.close();
     }
     else
@@ -74,6 +167,7 @@ void LogManager::shutdownSDCard()
     	SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, "Failed to close currently opened logFile: " + logFile);
     }
 
+	SPIBusLock bus(SPIDevice::SD_CARD);
 	if (isSDCardInitialized() && !card.isBusy() && !root.isOpen())
 	{
 		SD.end();
@@ -105,115 +199,764 @@ String LogManager::getCurrentTime()
 
 void LogManager::setLogFileName(const String& baseName)
 {
-    String timeStamp = getCurrentTime();
-    timeStamp.replace(":", "-");
-    timeStamp.replace("T", "_");
+    LockGuard lock(_bufferMutex);
+    if (logFile)
+    {
+        closeSegment();
+    }
+
+    // FAT without long names, up to 3 chars prefix + 5 digits . 3 chars extension
+    int dotIndex = baseName.lastIndexOf('.');
+    _segmentPrefix = (dotIndex != -1) ? baseName.substring(0, dotIndex) : baseName;
+    _segmentExtension = (dotIndex != -1) ? baseName.substring(dotIndex + 1) : String("LOG");
+    _segmentPrefix = _segmentPrefix.substring(0, 3);
+    _segmentExtension = _segmentExtension.substring(0, 3);
+    _segmentPrefix.toUpperCase();
+    _segmentExtension.toUpperCase();
+#ifdef LOG_COMPRESSED
+    _segmentExtension = String("LZ") + _segmentExtension.substring(0, 1);
+#endif
+
+    {
+        SPIBusLock bus(SPIDevice::SD_CARD);
+        SD.mkdir(LOG_DIRECTORY);
+
+        // every boot starts a new segment after the existing ones
+        _segmentIndex = 1;
+        while (_segmentIndex < maxSegmentIndex && SD.exists(segmentFileName(_segmentIndex)))
+        {
+            _segmentIndex++;
+        }
+    }
+
+    startSegment();
+}
+
+String LogManager::getLogFileName() const
+{
+    return logFileName;
+}
+
+String LogManager::segmentFileName(uint32_t index) const
+{
+    char digits[6];
+    snprintf(digits, sizeof(digits), "%05lu", static_cast<unsigned long>(index));
+
+    String name = LOG_DIRECTORY "/";
+    name += _segmentPrefix;
+    name += digits;
+    name += '.';
+    name += _segmentExtension;
+    return name;
+}
+
+void LogManager::startSegment()
+{
+    logFileName = segmentFileName(_segmentIndex);
+    _segmentStartMs = timeModule::TimeModuleInternals::getInstance()->getEpochMillis();
+
+    _blockStart = 0;
+    _bufferLength = 0;
+    _flushedLength = 0;
+    _pendingSync = false;
+    _syncBlock = 0xFFFFFFFFUL;
+    _nextIndexOffset = 0;
 
-    baseLogFileName = timeStamp + "_" + baseName;
-    logFileName = baseLogFileName;
+    appendManifest(_segmentStartMs, 0, 0);
 }
 
-void LogManager::renameFile(const String& oldName, const String& newName)
+void LogManager::closeSegment()
 {
-    pinMode(chipSelectPinEth, OUTPUT);            // Ensure CS pin is output
-    digitalWrite(chipSelectPinEth, HIGH);         // Disable W5100
+    flushBuffer(true);
+    uint32_t bytes = _blockStart + _bufferLength;
 
-    File oldFile = SD.open(oldName);
-    if (!oldFile)
     {
-        digitalWrite(chipSelectPinEth, LOW);  // Re-enable Ethernet before returning
-        return;
+        SPIBusLock bus(SPIDevice::SD_CARD);
+        logFile.close();
+    }
+
+    appendManifest(_segmentStartMs, timeModule::TimeModuleInternals::getInstance()->getEpochMillis(), bytes);
+}
+
+void LogManager::appendManifest(uint64_t startMs, uint64_t endMs, uint32_t bytes)
+{
+    using namespace timeModule;
+    SPIBusLock bus(SPIDevice::SD_CARD);
+
+    File manifest = SD.open(LOG_MANIFEST_FILE, FILE_WRITE);
+    if (manifest)
+    {
+        if (manifest.size() == 0)
+        {
+            manifest.println(F("segment,start_ms,end_ms,bytes"));
+        }
+
+        String row = logFileName.substring(logFileName.lastIndexOf('/') + 1);
+        row += ',';
+        row += TimeModuleInternals::uint64ToString(startMs);
+        row += ',';
+        if (endMs != 0)
+        {
+            row += TimeModuleInternals::uint64ToString(endMs);
+            row += ',';
+            row += String(static_cast<unsigned long>(bytes));
+        }
+        else
+        {
+            row += ',';
+        }
+        manifest.println(row);
+        manifest.close();
+    }
+}
+
+bool LogManager::writeToLogFile(const String& logMessage, bool flushNow)
+{
+    static const uint8_t lineEnd[] = { '\r', '\n' };
+
+    if (!isSDCardInitialized())
+    {
+        return false;
+    }
+
+    LockGuard lock(_bufferMutex);
+    if (!openLogFile())
+    {
+        return false;
+    }
+
+    noteMessageStart(timeModule::TimeModuleInternals::getInstance()->getEpochMillis());
+    bool written = appendData(reinterpret_cast<const uint8_t*>(logMessage.c_str()), logMessage.length())
+                && appendData(lineEnd, sizeof(lineEnd));
+
+    if (written && flushNow)
+    {
+        written = flushBuffer(true);
+    }
+    rotateIfFull();
+    return written;
+}
+
+bool LogManager::writeToLogFile(const uint8_t* data, size_t length, bool flushNow)
+{
+    if (!isSDCardInitialized())
+    {
+        return false;
+    }
+
+    LockGuard lock(_bufferMutex);
+    if (!openLogFile())
+    {
+        return false;
+    }
+
+    noteMessageStart(timeModule::TimeModuleInternals::getInstance()->getEpochMillis());
+    bool written = appendData(data, length);
+    if (written && flushNow)
+    {
+        written = flushBuffer(true);
+    }
+    rotateIfFull();
+    return written;
+}
+
+void LogManager::setBinaryRecords(bool enable)
+{
+    _binaryRecords = enable;
+}
+
+bool LogManager::isBinaryRecords() const
+{
+    return _binaryRecords;
+}
+
+bool LogManager::writeRecord(uint64_t epochMs, uint8_t level, uint8_t source, uint8_t type,
+                             const uint8_t* payload, size_t length, bool flushNow)
+{
+    if (!isSDCardInitialized())
+    {
+        return false;
+    }
+
+    if (length > 255)
+    {
+        length = 255;
     }
 
-    File newFile = SD.open(newName, FILE_WRITE);
-    if (!newFile)
+    LockGuard lock(_bufferMutex);
+    if (!openLogFile())
+    {
+        return false;
+    }
+
+    noteMessageStart(epochMs);
+
+    bool written = true;
+    if (_syncBlock != _blockStart)
+    {
+        uint8_t sync[LOG_SYNC_SIZE] = { 0xB5, 0x5B, 'S', 'Y' };
+        packEpochMillis(epochMs, &sync[4]);
+        sync[10] = crc8(0, &sync[4], 6);
+        written = appendData(sync, sizeof(sync));
+        _syncBlock = _blockStart;
+    }
+
+    uint8_t header[LOG_RECORD_HEADER_SIZE];
+    header[0] = LOG_RECORD_MAGIC;
+    header[1] = static_cast<uint8_t>(length);
+    packEpochMillis(epochMs, &header[2]);
+    header[8] = level;
+    header[9] = source;
+    header[10] = type;
+
+    uint8_t crc = crc8(0, &header[1], sizeof(header) - 1);
+    crc = crc8(crc, payload, length);
+
+    written = written
+           && appendData(header, sizeof(header))
+           && appendData(payload, length)
+           && appendData(&crc, 1);
+
+    if (written && flushNow)
+    {
+        written = flushBuffer(true);
+    }
+    rotateIfFull();
+    return written;
+}
+
+uint8_t LogManager::crc8(uint8_t crc, const uint8_t* data, size_t length)
+{
+    while (length--)
+    {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void LogManager::packEpochMillis(uint64_t epochMs, uint8_t* out)
+{
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        out[i] = static_cast<uint8_t>(epochMs >> (8 * i));
+    }
+}
+
+CompressionStats LogManager::getCompressionStats()
+{
+    LockGuard lock(_bufferMutex);
+    return _lzStats;
+}
+
+bool LogManager::appendData(const uint8_t* data, size_t length)
+{
+#ifdef LOG_COMPRESSED
+    while (length > 0)
+    {
+        size_t chunk = LOG_LZ_FRAME_SIZE - _lzLength;
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+
+        memcpy(&_lzInput[_lzLength], data, chunk);
+        _lzLength += chunk;
+        data += chunk;
+        length -= chunk;
+        _pendingSync = true;
+
+        if (_lzLength == LOG_LZ_FRAME_SIZE && !packFrame())
+        {
+            return false;
+        }
+    }
+    return true;
+#else
+    return appendToBuffer(data, length);
+#endif
+}
+
+bool LogManager::packFrame()
+{
+#ifdef LOG_COMPRESSED
+    if (_lzLength == 0)
+    {
+        return true;
+    }
+
+    const unsigned long started = micros();
+    const size_t rawLength = _lzLength;
+    const uint32_t packedStart = _blockStart + _bufferLength;
+    _lzLength = 0;
+
+    // frames are where decoding can start
+    indexBoundary(_lzFirstMs, packedStart);
+
+    uint8_t header[4] = { 'L', 'Z', static_cast<uint8_t>(rawLength), static_cast<uint8_t>(rawLength >> 8) };
+    bool written = appendToBuffer(header, sizeof(header));
+
+    // flag byte + 8 items of at most 2 bytes
+    uint8_t group[17];
+    uint8_t groupLength = 1;
+    uint8_t items = 0;
+    group[0] = 0;
+
+    // chains of the positions with the same hash of their first LOG_LZ_MIN_MATCH bytes, newest first
+    memset(_lzHead, 0, sizeof(_lzHead));
+
+    size_t pos = 0;
+    while (written && pos < rawLength)
+    {
+        // longest match among the last LOG_LZ_MAX_CHAIN positions of the chain, the frame is the window
+        size_t bestLength = 0;
+        size_t bestDistance = 0;
+        size_t maxLength = rawLength - pos;
+        if (maxLength > LOG_LZ_MAX_MATCH)
+        {
+            maxLength = LOG_LZ_MAX_MATCH;
+        }
+
+        size_t next = (maxLength >= LOG_LZ_MIN_MATCH) ? _lzHead[lzHash(&_lzInput[pos])] : 0;
+        for (uint8_t chain = 0; next != 0 && chain < LOG_LZ_MAX_CHAIN && bestLength < maxLength; chain++)
+        {
+            const size_t candidate = next - 1;
+            next = (_lzPrev[candidate] != 0) ? next - _lzPrev[candidate] : 0;
+
+            // cheap reject, a longer match must also agree at the current best length
+            if (_lzInput[candidate] != _lzInput[pos] ||
+                _lzInput[candidate + bestLength] != _lzInput[pos + bestLength])
+            {
+                continue;
+            }
+
+            size_t length = 1;
+            while (length < maxLength && _lzInput[candidate + length] == _lzInput[pos + length])
+            {
+                length++;
+            }
+            if (length > bestLength)
+            {
+                bestLength = length;
+                bestDistance = pos - candidate;
+            }
+        }
+
+        size_t step = 1;
+        if (bestLength >= LOG_LZ_MIN_MATCH)
+        {
+            group[0] |= static_cast<uint8_t>(1 << items);
+            uint16_t match = static_cast<uint16_t>((bestDistance - 1) | ((bestLength - LOG_LZ_MIN_MATCH) << 9));
+            group[groupLength++] = static_cast<uint8_t>(match);
+            group[groupLength++] = static_cast<uint8_t>(match >> 8);
+            step = bestLength;
+        }
+        else
+        {
+            group[groupLength++] = _lzInput[pos];
+        }
+
+        // the covered positions join the chains too, later matches may start inside a match
+        for (const size_t end = pos + step; pos < end; pos++)
+        {
+            if (pos + LOG_LZ_MIN_MATCH <= rawLength)
+            {
+                const uint8_t hash = lzHash(&_lzInput[pos]);
+                _lzPrev[pos] = (_lzHead[hash] != 0) ? static_cast<uint16_t>(pos + 1 - _lzHead[hash]) : 0;
+                _lzHead[hash] = static_cast<uint16_t>(pos + 1);
+            }
+        }
+
+        if (++items == 8)
+        {
+            written = appendToBuffer(group, groupLength);
+            group[0] = 0;
+            groupLength = 1;
+            items = 0;
+        }
+    }
+
+    uint8_t crc = crc8(0, _lzInput, rawLength);
+    if (items > 0)
+    {
+        written = written && appendToBuffer(group, groupLength);
+    }
+    written = written && appendToBuffer(&crc, 1);
+
+    _lzStats.rawBytes += rawLength;
+    _lzStats.packedBytes += (_blockStart + _bufferLength) - packedStart;
+    _lzStats.frames++;
+    _lzStats.cpuMicros += micros() - started;
+    return written;
+#else
+    return true;
+#endif
+}
+
+void LogManager::noteMessageStart(uint64_t epochMs)
+{
+#ifdef LOG_COMPRESSED
+    if (_lzLength == 0)
+    {
+        _lzFirstMs = epochMs;
+    }
+#else
+    indexBoundary(epochMs, _blockStart + _bufferLength);
+#endif
+}
+
+void LogManager::indexBoundary(uint64_t epochMs, uint32_t offset)
+{
+    if (offset < _nextIndexOffset)
     {
-        oldFile.close();
-        digitalWrite(chipSelectPinEth, LOW);  // Re-enable Ethernet before returning
         return;
     }
+    _nextIndexOffset = offset + LOG_INDEX_INTERVAL;
 
-    while (oldFile.available())
+    uint8_t entry[LOG_INDEX_ENTRY_SIZE];
+    packEpochMillis(epochMs, entry);
+    for (uint8_t i = 0; i < 4; i++)
     {
-        newFile.write(oldFile.read());
+        entry[6 + i] = static_cast<uint8_t>(offset >> (8 * i));
     }
 
-    oldFile.close();
-    newFile.close();
+    SPIBusLock bus(SPIDevice::SD_CARD);
+    File index = SD.open(indexFileName(logFileName.c_str() + strlen(LOG_DIRECTORY) + 1), FILE_WRITE);
+    if (index)
+    {
+        index.write(entry, sizeof(entry));
+        index.close();
+    }
+}
 
-    SD.remove(oldName);
-    digitalWrite(chipSelectPinEth, LOW);  // Enable W5100 (Ethernet)
+String LogManager::indexFileName(const char* file)
+{
+    String name = LOG_DIRECTORY "/";
+    name += file;
+
+    int dotIndex = name.lastIndexOf('.');
+    if (dotIndex != -1)
+    {
+        name = name.substring(0, dotIndex);
+    }
+    name += F(".IDX");
+    return name;
 }
 
-bool LogManager::writeToLogFile(const String& logMessage)
+bool LogManager::findNextLogRange(uint64_t fromMs, uint64_t toMs, LogRange& range)
 {
     if (!isSDCardInitialized())
     {
         return false;
     }
 
-    pinMode(chipSelectPinEth, OUTPUT);            // Ensure CS pin is output
-    digitalWrite(chipSelectPinEth, HIGH);         // Disable W5100
+    LockGuard lock(_bufferMutex);
 
+    // the segment being written has its last block in the buffer
     if (logFile)
     {
-        logFile.close();
+        flushBuffer(true);
     }
 
-    logFile = SD.open(logFileName, FILE_WRITE);
-    if (!logFile)
+    SPIBusLock bus(SPIDevice::SD_CARD);
+    File manifest = SD.open(LOG_MANIFEST_FILE, FILE_READ);
+    if (!manifest)
     {
-        digitalWrite(chipSelectPinEth, LOW);  // Enable W5100 (Ethernet)
         return false;
     }
 
-    if (logFile.size() > maxLogFileSize)
+    // a segment has a row when it is started and one when it is closed, only the last one counts
+    char line[64];
+    char pending[64] = "";
+    uint16_t row = 0;
+    uint16_t pendingRow = 0;
+    bool found = false;
+
+    while (!found)
     {
-        logFile.close();
+        int length = readLine(manifest, line, sizeof(line));
+        if (length >= 0)
+        {
+            row++;
+        }
+
+        const char* comma = strchr(pending, ',');
+        bool sameSegment = length >= 0 && comma != nullptr && strncmp(pending, line, comma - pending + 1) == 0;
 
-        int index = 1;
-        String newFileName;
-        do
+        if (pending[0] != '\0' && !sameSegment && pendingRow > range.manifestRow)
         {
-            newFileName = baseLogFileName;
-            int dotIndex = newFileName.lastIndexOf(".");
-            if (dotIndex != -1)
+            uint64_t startMs = 0;
+            uint64_t endMs = 0;
+            const char* file = parseManifestRow(pending, startMs, endMs);
+
+            if (file != nullptr && startMs <= toMs && endMs >= fromMs && strlen(file) < sizeof(range.file))
             {
-                newFileName = newFileName.substring(0, dotIndex) + "_" + String(index++) + newFileName.substring(dotIndex);
+                strcpy(range.file, file);
+                range.manifestRow = pendingRow;
+                found = true;
             }
-            else
+        }
+
+        if (length < 0)
+        {
+            break;
+        }
+        strcpy(pending, line);
+        pendingRow = row;
+    }
+    manifest.close();
+
+    if (found)
+    {
+        File segment = SD.open(String(LOG_DIRECTORY "/") + range.file, FILE_READ);
+        range.offset = 0;
+        range.end = segment ? segment.size() : 0;
+        segment.close();
+
+        findIndexOffset(range.file, fromMs, false, range.offset);
+        findIndexOffset(range.file, toMs, true, range.end);
+    }
+    return found;
+}
+
+void LogManager::findIndexOffset(const char* file, uint64_t epochMs, bool after, uint32_t& offset)
+{
+    File index = SD.open(indexFileName(file), FILE_READ);
+    if (!index)
+    {
+        return;
+    }
+
+    // first entry after epochMs, the entries are in write order
+    uint32_t count = index.size() / LOG_INDEX_ENTRY_SIZE;
+    uint32_t low = 0;
+    uint32_t high = count;
+    uint64_t entryMs = 0;
+    uint32_t entryOffset = 0;
+
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if (!readIndexEntry(index, mid, entryMs, entryOffset))
+        {
+            break;
+        }
+
+        if (entryMs <= epochMs)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    uint32_t entry = after ? low : low - 1;
+    if ((after ? low < count : low > 0) && readIndexEntry(index, entry, entryMs, entryOffset))
+    {
+        offset = entryOffset;
+    }
+    index.close();
+}
+
+int LogManager::readLogRange(LogRange& range, uint8_t* buffer, size_t length)
+{
+    if (!isSDCardInitialized())
+    {
+        return -1;
+    }
+
+    LockGuard lock(_bufferMutex);
+    SPIBusLock bus(SPIDevice::SD_CARD);
+
+    if (range.offset >= range.end)
+    {
+        if (_readFile)
+        {
+            _readFile.close();
+        }
+        return 0;
+    }
+
+    // the file stays open between the chunks of a range
+    if (!_readFile || strcmp(_readFileName, range.file) != 0)
+    {
+        if (_readFile)
+        {
+            _readFile.close();
+        }
+        _readFile = SD.open(String(LOG_DIRECTORY "/") + range.file, FILE_READ);
+        strcpy(_readFileName, range.file);
+    }
+
+    int count = -1;
+    if (_readFile && _readFile.seek(range.offset))
+    {
+        if (length > range.end - range.offset)
+        {
+            length = range.end - range.offset;
+        }
+        count = _readFile.read(buffer, static_cast<uint16_t>(length));
+    }
+
+    if (count <= 0)
+    {
+        return -1;
+    }
+    range.offset += count;
+    return count;
+}
+
+void LogManager::rotateIfFull()
+{
+    if (logFile && _blockStart + _bufferLength >= static_cast<uint32_t>(maxLogFileSize))
+    {
+        rotateLogFile();
+    }
+}
+
+bool LogManager::appendToBuffer(const uint8_t* data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t chunk = LOG_BUFFER_SIZE - _bufferLength;
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+
+        memcpy(&_writeBuffer[_bufferLength], data, chunk);
+        _bufferLength += chunk;
+        data += chunk;
+        length -= chunk;
+        _pendingSync = true;
+
+        if (_bufferLength == LOG_BUFFER_SIZE && !flushBuffer(false))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogManager::openLogFile()
+{
+    if (logFile)
+    {
+        return true;
+    }
+
+    SPIBusLock bus(SPIDevice::SD_CARD);
+
+    // no O_APPEND, the last partial block gets rewritten in place
+    logFile = SD.open(logFileName, O_READ | O_WRITE | O_CREAT);
+    if (!logFile)
+    {
+        return false;
+    }
+
+    // continue in the last block of an existing file, keeps every write block aligned
+    uint32_t fileSize = logFile.size();
+    _blockStart = fileSize - (fileSize % LOG_BUFFER_SIZE);
+    _bufferLength = 0;
+
+    if (fileSize > _blockStart && logFile.seek(_blockStart))
+    {
+        int tail = logFile.read(_writeBuffer, static_cast<uint16_t>(fileSize - _blockStart));
+        _bufferLength = (tail > 0) ? static_cast<size_t>(tail) : 0;
+    }
+    _flushedLength = _bufferLength;
+    _pendingSync = false;
+    return true;
+}
+
+bool LogManager::flushBuffer(bool sync)
+{
+    if (!openLogFile())
+    {
+        return false;
+    }
+
+    // staged data goes out as a short frame, so a timed flush still reaches the card
+    if (sync && !packFrame())
+    {
+        return false;
+    }
+
+    if (_bufferLength > _flushedLength || (sync && _pendingSync))
+    {
+        bool written = true;
+        {
+            SPIBusLock bus(SPIDevice::SD_CARD);
+            if (_bufferLength > _flushedLength)
             {
-                newFileName += "_" + String(index++);
+                written = logFile.seek(_blockStart) && logFile.write(_writeBuffer, _bufferLength) == _bufferLength;
             }
-        } while (SD.exists(newFileName));
 
-        renameFile(logFileName, newFileName);
+            // updates the directory entry, only on the timer or on request, not for every full block
+            if (written && sync)
+            {
+                logFile.flush();
+                _pendingSync = false;
+            }
+        }
 
-        logFile = SD.open(logFileName, FILE_WRITE);
-        if (!logFile)
+        if (!written)
         {
-            digitalWrite(10, LOW);  // Enable W5100 (Ethernet)
             return false;
         }
+        _flushedLength = _bufferLength;
     }
 
-    logFile.println(logMessage);
-    logFile.flush();
-    logFile.close();
-
-    digitalWrite(chipSelectPinEth, LOW);  // Enable W5100 (Ethernet)
+    if (sync)
+    {
+        _lastFlushMillis = millis();
+    }
 
+    if (_bufferLength == LOG_BUFFER_SIZE)
+    {
+        _blockStart += LOG_BUFFER_SIZE;
+        _bufferLength = 0;
+        _flushedLength = 0;
+    }
     return true;
 }
 
+void LogManager::rotateLogFile()
+{
+    closeSegment();
+
+    if (_segmentIndex < maxSegmentIndex)
+    {
+        _segmentIndex++;
+    }
+    startSegment();
+}
+
 void LogManager::flushLogs()
 {
 	if (logFile)
 	{
-		logFile.flush();
+		LockGuard lock(_bufferMutex);
+		flushBuffer(true);
 	}
 	else
 	{
-		SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("No log file currently open to flush."));
+		LOG_TOKEN(ERROR, LOG_FLUSH_NO_FILE);
+	}
+}
+
+void LogManager::flushIfDue()
+{
+	if (!logFile || !_pendingSync) return;
+
+	if (millis() - _lastFlushMillis >= LOG_FLUSH_INTERVAL_MS)
+	{
+		LockGuard lock(_bufferMutex);
+		flushBuffer(true);
 	}
 }
@@ -15,6 +15,81 @@
 #include <SD.h>
 #include <SPI.h>
 #include <timeModule.h>
+#include <frt.h>
+
+#define LOG_DIRECTORY "LOGS"
+#define LOG_MANIFEST_FILE "LOGS/MANIFEST.CSV"
+
+/*
+ * Binary record format, see setBinaryRecords(), all numbers little endian:
+ *   record: 0xB1 | length | epoch ms (6) | level | source | type | payload (length) | crc8
+ *   sync:   0xB5 0x5B 'S' 'Y' | epoch ms (6) | crc8
+ * The crc8 (polynomial 0x07) covers all bytes after the magic byte(s).
+ * A sync marker precedes the first record that starts in a new 512 byte block,
+ * a decoder can pick up again at the next block after a torn write.
+ */
+#define LOG_RECORD_MAGIC 0xB1
+#define LOG_RECORD_HEADER_SIZE 11
+#define LOG_RECORD_TEXT 0   // payload: message without prefix
+#define LOG_RECORD_TOKEN 1  // payload: token (2) | packed arguments
+#define LOG_SYNC_SIZE 11
+
+/*
+ * Built with -DLOG_COMPRESSED the log data is packed with LZSS before it goes into the block buffer.
+ * Every LOG_LZ_FRAME_SIZE bytes, and at every timed or requested flush, the staged data becomes one frame:
+ *   'L' 'Z' | raw length (2) | items | crc8 of the raw data
+ * Items come in groups of up to 8 behind a flag byte, bit i set = item i is a match:
+ *   literal: 1 byte
+ *   match:   2 bytes, bits 0..8 distance - 1, bits 9..15 length - LOG_LZ_MIN_MATCH,
+ *            copied from the data already decoded
+ * Matches only point into their own frame, so every frame decodes on its own,
+ * a torn frame costs at most LOG_LZ_FRAME_SIZE bytes of log.
+ * Decode with eSW/utils/logTool: logTool unpack LOG00001.LZT
+ *
+ * Measured on the host, 400 mixed WARNING/ERROR/CRITICAL messages (27.5 kB as text, 12.9 kB as records):
+ *   full frames:                text 1.9:1, binary records 1.7:1
+ *   2 s flush, sparse messages: text 1.6:1, binary records 1.2:1 (a flush packs the partial frame)
+ * The search follows a hash chain of the first LOG_LZ_MIN_MATCH bytes and tries at most LOG_LZ_MAX_CHAIN
+ * candidates per position. For the messages above that is ~1.2k candidates per kB, the search of the whole
+ * frame before tried ~69k, and the output grew by 1 byte of 17.5 kB. Host x86-64, best of 5 runs:
+ * 31 us per kB of text, 44 us per kB of records, the whole frame search took 97 and 129 us.
+ * The figure on the Mega is getCompressionStats().cpuMicros / rawBytes, spent in the logger task.
+ * RAM: LOG_LZ_FRAME_SIZE bytes of staging, 2 * LOG_LZ_FRAME_SIZE for the chains, whose links span the whole
+ * frame, and 2 * LOG_LZ_HASH_SIZE bytes for their heads, 1664 bytes in all, only with LOG_COMPRESSED.
+ */
+/*
+ * Every segment gets a sparse time index next to it, e.g. LOGS/LOG00001.IDX for LOGS/LOG00001.TXT.
+ * An entry is written at the first line, record or frame that starts LOG_INDEX_INTERVAL bytes
+ * after the previous entry:
+ *   epoch ms (6) | offset in the segment (4)
+ * Reading can start at any indexed offset, the entries are in write order.
+ */
+#define LOG_INDEX_INTERVAL 4096UL
+#define LOG_INDEX_ENTRY_SIZE 10
+
+#define LOG_LZ_FRAME_SIZE 512
+#define LOG_LZ_MIN_MATCH 3
+#define LOG_LZ_MAX_MATCH (LOG_LZ_MIN_MATCH + 127)
+#define LOG_LZ_HASH_SIZE 64     // chain heads, a power of two
+#define LOG_LZ_MAX_CHAIN 16     // candidates tried per position
+
+/// @brief Counters of the log compression, all zero without LOG_COMPRESSED. \struct CompressionStats
+struct CompressionStats
+{
+    uint32_t rawBytes;
+    uint32_t packedBytes;
+    uint32_t frames;
+    uint32_t cpuMicros;
+};
+
+/// @brief Byte range of one segment for a time range, see LogManager::findNextLogRange(). \struct LogRange
+struct LogRange
+{
+    char file[13];          // segment file in LOG_DIRECTORY, 8.3
+    uint32_t offset;        // next byte to read
+    uint32_t end;           // end of the range, exclusive
+    uint16_t manifestRow;   // manifest row of the segment, 0 to start a search
+};
 
 /// @brief Class which handle the printed log messages, maps aka parses them and saves them to the SD card. \class LogMapper
 class LogManager
@@ -41,10 +116,15 @@ public:
     void shutdownSDCard();
 
     /**
-     * @brief Function to flush the current Logs in special cases
+     * @brief Function to flush the current Logs in special cases, writes the buffered data to the card.
      */
     void flushLogs();
 
+    /**
+     * @brief Function to flush the buffered data once LOG_FLUSH_INTERVAL_MS passed, called by the logger task.
+     */
+    void flushIfDue();
+
     /**
      * @brief Function to check if the SD card is initialized.
      * 
@@ -60,41 +140,287 @@ public:
     static String getCurrentTime();
 
     /**
-     * @brief Set the Log File Name object
-     * 
-     * @param fileName -> The file name to set the log file name to.
+     * @brief Set the Log File Name object, starts a new numbered segment in LOG_DIRECTORY.
+     * The name is reduced to 8.3, e.g. "log.txt" -> LOGS/LOG00001.TXT, LOGS/LOG00002.TXT, ...
+     * Built with LOG_COMPRESSED the extension becomes LZ and its first letter, e.g. LOGS/LOG00001.LZT
+     *
+     * @param fileName -> The file name the segment names are derived from.
      */
     void setLogFileName(const String& fileName);
 
     /**
      * @brief Function to write a log message to the log file.
-     * 
+     * The message goes into a 512 byte buffer that is written to the card as one block when it is full,
+     * after LOG_FLUSH_INTERVAL_MS or right away if flushNow is set.
+     *
      * @param logMessage -> The log message to write to the log file.
+     * @param flushNow -> Whether to write the buffer to the card right away, e.g. for CRITICAL messages.
      * @return true -> if the log message was written successfully
      * @return false -> if the log message was not written successfully
      */
-    bool writeToLogFile(const String& logMessage);
+    bool writeToLogFile(const String& logMessage, bool flushNow = false);
 
     /**
-     * @brief Function to rename the currently written to file
+     * @brief Function to write raw bytes to the log file, e.g. binary log frames.
      *
-     * @param oldName -> This is the oldName of the file
-     * @param newName -> This is the newName of the file
+     * @param data -> The bytes to write.
+     * @param length -> The number of bytes to write.
+     * @param flushNow -> Whether to write the buffer to the card right away.
+     * @return true -> if the data was written successfully
+     * @return false -> if the data was not written successfully
      */
-    void renameFile(const String& oldName, const String& newName);
+    bool writeToLogFile(const uint8_t* data, size_t length, bool flushNow = false);
+
+    /**
+     * @brief Function to switch the log file to binary records, call it before setLogFileName().
+     *
+     * @param enable -> Whether writeRecord() is used instead of text lines.
+     */
+    void setBinaryRecords(bool enable);
+
+    /**
+     * @brief Function to check if the log file holds binary records.
+     *
+     * @return true -> if messages are written with writeRecord()
+     * @return false -> if messages are written as text lines
+     */
+    bool isBinaryRecords() const;
+
+    /**
+     * @brief Function to write one binary record to the log file, adds a sync marker at every new block.
+     *
+     * @param epochMs -> The wall time the message was logged.
+     * @param level -> The SerialMenu::OutputLevel of the message.
+     * @param source -> The LogSource of the message.
+     * @param type -> LOG_RECORD_TEXT or LOG_RECORD_TOKEN.
+     * @param payload -> The payload bytes.
+     * @param length -> The number of payload bytes, at most 255.
+     * @param flushNow -> Whether to write the buffer to the card right away.
+     * @return true -> if the record was written successfully
+     * @return false -> if the record was not written successfully
+     */
+    bool writeRecord(uint64_t epochMs, uint8_t level, uint8_t source, uint8_t type,
+                     const uint8_t* payload, size_t length, bool flushNow = false);
+
+    /**
+     * @brief Function to find the next segment with messages between fromMs and toMs.
+     * The time range of the segments comes from the manifest, the byte range from their time index.
+     * The range starts at the last indexed point before fromMs, so it can hold up to
+     * LOG_INDEX_INTERVAL bytes of older messages, the same after toMs.
+     *
+     * @param fromMs -> Start of the time range, ms since 1970.
+     * @param toMs -> End of the time range, ms since 1970.
+     * @param range -> Set manifestRow to 0 for the first call, keep it for the following ones.
+     * @return true -> if a segment was found, range holds its byte range
+     * @return false -> if there are no more segments in the time range
+     */
+    bool findNextLogRange(uint64_t fromMs, uint64_t toMs, LogRange& range);
+
+    /**
+     * @brief Function to read the next chunk of a range, the SD card is only locked for this chunk,
+     * so the caller can send it over the Ethernet chip on the same SPI bus in between.
+     *
+     * @param range -> The range from findNextLogRange(), offset is advanced.
+     * @param buffer -> The destination.
+     * @param length -> The size of the destination.
+     * @return int -> The number of bytes read, 0 at the end of the range, -1 on a read error.
+     */
+    int readLogRange(LogRange& range, uint8_t* buffer, size_t length);
+
+    /**
+     * @brief Getter for the counters of the log compression, gives the ratio and the CPU time per kB.
+     *
+     * @return CompressionStats -> The counters since boot.
+     */
+    CompressionStats getCompressionStats();
+
+    /**
+     * @brief Getter for the file name of the segment currently written to.
+     *
+     * @return String -> The path of the current segment.
+     */
+    String getLogFileName() const;
 
 private:
     LogManager();
+
+    /**
+     * @brief Function to append to the write buffer, writes every full block to the card.
+     *
+     * @param data -> The bytes to write.
+     * @param length -> The number of bytes to write.
+     * @return true -> if the data was written successfully
+     * @return false -> if the data was not written successfully
+     */
+    bool appendToBuffer(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Function to append log data, goes through the compressor with LOG_COMPRESSED.
+     *
+     * @param data -> The bytes to write.
+     * @param length -> The number of bytes to write.
+     * @return true -> if the data was written successfully
+     * @return false -> if the data was not written successfully
+     */
+    bool appendData(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Function to pack the staged data into one LZ frame in the write buffer.
+     *
+     * @return true -> if the frame was written successfully or nothing was staged
+     * @return false -> if the frame was not written successfully
+     */
+    bool packFrame();
+
+    /**
+     * @brief Function to note the start of a line, record or frame, adds a time index entry
+     * once LOG_INDEX_INTERVAL bytes were written since the last one.
+     *
+     * @param epochMs -> The wall time of the first message at the offset.
+     * @param offset -> The offset in the segment where decoding can start.
+     */
+    void indexBoundary(uint64_t epochMs, uint32_t offset);
+
+    /**
+     * @brief Function to note the start of a message, a boundary for the time index.
+     *
+     * @param epochMs -> The wall time of the message.
+     */
+    void noteMessageStart(uint64_t epochMs);
+
+    /**
+     * @brief Function to find the byte offset of a time in a segment, binary search in its time index.
+     *
+     * @param file -> The segment file name.
+     * @param epochMs -> The time to look for.
+     * @param after -> false: last entry at or before epochMs, true: first entry after epochMs.
+     * @param offset -> The offset found, unchanged if there is no such entry.
+     */
+    void findIndexOffset(const char* file, uint64_t epochMs, bool after, uint32_t& offset);
+
+    /**
+     * @brief Function to build the index file name of a segment, LOG00001.TXT -> LOGS/LOG00001.IDX
+     *
+     * @param file -> The segment file name without directory.
+     * @return String -> The path of the index file.
+     */
+    static String indexFileName(const char* file);
+
+    /**
+     * @brief Function to start the next segment once the current one is full, only called between two writes,
+     * so no record, line or frame is split over two segments.
+     */
+    void rotateIfFull();
+
+    /**
+     * @brief Function to open the log file once, the buffer is aligned to the last block of the file.
+     *
+     * @return true -> if the log file is open
+     * @return false -> if the log file could not be opened
+     */
+    bool openLogFile();
+
+    /**
+     * @brief Function to write the buffer to its block in the log file.
+     * A partial block stays in the buffer and is written again at the same position until it is full,
+     * so every write to the card starts at a block boundary.
+     *
+     * @param sync -> Whether to also update the directory entry, so the data survives a power loss.
+     * @return true -> if the buffer was written successfully
+     * @return false -> if the buffer was not written successfully
+     */
+    bool flushBuffer(bool sync);
+
+    /**
+     * @brief Function to close the full segment and continue in the next one, costs the same for any file size.
+     */
+    void rotateLogFile();
+
+    /**
+     * @brief Function to start the segment _segmentIndex and record its start in the manifest.
+     */
+    void startSegment();
+
+    /**
+     * @brief Function to write and close the current segment and record its time range in the manifest.
+     */
+    void closeSegment();
+
+    /**
+     * @brief Function to build the path of a segment.
+     *
+     * @param index -> The number of the segment.
+     * @return String -> The path, e.g. LOGS/LOG00001.TXT
+     */
+    String segmentFileName(uint32_t index) const;
+
+    /**
+     * @brief Function to append a row to the manifest, segment,start_ms,end_ms,bytes.
+     * A segment gets a row without end when it is started and a complete one when it is closed,
+     * the last row of a segment is the valid one.
+     *
+     * @param startMs -> The wall time the segment was started.
+     * @param endMs -> The wall time the segment was closed, 0 while it is open.
+     * @param bytes -> The size of the closed segment.
+     */
+    void appendManifest(uint64_t startMs, uint64_t endMs, uint32_t bytes);
+
+    /**
+     * @brief Function to update a crc8 with polynomial 0x07.
+     *
+     * @param crc -> The crc so far, 0 to start.
+     * @param data -> The bytes to add.
+     * @param length -> The number of bytes.
+     * @return uint8_t -> The updated crc.
+     */
+    static uint8_t crc8(uint8_t crc, const uint8_t* data, size_t length);
+
+    /**
+     * @brief Function to store a wall time as 6 bytes little endian.
+     *
+     * @param epochMs -> The wall time in milliseconds.
+     * @param out -> The 6 byte destination.
+     */
+    static void packEpochMillis(uint64_t epochMs, uint8_t* out);
+
     ~LogManager();
 
     static LogManager* _instance;
     File logFile;
     bool sdCardInitialized = false;
     String logFileName;
-    String baseLogFileName;
-    
-    static const int chipSelectPinEth = 10; // Default CS pin for SD card
-    static const long maxLogFileSize = 104857600L; // 100MB Logfile size
+    String _segmentPrefix;
+    String _segmentExtension;
+    uint32_t _segmentIndex = 0;
+    uint64_t _segmentStartMs = 0;
+
+    static const long maxLogFileSize = 104857600L; // 100MB segment size
+    static const uint32_t maxSegmentIndex = 99999; // five digits keep the names 8.3
+
+    static const size_t LOG_BUFFER_SIZE = 512; // One SD block
+    static const unsigned long LOG_FLUSH_INTERVAL_MS = 2000;
+
+    uint8_t _writeBuffer[LOG_BUFFER_SIZE];
+    size_t _bufferLength = 0;
+    size_t _flushedLength = 0;
+    uint32_t _blockStart = 0;
+    unsigned long _lastFlushMillis = 0;
+    bool _pendingSync = false;
+    bool _binaryRecords = false;
+    uint32_t _syncBlock = 0xFFFFFFFFUL; // block that got the last sync marker
+    CompressionStats _lzStats = {};
+    uint32_t _nextIndexOffset = 0;
+    File _readFile;
+    char _readFileName[13] = "";
+
+#ifdef LOG_COMPRESSED
+    uint8_t _lzInput[LOG_LZ_FRAME_SIZE];
+    uint16_t _lzHead[LOG_LZ_HASH_SIZE];     // newest position + 1 per hash, 0 = none
+    uint16_t _lzPrev[LOG_LZ_FRAME_SIZE];    // distance to the previous position with the same hash, 0 = none
+    size_t _lzLength = 0;
+    uint64_t _lzFirstMs = 0; // time of the first message in the staged frame
+#endif
+    frt::Mutex _bufferMutex;
 
     LogManager(const LogManager&) = delete;
     LogManager& operator=(const LogManager&) = delete;
@@ -6,10 +6,13 @@
  *
  * @copyright Copyright (c) 2024
  */
+#define LOG_SOURCE LogSource::SENSOR
+
 #include "pressure.h"
 #include <serialMenu.h>
 #include <math.h>
 #include <calcModule.h>
+#include <adcEngine.h>
 
 PressureSensor::PressureSensor()
     : _pressureSensorInitialized(false)
@@ -32,7 +35,7 @@ float PressureSensor::readPressure()
 {
     if (!_pressureSensorInitialized)
     {
-        SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Pressure sensor not initialized!"));
+        LOG_TOKEN(ERROR, PRESSURE_NOT_INIT);
         return NAN;
     }
 
@@ -48,6 +51,6 @@ bool PressureSensor::isInitialized() const
 
 float PressureSensor::readAnalogSensor(uint8_t pin)
 {
-	uint8_t rawValue = analogRead(pin);
+	int rawValue = sensorModule::AdcEngine::getInstance()->read(pin);
     return static_cast<float>(rawValue);
 }
@@ -8,6 +8,8 @@
  * @copyright Copyright (c) 2024
  */
 
+#define LOG_SOURCE LogSource::REPORT
+
 #include "reportSystem.h"
 #include "ptrUtils.h"
 #include <Arduino.h>
@@ -15,6 +17,7 @@
 #include <EEPROM.h>
 #include <ErriezMemoryUsage.h>
 #include <serialMenu.h>
+#include <sensorSnapshot.h>
 
 using namespace reportSystem;
 using namespace timeModule;
@@ -94,7 +97,7 @@ bool ReportSystem::checkSystemHealth(size_t memoryThreshold, bool checkEth,
             }
             else
             {
-                SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("System health check passed."));
+                LOG_TOKEN(INFO, HEALTH_CHECK_PASSED);
             }
         }
     }
@@ -113,7 +116,10 @@ bool ReportSystem::reportStatus(bool active)
     const float warningMargin = 0.9f;
     bool hasWarningOrError = false;
 
-    auto currentTemp = _sens->readSensor(sensorModule::SensorType::OBJECTTEMPERATURE);
+    // the acquisition task samples the thermocouples, no extra I2C traffic for the report
+    sensorModule::SensorSnapshotStore* snapshot = sensorModule::SensorSnapshotStore::getInstance();
+    float currentTemp = max(snapshot->read(sensorModule::SensorChannel::TEMPERATURE_INDOOR).value,
+                            snapshot->read(sensorModule::SensorChannel::TEMPERATURE_OUTDOOR).value);
     if (currentTemp >= tempThreshold * warningMargin)
     {
         statusReport += "Current Temperature: " + String(currentTemp) +
@@ -139,8 +145,7 @@ void ReportSystem::setThreshold(float tempThreshold, float pressureThreshold)
 {
     this->tempThreshold = tempThreshold;
     this->pressureThreshold = pressureThreshold;
-    SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, "Thresholds updated - Temp: " +
-               String(tempThreshold) + ", Pressure: " + String(pressureThreshold));
+    LOG_TOKEN(INFO, THRESHOLDS_UPDATED, tempThreshold, pressureThreshold);
 }
 
 bool ReportSystem::checkThresholds(float currentTemp, float currentPressure)
@@ -168,7 +173,7 @@ String ReportSystem::getCurrentTime()
 {
     if (_time == nullptr)
     {
-        SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Time module not initialized, using fallback time"));
+        LOG_TOKEN(ERROR, TIME_FALLBACK);
         return "0000-00-00T00:00:00Z";
     }
     return TimeModuleInternals::formatTimeString(_time->getSystemTime());
@@ -212,7 +217,7 @@ bool ReportSystem::checkCommunication(bool checkEth, bool checkSpi, bool checkI2
     {
         if (!alreadyReportedSuccess)
         {
-            SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, F("All communication modules online."));
+            LOG_DEBUG(F("All communication modules online."));
             alreadyReportedSuccess = true;
         }
         return true;
@@ -257,8 +262,7 @@ bool ReportSystem::checkRamLevel(unsigned int warningThreshold, unsigned int cri
 
     if (ramSize < warningThreshold)
     {
-    	SerialMenu::printToSerial(SerialMenu::OutputLevel::WARNING, "Low RAM warning! Available: " +
-                   String(ramSize) + " bytes (Warning: " + String(warningThreshold) + ")");
+    	LOG_TOKEN(WARNING, LOW_RAM_WARNING, ramSize, warningThreshold);
     }
 
     return true;
@@ -354,7 +358,7 @@ void ReportSystem::saveLastError(const char* error)
     char buffer[50] = {0};
     strncpy(buffer, error, sizeof(buffer) - 1);
     EEPROM.put(EEPROM_ERROR_ADDR, buffer);
-    SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, "Error saved to EEPROM: " + String(error));
+    LOG_DEBUG("Error saved to EEPROM: " + String(error));
 }
 
 String ReportSystem::getLastError()
@@ -369,7 +373,7 @@ bool ReportSystem::getLastErrorInfo()
     String lastError = getLastError();
     if (lastError.length() > 0)
     {
-    	SerialMenu::printToSerial(SerialMenu::OutputLevel::DEBUG, "Retrieved last error: " + lastError);
+    	LOG_DEBUG("Retrieved last error: " + lastError);
         return true;
     }
     return false;
@@ -0,0 +1,441 @@
+/**
+ * @file adcEngine.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the interrupt driven scan of the analog inputs.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "adcEngine.h"
+#include <ptrUtils.h>
+#include <util/atomic.h>
+
+using namespace sensorModule;
+
+#define ADC_PRESCALER_128 ((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0))
+#define ADC_PRESCALER_64 ((1 << ADPS2) | (1 << ADPS1))
+#define ADC_PRESCALER_32 ((1 << ADPS2) | (1 << ADPS0))
+#define ADC_TRIGGER_SOURCE_MASK ((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))
+#define TIMER1_CLOCK_MASK ((1 << CS12) | (1 << CS11) | (1 << CS10))
+#define ADC_FIRST_SCAN_TIMEOUT_MS 50
+#define ADC_CAPTURE_SKIP 2     // results after the switch to the capture input and clock
+
+AdcEngine* AdcEngine::_instance = nullptr;
+
+ISR(ADC_vect)
+{
+    AdcEngine::onConversionComplete();
+}
+
+AdcEngine::AdcEngine()
+{
+
+}
+
+AdcEngine* AdcEngine::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new AdcEngine();
+    }
+    return _instance;
+}
+
+bool AdcEngine::begin(const AdcChannelConfig* channels, uint8_t channelCount)
+{
+    if (PtrUtils::IsNullPtr(channels) || channelCount == 0 || channelCount > ADC_MAX_CHANNELS)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        if (toChannel(channels[i].pin) > 15 || channels[i].extraBits > ADC_MAX_EXTRA_BITS
+            || channels[i].trigger > AdcTrigger::TIMER1_COMPARE_B)
+        {
+            return false;
+        }
+    }
+
+    end();
+
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        _channels[i] = toChannel(channels[i].pin);
+        _extraBits[i] = channels[i].extraBits;
+        _triggers[i] = channels[i].trigger;
+    }
+    _channelCount = channelCount;
+    uint32_t scansBefore = _results.getVersion();
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _frame = &_results.beginWrite();
+        ADCSRA = (1 << ADEN) | (1 << ADIF) | (1 << ADIE) | ADC_PRESCALER_128;
+        _running = true;
+        selectChannel(0);
+        _settling = false;
+        startConversion();
+    }
+
+    unsigned long start = millis();
+    while (_results.getVersion() == scansBefore)
+    {
+        if (millis() - start > ADC_FIRST_SCAN_TIMEOUT_MS)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AdcEngine::end()
+{
+    if (!_running)
+    {
+        return;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _running = false;
+        _capture = CaptureState::IDLE;
+        _captureQueued = false;
+        ADCSRA = (1 << ADEN) | ADC_PRESCALER_128;   // as after init(), without the interrupt and auto trigger
+        ADCSRB &= ~ADC_TRIGGER_SOURCE_MASK;
+        _triggerFlag = 0;
+    }
+    // let a started conversion finish, analogRead() would return its result otherwise
+    while (ADCSRA & (1 << ADSC))
+    {
+    }
+    ADCSRA |= (1 << ADIF);
+}
+
+bool AdcEngine::isRunning() const
+{
+    return _running;
+}
+
+int AdcEngine::read(uint8_t pin) const
+{
+    if (!_running)
+    {
+        return analogRead(pin);
+    }
+
+    uint8_t bits;
+    int32_t value = readExtended(pin, bits);
+    return (value < 0) ? -1 : static_cast<int>(value >> (bits - 10));
+}
+
+int32_t AdcEngine::readExtended(uint8_t pin, uint8_t& bits) const
+{
+    int8_t index = indexOf(pin);
+    if (index < 0)
+    {
+        bits = 10;
+        return -1;
+    }
+
+    Frame frame;
+    _results.read(frame);
+    bits = 10 + _extraBits[index];
+    return frame.values[index];
+}
+
+uint32_t AdcEngine::getScanCount() const
+{
+    return _results.getVersion();
+}
+
+void AdcEngine::onTriggerStopped()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (_running && _triggerFlag != 0 && !(ADCSRA & (1 << ADSC)))
+        {
+            // the block of the input starts over free running
+            selectChannel(_current);
+            startConversion();
+        }
+    }
+}
+
+bool AdcEngine::startCapture(uint8_t pin, uint8_t prescaler, AdcCaptureSink sink)
+{
+    uint8_t prescalerBits;
+    switch (prescaler)
+    {
+        case 32: prescalerBits = ADC_PRESCALER_32; break;
+        case 64: prescalerBits = ADC_PRESCALER_64; break;
+        case 128: prescalerBits = ADC_PRESCALER_128; break;
+        default: return false;
+    }
+    if (!_running || PtrUtils::IsNullPtr(sink) || toChannel(pin) > 15)
+    {
+        return false;
+    }
+
+    bool scheduled = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        // the previous capture may still wait for its last conversion, the new one follows it
+        if (_capture == CaptureState::IDLE || (_capture == CaptureState::LEAVING && !_captureQueued))
+        {
+            _captureSink = sink;
+            _captureChannel = toChannel(pin);
+            _capturePrescaler = prescalerBits;
+            _captureIndex = indexOf(pin);
+            if (_capture == CaptureState::IDLE)
+            {
+                _capture = CaptureState::REQUESTED;
+            }
+            else
+            {
+                _captureQueued = true;
+            }
+            scheduled = true;
+        }
+    }
+    return scheduled;
+}
+
+void AdcEngine::stopCapture()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _captureQueued = false;
+        if (_capture == CaptureState::REQUESTED)
+        {
+            _capture = CaptureState::IDLE;
+        }
+        else if (_capture == CaptureState::RUNNING)
+        {
+            // written, not or-ed: a set ADIF would be cleared and its interrupt lost
+            ADCSRA = (1 << ADEN) | (1 << ADIE) | _capturePrescaler;
+            _capture = CaptureState::LEAVING;
+        }
+    }
+}
+
+uint16_t AdcEngine::getCaptureOverruns() const
+{
+    uint16_t overruns;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        overruns = _captureOverruns;
+    }
+    return overruns;
+}
+
+bool AdcEngine::isCapturing() const
+{
+    return _capture != CaptureState::IDLE;
+}
+
+void AdcEngine::onConversionComplete()
+{
+    uint16_t value = ADC;
+    if (!PtrUtils::IsNullPtr(_instance) && _instance->_running)
+    {
+        _instance->handleConversion(value);
+    }
+}
+
+void AdcEngine::handleConversion(uint16_t value)
+{
+    CaptureState capture = _capture;
+    if (capture == CaptureState::RUNNING)
+    {
+        handleCapture(value);
+        return;
+    }
+    if (capture == CaptureState::LEAVING)
+    {
+        leaveCapture();
+        return;
+    }
+
+    if (_settling)
+    {
+        _settling = false;
+    }
+    else
+    {
+        _sum += value;
+        if (--_remaining == 0)
+        {
+            _frame->values[_current] = _sum >> _extraBits[_current];
+            if (++_current >= _channelCount)
+            {
+                _results.commit();
+                _frame = &_results.beginWrite();
+                _current = 0;
+            }
+            selectChannel(_current);
+        }
+    }
+
+    if (capture == CaptureState::REQUESTED)
+    {
+        // no conversion is in progress here, the capture takes over
+        enterCapture();
+        return;
+    }
+    startConversion();
+}
+
+void AdcEngine::enterCapture()
+{
+    setMux(_captureChannel);
+    ADCSRB &= ~ADC_TRIGGER_SOURCE_MASK;
+    ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE) | _capturePrescaler;
+    _triggerFlag = 0;
+    _captureSkip = ADC_CAPTURE_SKIP;
+    _captureOverruns = 0;
+    if (_captureIndex >= 0)
+    {
+        _sum = 0;
+        _remaining = 1 << (2 * _extraBits[_captureIndex]);
+    }
+    _capture = CaptureState::RUNNING;
+}
+
+void AdcEngine::handleCapture(uint16_t value)
+{
+    if (_captureSkip != 0)
+    {
+        _captureSkip--;
+        return;
+    }
+
+    // the control loops keep reading a current value of the captured input
+    if (_captureIndex >= 0)
+    {
+        _sum += value;
+        if (--_remaining == 0)
+        {
+            _frame->values[_captureIndex] = _sum >> _extraBits[_captureIndex];
+            _results.commit();
+            _frame = &_results.beginWrite();
+            _sum = 0;
+            _remaining = 1 << (2 * _extraBits[_captureIndex]);
+        }
+    }
+
+    bool more = _captureSink(value);
+
+    // free running, the flag of the next result is cleared when its interrupt starts. Set here it
+    // means this interrupt took longer than a sample, the results pile up and get overwritten.
+    if ((ADCSRA & (1 << ADIF)) && _captureOverruns != 0xFFFF)
+    {
+        _captureOverruns++;
+    }
+
+    if (!more)
+    {
+        // the conversion in progress is the last one, its interrupt resumes the scan
+        ADCSRA = (1 << ADEN) | (1 << ADIE) | _capturePrescaler;
+        _capture = CaptureState::LEAVING;
+    }
+}
+
+void AdcEngine::leaveCapture()
+{
+    ADCSRA = (1 << ADEN) | (1 << ADIE) | ADC_PRESCALER_128;
+    selectChannel(_current);
+    _settling = true;       // input and clock changed since the last result
+    _capture = _captureQueued ? CaptureState::REQUESTED : CaptureState::IDLE;
+    _captureQueued = false;
+    startConversion();
+}
+
+void AdcEngine::selectChannel(uint8_t index)
+{
+    setMux(_channels[index]);
+
+    // a stopped Timer1 would never trigger, the input is free running until it runs again
+    uint8_t source = 0;
+    _triggerFlag = 0;
+    if ((TCCR1B & TIMER1_CLOCK_MASK) != 0)
+    {
+        switch (_triggers[index])
+        {
+            case AdcTrigger::TIMER1_OVERFLOW:
+                source = (1 << ADTS2) | (1 << ADTS1);
+                _triggerFlag = (1 << TOV1);
+                break;
+            case AdcTrigger::TIMER1_COMPARE_B:
+                source = (1 << ADTS2) | (1 << ADTS0);
+                _triggerFlag = (1 << OCF1B);
+                break;
+            default:
+                break;
+        }
+    }
+    if (_triggerFlag != 0)
+    {
+        ADCSRB = (ADCSRB & ~ADC_TRIGGER_SOURCE_MASK) | source;
+        ADCSRA |= (1 << ADATE);
+    }
+    else
+    {
+        ADCSRA &= ~(1 << ADATE);
+    }
+
+    _current = index;
+    _sum = 0;
+    _remaining = 1 << (2 * _extraBits[index]);
+    _settling = (_channelCount > 1);
+}
+
+void AdcEngine::startConversion()
+{
+    if (_triggerFlag != 0)
+    {
+        // the conversion starts at the rising edge of the flag, the next Timer1 event
+        TIFR1 = _triggerFlag;
+    }
+    else
+    {
+        ADCSRA |= (1 << ADSC);
+    }
+}
+
+void AdcEngine::setMux(uint8_t channel)
+{
+    ADMUX = (1 << REFS0) | (channel & 0x07);    // AVcc reference like analogRead()
+    if (channel & 0x08)
+    {
+        ADCSRB |= (1 << MUX5);
+    }
+    else
+    {
+        ADCSRB &= ~(1 << MUX5);
+    }
+}
+
+uint8_t AdcEngine::toChannel(uint8_t pin)
+{
+#ifdef A0
+    if (pin >= A0)
+    {
+        return pin - A0;
+    }
+#endif
+    return pin;
+}
+
+int8_t AdcEngine::indexOf(uint8_t pin) const
+{
+    uint8_t channel = toChannel(pin);
+    for (uint8_t i = 0; i < _channelCount; i++)
+    {
+        if (_channels[i] == channel)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file adcEngine.h
+ * @author Adrian Goessl
+ * @brief Header file for the interrupt driven scan of the analog inputs.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef ADCENGINE_H
+#define ADCENGINE_H
+
+#include <Arduino.h>
+#include <snapshot.h>
+
+#define ADC_MAX_CHANNELS 8
+#define ADC_MAX_EXTRA_BITS 3
+
+/// @brief Namespace for the sensor module. \namespace sensorModule
+namespace sensorModule
+{
+    /// @brief Enum for what starts the conversions of an input. \enum AdcTrigger
+    /// The Timer1 events lock the samples to the flyback PWM: the sample and hold follows the
+    /// event after a fixed 2 ADC clocks (16 us), so every sample sees the ripple at the same phase
+    /// instead of a beat between the PWM and the ADC. One conversion takes longer than a PWM
+    /// period, the samples are taken every few periods, always a whole number of them.
+    enum class AdcTrigger : uint8_t
+    {
+        FREE_RUNNING,           // next conversion right after the previous one
+        TIMER1_OVERFLOW,        // TOP of the PWM period, the switch turns on
+        TIMER1_COMPARE_B        // OCR1B, the switch turns off
+    };
+
+    /// @brief Function that takes the samples of a capture, see AdcEngine::startCapture().
+    /// Runs in the ADC interrupt, returns false when the capture is complete.
+    typedef bool (*AdcCaptureSink)(uint16_t value);
+
+    /// @brief Structure for an analog input of the scan. \struct AdcChannelConfig
+    struct AdcChannelConfig
+    {
+        uint8_t pin;            // A0..A15 or the channel number 0..15 like analogRead()
+        uint8_t extraBits;      // oversampling 4^extraBits, 0..ADC_MAX_EXTRA_BITS
+        AdcTrigger trigger;     // FREE_RUNNING if omitted
+    };
+
+    /// @brief Class to convert the analog inputs in the background, nobody waits for the ADC. \class AdcEngine
+    /// The ADC interrupt reads a result, starts the next conversion and moves on through the channel
+    /// list, 104 us per conversion at the 125 kHz ADC clock. Every channel sums 4^extraBits conversions
+    /// and keeps 10 + extraBits bits of it (oversampling and decimation, needs some noise on the input),
+    /// the first conversion after a channel change is dropped while the sample and hold settles. An
+    /// input can wait for a Timer1 event instead, see AdcTrigger. The results of a whole scan are
+    /// published together in a Snapshot, read() copies the newest ones.
+    /// A capture takes over the ADC for one input at a time: free running at a faster clock, every
+    /// result goes to a sink in the interrupt. The scanned result of that input stays current meanwhile,
+    /// the other inputs keep their last values until the scan resumes. The interrupt with the sink
+    /// must finish within one sample, results that come before it did are counted as overruns.
+    /// While the scan runs it owns the ADC, analogRead() must not be used anywhere.
+    class AdcEngine
+    {
+    public:
+
+        /**
+         * @brief Get the Instance object
+         *
+         * @return AdcEngine*
+         */
+        static AdcEngine* getInstance();
+
+        /**
+         * @brief Function to start the scan, waits up to 50 ms for the first results.
+         *
+         * @param channels -> The inputs, in scan order.
+         * @param channelCount -> The number of inputs, at most ADC_MAX_CHANNELS.
+         * @return true -> if the scan runs and every channel has a result
+         * @return false -> if the list is invalid or the first scan did not finish
+         */
+        bool begin(const AdcChannelConfig* channels, uint8_t channelCount);
+
+        /**
+         * @brief Function to stop the scan, analogRead() works again afterwards.
+         */
+        void end();
+
+        /**
+         * @brief Function to check if the scan runs.
+         *
+         * @return true -> if it runs
+         * @return false -> if not
+         */
+        bool isRunning() const;
+
+        /**
+         * @brief Function to get the newest result of an input, a drop in for analogRead().
+         * Falls back to analogRead() while the scan is stopped.
+         *
+         * @param pin -> The input, A0..A15 or 0..15.
+         * @return int -> The result scaled to 0..1023, -1 if the running scan does not cover the input.
+         */
+        int read(uint8_t pin) const;
+
+        /**
+         * @brief Function to get the newest result of an input with the oversampled resolution.
+         *
+         * @param pin -> The input, A0..A15 or 0..15.
+         * @param bits -> The resolution of the result, 10 + extraBits.
+         * @return int32_t -> The result, 0..2^bits - 1, -1 if the scan does not cover the input.
+         */
+        int32_t readExtended(uint8_t pin, uint8_t& bits) const;
+
+        /**
+         * @brief Getter for the number of published results, the completed scans plus the updates
+         * of the captured input during a capture.
+         *
+         * @return uint32_t -> The count, wraps.
+         */
+        uint32_t getScanCount() const;
+
+        /**
+         * @brief Function to call after Timer1 was stopped. A conversion waiting for a Timer1
+         * event is started free running instead, the input is free running until Timer1 runs again.
+         */
+        void onTriggerStopped();
+
+        /**
+         * @brief Function to sample one input back to back until the sink is done. Starts after the
+         * conversion in progress, the scan continues with the interrupted channel when the sink
+         * returns false or stopCapture() is called.
+         *
+         * @param pin -> The input, A0..A15 or 0..15, need not be part of the scan.
+         * @param prescaler -> The ADC clock divider 32, 64 or 128, a sample every 13 ADC clocks. 16 is
+         * refused, its 13 us per sample are shorter than the interrupt with the sink.
+         * @param sink -> The function taking the samples, called in the ADC interrupt.
+         * @return true -> if the capture is scheduled
+         * @return false -> if the scan does not run, a capture is pending or an argument is invalid
+         */
+        bool startCapture(uint8_t pin, uint8_t prescaler, AdcCaptureSink sink);
+
+        /**
+         * @brief Function to end a capture before the sink is done, the sink gets no more samples.
+         */
+        void stopCapture();
+
+        /**
+         * @brief Getter for the overruns of the running or last capture.
+         *
+         * @return uint16_t -> The results that were ready before the interrupt of the previous one
+         * had finished, every overrun risks a lost sample. Stops at 65535.
+         */
+        uint16_t getCaptureOverruns() const;
+
+        /**
+         * @brief Function to check if a capture is pending or running.
+         *
+         * @return true -> if the ADC belongs to a capture
+         * @return false -> if it scans
+         */
+        bool isCapturing() const;
+
+        /**
+         * @brief Function to get the ADC channel of an input.
+         *
+         * @param pin -> The input, A0..A15 or 0..15.
+         * @return uint8_t -> The channel, 0..15 for a valid input.
+         */
+        static uint8_t toChannel(uint8_t pin);
+
+        /**
+         * @brief Function for the ADC interrupt, not for tasks.
+         */
+        static void onConversionComplete();
+
+    private:
+        AdcEngine();
+        ~AdcEngine() = default;
+
+        /// @brief Enum class for the steps of a capture. \enum CaptureState
+        enum class CaptureState : uint8_t
+        {
+            IDLE,
+            REQUESTED,      // starts instead of the next scan conversion
+            RUNNING,        // free running, results go to the sink
+            LEAVING         // auto trigger off, the last conversion is dropped
+        };
+
+        /// @brief Results of one scan. \struct Frame
+        struct Frame
+        {
+            uint16_t values[ADC_MAX_CHANNELS];
+        };
+
+        static AdcEngine* _instance;
+
+        uint8_t _channels[ADC_MAX_CHANNELS];        // ADC channel numbers 0..15
+        uint8_t _extraBits[ADC_MAX_CHANNELS];
+        AdcTrigger _triggers[ADC_MAX_CHANNELS];
+        uint8_t _channelCount = 0;
+        volatile bool _running = false;
+
+        // ADC interrupt only
+        uint8_t _current = 0;
+        uint8_t _remaining = 0;         // conversions left for the current channel
+        bool _settling = false;         // next result is the dropped one
+        uint8_t _triggerFlag = 0;       // TIFR1 flag of the waiting conversion, 0 when free running
+        uint16_t _sum = 0;
+        Frame* _frame = nullptr;        // free slot of the scan in progress
+
+        // capture, set by startCapture() before the state, then ADC interrupt only
+        volatile CaptureState _capture = CaptureState::IDLE;
+        AdcCaptureSink _captureSink = nullptr;
+        uint8_t _captureChannel = 0;
+        uint8_t _capturePrescaler = 0;  // ADPS bits
+        int8_t _captureIndex = -1;      // scan index of the input, -1 if not scanned
+        uint8_t _captureSkip = 0;       // results dropped after the switch
+        bool _captureQueued = false;    // requested while LEAVING, starts after it
+        volatile uint16_t _captureOverruns = 0;
+
+        Snapshot<Frame> _results;
+
+        int8_t indexOf(uint8_t pin) const;
+        void selectChannel(uint8_t index);
+        void startConversion();
+        void handleConversion(uint16_t value);
+        void enterCapture();
+        void handleCapture(uint16_t value);
+        void leaveCapture();
+        static void setMux(uint8_t channel);
+
+        AdcEngine(const AdcEngine&) = delete;
+        AdcEngine& operator=(const AdcEngine&) = delete;
+    };
+}
+
+#endif // ADCENGINE_H
@@ -0,0 +1,160 @@
+/**
+ * @file rippleAnalyzer.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the ripple and spectrum analysis of a scope capture.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "rippleAnalyzer.h"
+#include "scopeCapture.h"
+#include <ptrUtils.h>
+
+using namespace sensorModule;
+using namespace calcModule;
+
+RippleAnalyzer* RippleAnalyzer::_instance = nullptr;
+
+RippleAnalyzer::RippleAnalyzer()
+{
+
+}
+
+RippleAnalyzer* RippleAnalyzer::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new RippleAnalyzer();
+    }
+    return _instance;
+}
+
+bool RippleAnalyzer::begin(int16_t* work, uint16_t points)
+{
+    if (PtrUtils::IsNullPtr(work) || points < FFT_MIN_POINTS)
+    {
+        return false;
+    }
+
+    _work = work;
+    _capacity = points;
+    return true;
+}
+
+bool RippleAnalyzer::analyze(uint16_t points, RippleResult& result)
+{
+    ScopeCapture* scope = ScopeCapture::getInstance();
+    if (PtrUtils::IsNullPtr(_work) || !FixedFft::isValidSize(points) || points > _capacity
+        || points > scope->getSampleCount())
+    {
+        return false;
+    }
+
+    // the bytes go to the upper half of the buffer, widening in place only overwrites read ones
+    uint8_t* samples = reinterpret_cast<uint8_t*>(_work) + points;
+    if (scope->readSamples(0, samples, points) != points)
+    {
+        return false;
+    }
+
+    uint32_t sum = 0;
+    uint32_t sumSquares = 0;
+    uint8_t low = 0xFF;
+    uint8_t high = 0;
+    for (uint16_t i = 0; i < points; i++)
+    {
+        uint8_t sample = samples[i];
+        _work[i] = sample;
+        sum += sample;
+        sumSquares += static_cast<uint16_t>(sample) * sample;
+        low = min(low, sample);
+        high = max(high, sample);
+    }
+
+    // centred and scaled to use the range of Q15, small ripple keeps its resolution in the transform
+    uint8_t shift = 7;
+    while (shift < 14 && (static_cast<int32_t>(high - low) << (shift + 1)) < 32768)
+    {
+        shift++;
+    }
+    int32_t offset = (static_cast<int32_t>(sum) << shift) / points;
+    for (uint16_t i = 0; i < points; i++)
+    {
+        _work[i] = (static_cast<int32_t>(_work[i]) << shift) - offset;
+    }
+
+    FixedFft::applyHann(_work, points);
+    FixedFft::transformReal(_work, points);
+
+    // the capture keeps 8 of the 10 bits
+    const float countsPerSample = static_cast<float>(1 << (10 - SCOPE_SAMPLE_BITS));
+    float mean = static_cast<float>(sum) / points;
+    float variance = static_cast<float>(sumSquares) / points - mean * mean;
+
+    result.points = points;
+    result.sampleRateHz = 1.0e9f / ScopeCapture::getSampleIntervalNs(scope->getConfig().prescaler);
+    result.binHz = result.sampleRateHz / points;
+    result.mean = mean * countsPerSample;
+    result.rms = (variance > 0.0f) ? sqrtf(variance) * countsPerSample : 0.0f;
+    result.peakToPeak = (high - low) * countsPerSample;
+
+    // bins 0 and 1 hold what is left of the mean after the window
+    uint16_t peak = 2;
+    uint32_t peakPower = 0;
+    for (uint16_t bin = 2; bin < points / 2; bin++)
+    {
+        uint32_t power = FixedFft::power(_work, points, bin);
+        if (power > peakPower)
+        {
+            peak = bin;
+            peakPower = power;
+        }
+    }
+
+    // Hann interpolation between the bins, d = 2 (m+ - m-) / (m- + 2 m + m+)
+    float below = sqrtf(FixedFft::power(_work, points, peak - 1));
+    float center = sqrtf(peakPower);
+    float above = sqrtf(FixedFft::power(_work, points, peak + 1));
+    float denominator = below + 2.0f * center + above;
+    float fraction = (denominator > 0.0f) ? 2.0f * (above - below) / denominator : 0.0f;
+    float fundamentalBin = peak + fraction;
+    result.dominantHz = fundamentalBin * result.binHz;
+
+    // a tone of amplitude A leaves 3 A^2 / 32 in the lobe of the Hann window, one sided
+    const float amplitudeScale = countsPerSample / static_cast<float>(1UL << shift);
+    uint32_t fundamentalPower = lobePower(points, peak);
+    result.dominantAmplitude = sqrtf(fundamentalPower * (32.0f / 3.0f)) * amplitudeScale;
+
+    // harmonics whose lobe overlaps the fundamental or passes the Nyquist frequency are left out
+    float harmonicPower = 0.0f;
+    result.harmonics = 0;
+    if (peak > 2 * RIPPLE_LOBE_BINS)
+    {
+        for (uint8_t harmonic = 2; harmonic <= RIPPLE_MAX_HARMONIC; harmonic++)
+        {
+            uint16_t bin = static_cast<uint16_t>(harmonic * fundamentalBin + 0.5f);
+            if (bin + RIPPLE_LOBE_BINS >= points / 2)
+            {
+                break;
+            }
+            harmonicPower += lobePower(points, bin);
+            result.harmonics++;
+        }
+    }
+    result.thd = (result.harmonics > 0 && fundamentalPower > 0) ? sqrtf(harmonicPower / fundamentalPower) : NAN;
+    return true;
+}
+
+uint32_t RippleAnalyzer::lobePower(uint16_t points, uint16_t center) const
+{
+    uint32_t sum = 0;
+    for (uint16_t bin = center - RIPPLE_LOBE_BINS; bin <= center + RIPPLE_LOBE_BINS; bin++)
+    {
+        if (bin >= 2 && bin < points / 2)
+        {
+            sum += FixedFft::power(_work, points, bin);
+        }
+    }
+    return sum;
+}
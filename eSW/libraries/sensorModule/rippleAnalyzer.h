@@ -0,0 +1,91 @@
+/**
+ * @file rippleAnalyzer.h
+ * @author Adrian Goessl
+ * @brief Header file for the ripple and spectrum analysis of a scope capture.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef RIPPLEANALYZER_H
+#define RIPPLEANALYZER_H
+
+#include <Arduino.h>
+#include <fixedFft.h>
+
+#define RIPPLE_MAX_HARMONIC 5       // highest harmonic of the THD
+#define RIPPLE_LOBE_BINS 2          // bins on each side of a peak, the main lobe of the Hann window
+
+/// @brief Namespace for the sensor module. \namespace sensorModule
+namespace sensorModule
+{
+    /// @brief Structure for the result of an analysis, amplitudes in 10 bit ADC counts. \struct RippleResult
+    struct RippleResult
+    {
+        uint16_t points;
+        float sampleRateHz;
+        float binHz;                // frequency resolution
+        float mean;
+        float rms;                  // AC part, from the samples
+        float peakToPeak;
+        float dominantHz;           // strongest component above bin 1, between the bins
+        float dominantAmplitude;    // its peak amplitude, from the power of its lobe
+        float thd;                  // harmonics 2..RIPPLE_MAX_HARMONIC over the fundamental, NAN if none fits
+        uint8_t harmonics;          // harmonics below the Nyquist frequency that went into thd
+    };
+
+    /// @brief Class to measure the ripple of a frozen ScopeCapture with a fixed point FFT. \class RippleAnalyzer
+    /// The first points samples of the capture are centred, Hann windowed and transformed in Q15.
+    /// Mean, RMS and peak to peak come from the samples, the dominant component and the THD from
+    /// the power spectrum, each component summed over the main lobe of the window. Only components
+    /// below half the sample rate are resolved, faster ones show up folded.
+    /// Runs in the calling task, a 256 point analysis takes a few ten ms on the AVR.
+    class RippleAnalyzer
+    {
+    public:
+
+        /**
+         * @brief Get the Instance object
+         *
+         * @return RippleAnalyzer*
+         */
+        static RippleAnalyzer* getInstance();
+
+        /**
+         * @brief Function to hand over the work buffer of the transform.
+         *
+         * @param work -> The buffer, one int16_t per point.
+         * @param points -> Its size, the largest analysis, at least FFT_MIN_POINTS.
+         * @return true -> if the buffer is usable
+         * @return false -> if it is too small
+         */
+        bool begin(int16_t* work, uint16_t points);
+
+        /**
+         * @brief Function to analyse the frozen capture.
+         *
+         * @param points -> The number of samples, a power of two, FFT_MIN_POINTS..FFT_MAX_POINTS.
+         * @param result -> Receives the result.
+         * @return true -> if analysed
+         * @return false -> if nothing is captured, the capture is shorter or points is invalid
+         */
+        bool analyze(uint16_t points, RippleResult& result);
+
+    private:
+        RippleAnalyzer();
+        ~RippleAnalyzer() = default;
+
+        static RippleAnalyzer* _instance;
+
+        int16_t* _work = nullptr;
+        uint16_t _capacity = 0;
+
+        uint32_t lobePower(uint16_t points, uint16_t center) const;
+
+        RippleAnalyzer(const RippleAnalyzer&) = delete;
+        RippleAnalyzer& operator=(const RippleAnalyzer&) = delete;
+    };
+}
+
+#endif // RIPPLEANALYZER_H
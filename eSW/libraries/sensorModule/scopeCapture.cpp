@@ -0,0 +1,306 @@
+/**
+ * @file scopeCapture.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the triggered waveform capture of one analog input.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "scopeCapture.h"
+#include "adcEngine.h"
+#include <ptrUtils.h>
+#include <timeModule.h>
+#include <util/atomic.h>
+
+using namespace sensorModule;
+
+ScopeCapture* ScopeCapture::_instance = nullptr;
+
+ScopeCapture::ScopeCapture()
+{
+
+}
+
+ScopeCapture* ScopeCapture::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new ScopeCapture();
+    }
+    return _instance;
+}
+
+bool ScopeCapture::begin(uint8_t* storage, uint16_t size)
+{
+    if (PtrUtils::IsNullPtr(storage) || size < SCOPE_MIN_SAMPLES)
+    {
+        return false;
+    }
+
+    disarm();
+    _buffer = storage;
+    _size = size;
+    _state = ScopeState::IDLE;
+    return true;
+}
+
+bool ScopeCapture::arm(const ScopeConfig& config)
+{
+    uint32_t intervalNs = getSampleIntervalNs(config.prescaler);
+    if (PtrUtils::IsNullPtr(_buffer) || intervalNs == 0 || config.preTrigger >= _size
+        || config.level > 1023 || config.trigger > ScopeTrigger::EXTERNAL_EDGE
+        || config.timeoutMs == 0 || config.timeoutMs > SCOPE_MAX_TIMEOUT_MS)
+    {
+        return false;
+    }
+    if (config.trigger == ScopeTrigger::EXTERNAL_EDGE && digitalPinToInterrupt(config.externalPin) == NOT_AN_INTERRUPT)
+    {
+        return false;
+    }
+
+    ScopeState state = getState();
+    if (state == ScopeState::ARMED || state == ScopeState::TRIGGERED)
+    {
+        return false;
+    }
+
+    _config = config;
+    _write = 0;
+    _count = 0;
+    _samplesLeft = static_cast<uint32_t>(config.timeoutMs) * 1000000UL / intervalNs;
+    _sampleUs = intervalNs / 1000;
+    _previous = 0;
+    _externalEdge = false;
+    _triggered = false;
+    _state = ScopeState::ARMED;
+
+    if (config.trigger == ScopeTrigger::EXTERNAL_EDGE)
+    {
+        attachInterrupt(digitalPinToInterrupt(config.externalPin), onExternalEdge, RISING);
+        _externalAttached = true;
+    }
+
+    if (!AdcEngine::getInstance()->startCapture(config.pin, config.prescaler, onSample))
+    {
+        _state = ScopeState::IDLE;
+        detachExternal();
+        return false;
+    }
+    return true;
+}
+
+void ScopeCapture::disarm()
+{
+    AdcEngine::getInstance()->stopCapture();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (_state == ScopeState::ARMED || _state == ScopeState::TRIGGERED)
+        {
+            _state = ScopeState::IDLE;
+        }
+    }
+    detachExternal();
+}
+
+ScopeState ScopeCapture::getState()
+{
+    ScopeState state;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        state = _state;
+        if ((state == ScopeState::ARMED || state == ScopeState::TRIGGERED) && !AdcEngine::getInstance()->isCapturing())
+        {
+            // the scan was stopped underneath
+            _state = state = ScopeState::IDLE;
+        }
+    }
+
+    if (state != ScopeState::ARMED && state != ScopeState::TRIGGERED)
+    {
+        detachExternal();
+    }
+    return state;
+}
+
+const ScopeConfig& ScopeCapture::getConfig() const
+{
+    return _config;
+}
+
+uint16_t ScopeCapture::getSampleCount() const
+{
+    return _size;
+}
+
+uint32_t ScopeCapture::getSampleIntervalNs(uint8_t prescaler)
+{
+    if (prescaler != 32 && prescaler != 64 && prescaler != 128)
+    {
+        return 0;
+    }
+    // free running, a conversion every 13 ADC clocks
+    return 13000UL * prescaler / (F_CPU / 1000000UL);
+}
+
+uint64_t ScopeCapture::getTriggerUs() const
+{
+    uint64_t triggerUs;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        triggerUs = _triggerUs;
+    }
+    return triggerUs;
+}
+
+bool ScopeCapture::wasTriggered() const
+{
+    return _triggered;
+}
+
+void ScopeCapture::writeHeader(uint8_t* buffer, uint64_t triggerEpochMs) const
+{
+    uint16_t samples = (_state == ScopeState::CAPTURED) ? _size : 0;
+    uint32_t intervalNs = getSampleIntervalNs(_config.prescaler);
+
+    memset(buffer, 0, SCOPE_HEADER_SIZE);
+    memcpy(buffer, "SCP1", 4);
+    buffer[4] = AdcEngine::toChannel(_config.pin);
+    buffer[5] = SCOPE_SAMPLE_BITS;
+    buffer[6] = static_cast<uint8_t>(_config.trigger);
+    buffer[7] = _triggered ? 1 : 0;
+    memcpy(&buffer[8], &samples, 2);
+    memcpy(&buffer[10], &_config.preTrigger, 2);
+    memcpy(&buffer[12], &intervalNs, 4);
+    memcpy(&buffer[16], &_config.level, 2);
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        buffer[20 + i] = static_cast<uint8_t>(triggerEpochMs >> (8 * i));
+    }
+}
+
+uint16_t ScopeCapture::readSamples(uint16_t offset, uint8_t* buffer, uint16_t length)
+{
+    if (getState() != ScopeState::CAPTURED || offset >= _size)
+    {
+        return 0;
+    }
+
+    // frozen, the oldest sample is the next one the ring would have overwritten
+    uint16_t count = min(length, static_cast<uint16_t>(_size - offset));
+    uint16_t index = (_write + offset < _size) ? _write + offset : _write + offset - _size;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        buffer[i] = _buffer[index];
+        if (++index == _size)
+        {
+            index = 0;
+        }
+    }
+    return count;
+}
+
+bool ScopeCapture::onSample(uint16_t value)
+{
+    return !PtrUtils::IsNullPtr(_instance) && _instance->handleSample(value);
+}
+
+void ScopeCapture::onExternalEdge()
+{
+    if (!PtrUtils::IsNullPtr(_instance))
+    {
+        _instance->_externalEdge = true;
+    }
+}
+
+bool ScopeCapture::handleSample(uint16_t value)
+{
+    ScopeState state = _state;
+    if (state != ScopeState::ARMED && state != ScopeState::TRIGGERED)
+    {
+        return false;
+    }
+
+    _buffer[_write] = static_cast<uint8_t>(value >> (10 - SCOPE_SAMPLE_BITS));
+    if (++_write == _size)
+    {
+        _write = 0;
+    }
+
+    bool more = true;
+    if (state == ScopeState::TRIGGERED)
+    {
+        if (--_count == 0)
+        {
+            _state = ScopeState::CAPTURED;
+            more = false;
+        }
+    }
+    else if (_count < _config.preTrigger || _count == 0)
+    {
+        // the samples before the trigger first, at least one for the edge detection
+        if (++_count >= _config.preTrigger)
+        {
+            _externalEdge = false;
+        }
+    }
+    else if (isTrigger(value))
+    {
+        more = freeze(true);
+    }
+    else if (--_samplesLeft == 0)
+    {
+        if (_config.freezeOnTimeout)
+        {
+            more = freeze(false);
+        }
+        else
+        {
+            _state = ScopeState::TIMED_OUT;
+            more = false;
+        }
+    }
+
+    _previous = value;
+    return more;
+}
+
+bool ScopeCapture::isTrigger(uint16_t value) const
+{
+    switch (_config.trigger)
+    {
+        case ScopeTrigger::RISING_LEVEL:
+            return _previous < _config.level && value >= _config.level;
+        case ScopeTrigger::FALLING_LEVEL:
+            return _previous > _config.level && value <= _config.level;
+        case ScopeTrigger::SLOPE:
+            return ((value > _previous) ? value - _previous : _previous - value) >= _config.level;
+        case ScopeTrigger::EXTERNAL_EDGE:
+            return _externalEdge;
+        default:
+            return true;
+    }
+}
+
+bool ScopeCapture::freeze(bool triggered)
+{
+    _triggerUs = timeModule::TimeModuleInternals::getMonotonicMicros() - _sampleUs;
+    _triggered = triggered;
+    _count = _size - _config.preTrigger - 1;
+    if (_count == 0)
+    {
+        _state = ScopeState::CAPTURED;
+        return false;
+    }
+    _state = ScopeState::TRIGGERED;
+    return true;
+}
+
+void ScopeCapture::detachExternal()
+{
+    if (_externalAttached)
+    {
+        detachInterrupt(digitalPinToInterrupt(_config.externalPin));
+        _externalAttached = false;
+    }
+}
@@ -0,0 +1,207 @@
+/**
+ * @file scopeCapture.h
+ * @author Adrian Goessl
+ * @brief Header file for the triggered waveform capture of one analog input.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SCOPECAPTURE_H
+#define SCOPECAPTURE_H
+
+#include <Arduino.h>
+
+/*
+ * Wire format of a capture, see writeHeader(), all numbers little endian:
+ *   0  'S' 'C' 'P' '1'
+ *   4  ADC channel (1) | bits per sample (1) | trigger (1) | triggered (1)
+ *   8  samples (2) | samples before the trigger (2) | sample interval ns (4)
+ *   16 level (2) | reserved (2)
+ *   20 trigger epoch ms (6) | reserved (6)
+ *   32 samples, one byte each, oldest first, the trigger sample at index "samples before the trigger"
+ */
+#define SCOPE_HEADER_SIZE 32
+#define SCOPE_SAMPLE_BITS 8
+#define SCOPE_MIN_SAMPLES 16
+#define SCOPE_MAX_TIMEOUT_MS 500        // longest time the other inputs of the scan are stale
+#define SCOPE_DEFAULT_PRESCALER 32      // 500 kHz ADC clock, 38.5 kS/s
+
+/// @brief Namespace for the sensor module. \namespace sensorModule
+namespace sensorModule
+{
+    /// @brief Enum class for what freezes the capture. \enum ScopeTrigger
+    enum class ScopeTrigger : uint8_t
+    {
+        NONE,           // right after the samples before the trigger
+        RISING_LEVEL,   // a sample at or above the level after one below it
+        FALLING_LEVEL,  // a sample at or below the level after one above it
+        SLOPE,          // two consecutive samples differ by the level or more
+        EXTERNAL_EDGE   // rising edge of an interrupt pin
+    };
+
+    /// @brief Enum class for the state of the capture. \enum ScopeState
+    enum class ScopeState : uint8_t
+    {
+        IDLE,
+        ARMED,          // filling the samples before the trigger, then waiting for it
+        TRIGGERED,      // recording the samples after the trigger
+        CAPTURED,       // frozen, the samples can be read
+        TIMED_OUT       // no trigger within the timeout
+    };
+
+    /// @brief Structure for the settings of a capture. \struct ScopeConfig
+    struct ScopeConfig
+    {
+        uint8_t pin;                // A0..A15 or 0..15
+        ScopeTrigger trigger;
+        uint16_t level;             // 0..1023, for SLOPE the step between two samples
+        uint16_t preTrigger;        // samples kept before the trigger, less than the buffer
+        uint16_t timeoutMs;         // wait for the trigger, 1..SCOPE_MAX_TIMEOUT_MS
+        bool freezeOnTimeout;       // capture anyway at the timeout, like the auto mode of a scope
+        uint8_t externalPin;        // interrupt pin of EXTERNAL_EDGE
+        uint8_t prescaler;          // ADC clock divider 32, 64 or 128
+    };
+
+    /// @brief Class to capture the waveform of one analog input around a trigger. \class ScopeCapture
+    /// While armed the AdcEngine samples the input back to back, a conversion every 13 ADC clocks
+    /// (26 us at the default divider), and the ADC interrupt writes every sample into a ring buffer.
+    /// Above a 200 kHz ADC clock the lower bits are noise, the trigger is checked on the 10 bit
+    /// result and the buffer keeps the upper 8 bits. After the trigger the remaining samples are
+    /// recorded, the buffer is frozen with the samples around the trigger until the next arm().
+    /// The other inputs of the scan are not converted while armed, timeoutMs bounds how long they
+    /// are stale. The captured input itself keeps its scanned value current. Late sample interrupts
+    /// are counted by AdcEngine::getCaptureOverruns().
+    class ScopeCapture
+    {
+    public:
+
+        /**
+         * @brief Get the Instance object
+         *
+         * @return ScopeCapture*
+         */
+        static ScopeCapture* getInstance();
+
+        /**
+         * @brief Function to hand over the sample buffer.
+         *
+         * @param storage -> The memory block, one byte per sample.
+         * @param size -> The number of samples, at least SCOPE_MIN_SAMPLES, at most 65535.
+         * @return true -> if the buffer is usable
+         * @return false -> if it is too small
+         */
+        bool begin(uint8_t* storage, uint16_t size);
+
+        /**
+         * @brief Function to start a capture, drops the frozen one.
+         *
+         * @param config -> The settings.
+         * @return true -> if the capture is armed
+         * @return false -> if a setting is invalid, a capture is armed or the ADC scan does not run
+         */
+        bool arm(const ScopeConfig& config);
+
+        /**
+         * @brief Function to stop an armed capture, the scan resumes.
+         */
+        void disarm();
+
+        /**
+         * @brief Getter for the state of the capture.
+         *
+         * @return ScopeState -> The state.
+         */
+        ScopeState getState();
+
+        /**
+         * @brief Getter for the settings of the last arm().
+         *
+         * @return const ScopeConfig& -> The settings.
+         */
+        const ScopeConfig& getConfig() const;
+
+        /**
+         * @brief Getter for the number of samples of a capture.
+         *
+         * @return uint16_t -> The buffer size.
+         */
+        uint16_t getSampleCount() const;
+
+        /**
+         * @brief Getter for the time between two samples.
+         *
+         * @param prescaler -> The ADC clock divider.
+         * @return uint32_t -> The interval in ns.
+         */
+        static uint32_t getSampleIntervalNs(uint8_t prescaler);
+
+        /**
+         * @brief Getter for the time of the trigger sample.
+         *
+         * @return uint64_t -> The monotonic time in us, 0 before the first trigger.
+         */
+        uint64_t getTriggerUs() const;
+
+        /**
+         * @brief Function to check if the frozen capture saw its trigger.
+         *
+         * @return true -> if it did
+         * @return false -> if it was frozen at the timeout
+         */
+        bool wasTriggered() const;
+
+        /**
+         * @brief Function to build the wire header of the frozen capture.
+         *
+         * @param buffer -> The header, SCOPE_HEADER_SIZE bytes.
+         * @param triggerEpochMs -> The time of the trigger sample.
+         */
+        void writeHeader(uint8_t* buffer, uint64_t triggerEpochMs) const;
+
+        /**
+         * @brief Function to copy samples of the frozen capture in time order.
+         *
+         * @param offset -> The first sample, 0 is the oldest.
+         * @param buffer -> The target.
+         * @param length -> The number of samples to copy at most.
+         * @return uint16_t -> The number of samples copied, 0 after the last one or if nothing is frozen.
+         */
+        uint16_t readSamples(uint16_t offset, uint8_t* buffer, uint16_t length);
+
+    private:
+        ScopeCapture();
+        ~ScopeCapture() = default;
+
+        static ScopeCapture* _instance;
+
+        uint8_t* _buffer = nullptr;
+        uint16_t _size = 0;
+        ScopeConfig _config = {};
+        bool _externalAttached = false;
+
+        // ADC interrupt while armed
+        volatile ScopeState _state = ScopeState::IDLE;
+        uint16_t _write = 0;            // next sample to overwrite, the oldest one once frozen
+        uint16_t _count = 0;            // samples before the trigger so far, after it the ones left
+        uint32_t _samplesLeft = 0;      // timeout in samples
+        uint16_t _previous = 0;
+        volatile bool _externalEdge = false;
+        bool _triggered = false;
+        uint64_t _triggerUs = 0;
+        uint16_t _sampleUs = 0;         // a sample is this old when its interrupt runs
+
+        static bool onSample(uint16_t value);
+        static void onExternalEdge();
+        bool handleSample(uint16_t value);
+        bool isTrigger(uint16_t value) const;
+        bool freeze(bool triggered);
+        void detachExternal();
+
+        ScopeCapture(const ScopeCapture&) = delete;
+        ScopeCapture& operator=(const ScopeCapture&) = delete;
+    };
+}
+
+#endif // SCOPECAPTURE_H
@@ -0,0 +1,299 @@
+/**
+ * @file sensorHistory.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the decimated time series of the snapshot channels.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "sensorHistory.h"
+#include <ptrUtils.h>
+#include <util/atomic.h>
+
+using namespace sensorModule;
+
+SensorHistory* SensorHistory::_instance = nullptr;
+
+SensorHistory::SensorHistory()
+{
+
+}
+
+SensorHistory* SensorHistory::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new SensorHistory();
+    }
+    return _instance;
+}
+
+bool SensorHistory::begin(uint8_t* storage, size_t size, const SensorChannel* channels, uint8_t channelCount)
+{
+    _storage = nullptr;
+    if (PtrUtils::IsNullPtr(storage) || PtrUtils::IsNullPtr(channels) || channelCount == 0 || channelCount > HISTORY_MAX_CHANNELS)
+    {
+        return false;
+    }
+
+    uint32_t channelBytes = size / channelCount;
+    if (channelBytes > 0xFFFF)
+    {
+        channelBytes = 0xFFFF;
+    }
+
+    // one slot per ring is always being written, so three slots show two points
+    uint16_t rawDepth = (channelBytes / 4) / sizeof(float);
+    uint16_t bucketDepth = (channelBytes - rawDepth * sizeof(float)) / (bucketTiers * sizeof(Bucket));
+    if (rawDepth < 3 || bucketDepth < 3)
+    {
+        return false;
+    }
+
+    uint16_t offset = 0;
+    for (uint8_t tier = 0; tier < static_cast<uint8_t>(HistoryResolution::COUNT); tier++)
+    {
+        Tier& t = _tiers[tier];
+        t.depth = (tier == 0) ? rawDepth : bucketDepth;
+        t.offset = offset;
+        t.written = 0;
+        t.newestUs = 0;
+        t.fill = 0;
+        offset += t.depth * ((tier == 0) ? sizeof(float) : sizeof(Bucket));
+    }
+
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        _channels[i] = channels[i];
+        for (uint8_t tier = 0; tier < bucketTiers; tier++)
+        {
+            _open[i][tier].count = 0;
+        }
+    }
+
+    _channelCount = channelCount;
+    _channelBytes = channelBytes;
+    _storage = storage;
+    return true;
+}
+
+bool SensorHistory::isInitialized() const
+{
+    return !PtrUtils::IsNullPtr(_storage);
+}
+
+void SensorHistory::sample(uint64_t timestampUs)
+{
+    if (!isInitialized())
+    {
+        return;
+    }
+
+    SensorSnapshot snapshot = SensorSnapshotStore::getInstance()->read();
+    Tier& raw = _tiers[static_cast<uint8_t>(HistoryResolution::RAW)];
+
+    // the slot of sequence 'written' is invisible to readers until the counter moves
+    for (uint8_t i = 0; i < _channelCount; i++)
+    {
+        const SensorReading& reading = snapshot.readings[static_cast<uint8_t>(_channels[i])];
+        bool fresh = reading.timestampUs != 0 && reading.timestampUs + HISTORY_STALE_US >= timestampUs;
+        float value = fresh ? reading.value : NAN;
+
+        *rawSlot(i, raw.written) = value;
+        accumulate(_open[i][0], value, value, value);
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        raw.written++;
+        raw.newestUs = timestampUs;
+    }
+
+    if (++raw.fill >= HISTORY_DECIMATION)
+    {
+        raw.fill = 0;
+        closeBuckets(static_cast<uint8_t>(HistoryResolution::SECOND), timestampUs);
+    }
+}
+
+void SensorHistory::closeBuckets(uint8_t tier, uint64_t timestampUs)
+{
+    while (tier < static_cast<uint8_t>(HistoryResolution::COUNT))
+    {
+        Tier& t = _tiers[tier];
+        for (uint8_t i = 0; i < _channelCount; i++)
+        {
+            Accumulator& open = _open[i][tier - 1];
+            Bucket bucket;
+            if (open.count > 0)
+            {
+                bucket.min = open.min;
+                bucket.max = open.max;
+                bucket.mean = open.sum / open.count;
+            }
+            else
+            {
+                bucket.min = bucket.max = bucket.mean = NAN;
+            }
+            open.count = 0;
+
+            *bucketSlot(i, tier, t.written) = bucket;
+            if (tier < bucketTiers)
+            {
+                accumulate(_open[i][tier], bucket.min, bucket.max, bucket.mean);
+            }
+        }
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            t.written++;
+            t.newestUs = timestampUs;
+        }
+
+        if (tier == bucketTiers || ++t.fill < HISTORY_DECIMATION)
+        {
+            return;
+        }
+        t.fill = 0;
+        tier++;
+    }
+}
+
+void SensorHistory::accumulate(Accumulator& open, float min, float max, float mean)
+{
+    if (isnan(mean))
+    {
+        return;
+    }
+
+    if (open.count == 0)
+    {
+        open.min = min;
+        open.max = max;
+        open.sum = mean;
+    }
+    else
+    {
+        if (min < open.min) open.min = min;
+        if (max > open.max) open.max = max;
+        open.sum += mean;
+    }
+    open.count++;
+}
+
+bool SensorHistory::isTracked(SensorChannel channel) const
+{
+    return indexOf(channel) >= 0;
+}
+
+uint16_t SensorHistory::getDepth(HistoryResolution resolution) const
+{
+    if (!isInitialized() || resolution >= HistoryResolution::COUNT)
+    {
+        return 0;
+    }
+    return _tiers[static_cast<uint8_t>(resolution)].depth - 1;
+}
+
+uint32_t SensorHistory::getPeriodMs(HistoryResolution resolution)
+{
+    uint32_t period = HISTORY_RAW_PERIOD_MS;
+    for (uint8_t tier = 0; tier < static_cast<uint8_t>(resolution); tier++)
+    {
+        period *= HISTORY_DECIMATION;
+    }
+    return period;
+}
+
+void SensorHistory::getRange(HistoryResolution resolution, uint32_t& oldest, uint32_t& next) const
+{
+    oldest = next = 0;
+    if (!isInitialized() || resolution >= HistoryResolution::COUNT)
+    {
+        return;
+    }
+
+    const Tier& t = _tiers[static_cast<uint8_t>(resolution)];
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        next = t.written;
+    }
+    oldest = (next + 1 > t.depth) ? next + 1 - t.depth : 0;
+}
+
+bool SensorHistory::getPoint(SensorChannel channel, HistoryResolution resolution, uint32_t sequence, HistoryPoint& point) const
+{
+    int8_t index = indexOf(channel);
+    if (index < 0 || resolution >= HistoryResolution::COUNT)
+    {
+        return false;
+    }
+
+    const uint8_t tier = static_cast<uint8_t>(resolution);
+    const Tier& t = _tiers[tier];
+    bool stored = false;
+    uint32_t next = 0;
+    uint64_t newestUs = 0;
+
+    // range check and copy must not interleave with sample()
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        next = t.written;
+        newestUs = t.newestUs;
+        uint32_t oldest = (next + 1 > t.depth) ? next + 1 - t.depth : 0;
+        if (sequence >= oldest && sequence < next)
+        {
+            if (tier == 0)
+            {
+                point.min = point.max = point.mean = *rawSlot(index, sequence);
+            }
+            else
+            {
+                const Bucket* bucket = bucketSlot(index, tier, sequence);
+                point.min = bucket->min;
+                point.max = bucket->max;
+                point.mean = bucket->mean;
+            }
+            stored = true;
+        }
+    }
+
+    if (stored)
+    {
+        // nominal spacing, the points are written at the period of the tier
+        point.timestampUs = newestUs - static_cast<uint64_t>(next - 1 - sequence) * getPeriodMs(resolution) * 1000ULL;
+    }
+    return stored;
+}
+
+int8_t SensorHistory::indexOf(SensorChannel channel) const
+{
+    if (!isInitialized())
+    {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < _channelCount; i++)
+    {
+        if (_channels[i] == channel)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+float* SensorHistory::rawSlot(uint8_t index, uint32_t sequence) const
+{
+    const Tier& t = _tiers[static_cast<uint8_t>(HistoryResolution::RAW)];
+    uint8_t* block = _storage + static_cast<uint32_t>(index) * _channelBytes + t.offset;
+    return reinterpret_cast<float*>(block) + (sequence % t.depth);
+}
+
+SensorHistory::Bucket* SensorHistory::bucketSlot(uint8_t index, uint8_t tier, uint32_t sequence) const
+{
+    const Tier& t = _tiers[tier];
+    uint8_t* block = _storage + static_cast<uint32_t>(index) * _channelBytes + t.offset;
+    return reinterpret_cast<Bucket*>(block) + (sequence % t.depth);
+}
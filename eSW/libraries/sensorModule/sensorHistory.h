@@ -0,0 +1,188 @@
+/**
+ * @file sensorHistory.h
+ * @author Adrian Goessl
+ * @brief Header file for the decimated time series of the snapshot channels.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SENSORHISTORY_H
+#define SENSORHISTORY_H
+
+#include <Arduino.h>
+#include "sensorSnapshot.h"
+
+#define HISTORY_MAX_CHANNELS 6
+#define HISTORY_RAW_PERIOD_MS 100       // raw tier, 10 Hz
+#define HISTORY_DECIMATION 10           // raw samples per 1 s bucket, 1 s buckets per 10 s bucket
+#define HISTORY_STALE_US 10000000ULL    // a value older than 10 s is stored as a gap
+
+/// @brief Namespace for the sensor module. \namespace sensorModule
+namespace sensorModule
+{
+    /// @brief Enum class for the resolutions of the history, each a ring buffer per channel. \enum HistoryResolution
+    enum class HistoryResolution : uint8_t
+    {
+        RAW,            // every sample, HISTORY_RAW_PERIOD_MS
+        SECOND,         // min/max/mean of HISTORY_DECIMATION raw samples
+        TEN_SECONDS,    // min/max/mean of HISTORY_DECIMATION 1 s buckets
+        COUNT
+    };
+
+    /// @brief Structure for one point of the history. \struct HistoryPoint
+    /// A raw point has min == max == mean, a gap has NAN values.
+    struct HistoryPoint
+    {
+        uint64_t timestampUs;   // monotonic time of the last raw sample in the point
+        float min;
+        float max;
+        float mean;
+    };
+
+    /// @brief Class to keep the recent history of selected snapshot channels in several resolutions. \class SensorHistory
+    /// The acquisition task calls sample() at 10 Hz, the values come from the SensorSnapshotStore.
+    /// The ring buffers live in a caller provided memory block, internal RAM or the external SRAM
+    /// of the XMEM interface, the bookkeeping stays in internal RAM.
+    class SensorHistory
+    {
+    public:
+
+        /**
+         * @brief Get the Instance object
+         *
+         * @return SensorHistory*
+         */
+        static SensorHistory* getInstance();
+
+        /**
+         * @brief Function to split the memory block between the channels and resolutions.
+         * A quarter of the block of each channel goes to the raw samples, the rest to the buckets.
+         *
+         * @param storage -> The memory block of the ring buffers.
+         * @param size -> The size of the block in bytes.
+         * @param channels -> The channels to record.
+         * @param channelCount -> The number of channels, at most HISTORY_MAX_CHANNELS.
+         * @return true -> if every resolution got at least two points
+         * @return false -> if the block is too small
+         */
+        bool begin(uint8_t* storage, size_t size, const SensorChannel* channels, uint8_t channelCount);
+
+        /**
+         * @brief Function to check if the history is initialized.
+         *
+         * @return true -> if begin() succeeded
+         * @return false -> if not
+         */
+        bool isInitialized() const;
+
+        /**
+         * @brief Function to append the newest snapshot values of all channels, acquisition task only.
+         * Closes a bucket every HISTORY_DECIMATION samples of the resolution below.
+         *
+         * @param timestampUs -> The monotonic time of the sample.
+         */
+        void sample(uint64_t timestampUs);
+
+        /**
+         * @brief Function to check if a channel is recorded.
+         *
+         * @param channel -> The channel.
+         * @return true -> if begin() got the channel
+         * @return false -> if not
+         */
+        bool isTracked(SensorChannel channel) const;
+
+        /**
+         * @brief Getter for the number of points a resolution keeps per channel.
+         *
+         * @param resolution -> The resolution.
+         * @return uint16_t -> The depth of the ring buffers.
+         */
+        uint16_t getDepth(HistoryResolution resolution) const;
+
+        /**
+         * @brief Getter for the time between two points of a resolution.
+         *
+         * @param resolution -> The resolution.
+         * @return uint32_t -> The period in ms.
+         */
+        static uint32_t getPeriodMs(HistoryResolution resolution);
+
+        /**
+         * @brief Function to get the sequence numbers of the points a resolution holds.
+         * Sequence numbers count the points since begin(), the same for all channels.
+         *
+         * @param resolution -> The resolution.
+         * @param oldest -> The oldest point still stored.
+         * @param next -> The sequence number of the next point, oldest == next if empty.
+         */
+        void getRange(HistoryResolution resolution, uint32_t& oldest, uint32_t& next) const;
+
+        /**
+         * @brief Function to copy one point of a channel.
+         *
+         * @param channel -> The channel.
+         * @param resolution -> The resolution.
+         * @param sequence -> The sequence number, see getRange().
+         * @param point -> The copy.
+         * @return true -> if the point is stored
+         * @return false -> if the channel is not recorded or the point is overwritten or not written yet
+         */
+        bool getPoint(SensorChannel channel, HistoryResolution resolution, uint32_t sequence, HistoryPoint& point) const;
+
+    private:
+        SensorHistory();
+        ~SensorHistory() = default;
+
+        /// @brief Bookkeeping of one resolution, shared by all channels. \struct Tier
+        struct Tier
+        {
+            uint16_t depth;         // slots per channel, one is always being written
+            uint16_t offset;        // byte offset in the block of a channel
+            uint32_t written;       // points written since begin()
+            uint64_t newestUs;      // time of the newest point
+            uint8_t fill;           // points of this tier in the open bucket of the tier above
+        };
+
+        /// @brief Stored bucket of a channel. \struct Bucket
+        struct Bucket
+        {
+            float min;
+            float max;
+            float mean;
+        };
+
+        /// @brief Open bucket of a channel, collects the points of the tier below. \struct Accumulator
+        struct Accumulator
+        {
+            float min;
+            float max;
+            float sum;
+            uint8_t count;          // number of valid values in sum
+        };
+
+        static const uint8_t bucketTiers = static_cast<uint8_t>(HistoryResolution::COUNT) - 1;
+
+        static SensorHistory* _instance;
+
+        uint8_t* _storage = nullptr;
+        uint16_t _channelBytes = 0;
+        uint8_t _channelCount = 0;
+        SensorChannel _channels[HISTORY_MAX_CHANNELS];
+        Tier _tiers[static_cast<uint8_t>(HistoryResolution::COUNT)];
+        Accumulator _open[HISTORY_MAX_CHANNELS][bucketTiers];
+
+        int8_t indexOf(SensorChannel channel) const;
+        float* rawSlot(uint8_t index, uint32_t sequence) const;
+        Bucket* bucketSlot(uint8_t index, uint8_t tier, uint32_t sequence) const;
+        void accumulate(Accumulator& open, float min, float max, float mean);
+        void closeBuckets(uint8_t tier, uint64_t timestampUs);
+
+        SensorHistory(const SensorHistory&) = delete;
+        SensorHistory& operator=(const SensorHistory&) = delete;
+    };
+}
+
+#endif // SENSORHISTORY_H
@@ -12,6 +12,7 @@
 #include <SPI.h>
 #include <Arduino.h>
 #include <serialMenu.h>
+#include <timeModule.h>
 
 using namespace sensorModule;
 
@@ -61,6 +62,14 @@ float SensorModuleInternals::readSensor(SensorType type)
     }
 }
 
+SensorReading SensorModuleInternals::readSensorSample(SensorType type)
+{
+    SensorReading reading;
+    reading.value = readSensor(type);
+    reading.timestampUs = timeModule::TimeModuleInternals::getMonotonicMicros();
+    return reading;
+}
+
 bool SensorModuleInternals::calibrateSensor(SensorType type)
 {
 	uint8_t status;
@@ -39,6 +39,13 @@ namespace sensorModule
         UNKNOWN
     };
 
+    /// @brief Structure for a sensor value with its monotonic capture time. \struct SensorReading
+    struct SensorReading
+    {
+        float value;
+        uint64_t timestampUs;
+    };
+
     /// @brief Class for the sensor module internals. \class SensorModuleInternals
     class SensorModuleInternals : public TemperatureSensor, public PressureSensor
     {
@@ -60,6 +67,14 @@ namespace sensorModule
          */
         float readSensor(SensorType type);
 
+        /**
+         * @brief Function to read the sensor and stamp the value at capture time.
+         *
+         * @param type -> The type of the sensor to read.
+         * @return SensorReading -> The value of the sensor and the monotonic time it was captured.
+         */
+        SensorReading readSensorSample(SensorType type);
+
         /**
          * @brief Function to calibrate the sensor.
          *
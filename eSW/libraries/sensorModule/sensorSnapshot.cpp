@@ -0,0 +1,62 @@
+/**
+ * @file sensorSnapshot.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the shared snapshot of the periodically acquired sensor values.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "sensorSnapshot.h"
+#include <ptrUtils.h>
+
+using namespace sensorModule;
+
+SensorSnapshotStore* SensorSnapshotStore::_instance = nullptr;
+
+SensorSnapshotStore::SensorSnapshotStore()
+{
+
+}
+
+SensorSnapshotStore* SensorSnapshotStore::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new SensorSnapshotStore();
+    }
+    return _instance;
+}
+
+void SensorSnapshotStore::publish(SensorChannel channel, float value, uint64_t timestampUs)
+{
+    publish(channel, &value, 1, timestampUs);
+}
+
+void SensorSnapshotStore::publish(SensorChannel first, const float* values, uint8_t count, uint64_t timestampUs)
+{
+    SensorSnapshot& next = _snapshot.beginWrite();
+    for (uint8_t i = 0; i < count && static_cast<uint8_t>(first) + i < static_cast<uint8_t>(SensorChannel::COUNT); i++)
+    {
+        SensorReading& reading = next.readings[static_cast<uint8_t>(first) + i];
+        reading.value = values[i];
+        reading.timestampUs = timestampUs;
+    }
+    next.version++;
+    _snapshot.commit();
+}
+
+SensorReading SensorSnapshotStore::read(SensorChannel channel)
+{
+    return _snapshot.read().readings[static_cast<uint8_t>(channel)];
+}
+
+SensorSnapshot SensorSnapshotStore::read()
+{
+    return _snapshot.read();
+}
+
+uint32_t SensorSnapshotStore::getVersion()
+{
+    return _snapshot.getVersion();
+}
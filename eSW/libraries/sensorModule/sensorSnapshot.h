@@ -0,0 +1,114 @@
+/**
+ * @file sensorSnapshot.h
+ * @author Adrian Goessl
+ * @brief Header file for the shared snapshot of the periodically acquired sensor values.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SENSORSNAPSHOT_H
+#define SENSORSNAPSHOT_H
+
+#include <Arduino.h>
+#include <snapshot.h>
+#include "sensorModule.h"
+
+/// @brief Namespace for the sensor module. \namespace sensorModule
+namespace sensorModule
+{
+    /// @brief Enum class for the channels of the snapshot. \enum SensorChannel
+    enum class SensorChannel : uint8_t
+    {
+        HV_VOLTAGE,             // V
+        HV_CURRENT,             // uA
+        HV_POWER,               // uW
+        HV_FREQUENCY,           // Hz
+        HV_DUTY_CYCLE,          // %
+        HV_FREQUENCY_RAW,       // ADC counts of the frequency poti
+        HV_DUTY_CYCLE_RAW,      // ADC counts of the duty cycle poti
+        TEMPERATURE_INDOOR,     // C
+        TEMPERATURE_OUTDOOR,    // C
+        VAT_PRESSURE,           // mbar
+        VAT_POSITION,           // position
+        COUNT
+    };
+
+    /// @brief Structure for all channels at one version of the snapshot. \struct SensorSnapshot
+    /// A channel that was never sampled has timestampUs 0.
+    struct SensorSnapshot
+    {
+        uint32_t version;
+        SensorReading readings[static_cast<uint8_t>(SensorChannel::COUNT)];
+    };
+
+    /// @brief Class to share the newest sensor values between the acquisition task and all readers. \class SensorSnapshotStore
+    /// Only the acquisition task talks to the sensors and publishes, endpoints, report and control read the copy.
+    /// Lock free, see Snapshot, a reader never waits for the acquisition task.
+    class SensorSnapshotStore
+    {
+    public:
+
+        /**
+         * @brief Get the Instance object
+         *
+         * @return SensorSnapshotStore*
+         */
+        static SensorSnapshotStore* getInstance();
+
+        /**
+         * @brief Function to publish a new value of a channel, increments the version, acquisition task only.
+         *
+         * @param channel -> The channel.
+         * @param value -> The value.
+         * @param timestampUs -> The monotonic capture time, see TimeModuleInternals::getMonotonicMicros().
+         */
+        void publish(SensorChannel channel, float value, uint64_t timestampUs);
+
+        /**
+         * @brief Function to publish the values of several channels captured together, one version step, acquisition task only.
+         *
+         * @param first -> The first channel, the others follow in enum order.
+         * @param values -> The values.
+         * @param count -> The number of values.
+         * @param timestampUs -> The monotonic capture time of all values.
+         */
+        void publish(SensorChannel first, const float* values, uint8_t count, uint64_t timestampUs);
+
+        /**
+         * @brief Function to read the newest value of a channel.
+         *
+         * @param channel -> The channel.
+         * @return SensorReading -> The value and its capture time, timestampUs 0 if never sampled.
+         */
+        SensorReading read(SensorChannel channel);
+
+        /**
+         * @brief Function to copy all channels at one version.
+         *
+         * @return SensorSnapshot -> The copy.
+         */
+        SensorSnapshot read();
+
+        /**
+         * @brief Getter for the version, changes with every publish.
+         *
+         * @return uint32_t -> The version.
+         */
+        uint32_t getVersion();
+
+    private:
+        SensorSnapshotStore();
+        ~SensorSnapshotStore() = default;
+
+        static SensorSnapshotStore* _instance;
+
+        Snapshot<SensorSnapshot> _snapshot;
+
+        SensorSnapshotStore(const SensorSnapshotStore&) = delete;
+        SensorSnapshotStore& operator=(const SensorSnapshotStore&) = delete;
+    };
+}
+
+#endif // SENSORSNAPSHOT_H
@@ -0,0 +1,149 @@
+/**
+ * @file sensorStatistics.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the streaming statistics of the snapshot channels.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "sensorStatistics.h"
+#include <ptrUtils.h>
+
+using namespace sensorModule;
+using namespace calcModule;
+
+SensorStatistics* SensorStatistics::_instance = nullptr;
+
+static inline void barrier()
+{
+    __asm__ __volatile__("" ::: "memory");
+}
+
+SensorStatistics::SensorStatistics()
+{
+
+}
+
+SensorStatistics* SensorStatistics::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new SensorStatistics();
+    }
+    return _instance;
+}
+
+bool SensorStatistics::begin(const SensorChannel* channels, uint8_t channelCount)
+{
+    _channelCount = 0;
+    if (PtrUtils::IsNullPtr(channels) || channelCount > STATS_MAX_CHANNELS)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        Channel& entry = _channels[i];
+        entry.channel = channels[i];
+        entry.stats.reset();
+        entry.median = P2Quantile(0.5f);
+        entry.percentile95 = P2Quantile(0.95f);
+        entry.sinceUs = 0;
+        entry.sequence = 0;
+        entry.resetRequested = false;
+    }
+    _channelCount = channelCount;
+    return true;
+}
+
+void SensorStatistics::add(SensorChannel channel, float value, uint64_t timestampUs)
+{
+    int8_t index = indexOf(channel);
+    if (index < 0)
+    {
+        return;
+    }
+
+    Channel& entry = _channels[index];
+    entry.sequence++;
+    barrier();
+
+    if (entry.resetRequested || entry.stats.getCount() == 0)
+    {
+        entry.stats.reset();
+        entry.median.reset();
+        entry.percentile95.reset();
+        entry.sinceUs = timestampUs;
+        entry.resetRequested = false;
+    }
+
+    entry.stats.add(value);
+    entry.median.add(value);
+    entry.percentile95.add(value);
+
+    barrier();
+    entry.sequence++;
+}
+
+bool SensorStatistics::isTracked(SensorChannel channel) const
+{
+    return indexOf(channel) >= 0;
+}
+
+bool SensorStatistics::getSummary(SensorChannel channel, StatsSummary& summary) const
+{
+    int8_t index = indexOf(channel);
+    if (index < 0)
+    {
+        return false;
+    }
+
+    const Channel& entry = _channels[index];
+    RunningStats stats;
+    P2Quantile median;
+    P2Quantile percentile95;
+    uint64_t sinceUs;
+    uint8_t before;
+    do
+    {
+        before = entry.sequence;
+        barrier();
+        stats = entry.stats;
+        median = entry.median;
+        percentile95 = entry.percentile95;
+        sinceUs = entry.sinceUs;
+        barrier();
+    } while ((before & 1) || entry.sequence != before);
+
+    summary.count = stats.getCount();
+    summary.mean = stats.getMean();
+    summary.standardDeviation = stats.getStandardDeviation();
+    summary.min = stats.getMin();
+    summary.max = stats.getMax();
+    summary.median = median.getValue();
+    summary.percentile95 = percentile95.getValue();
+    summary.sinceUs = sinceUs;
+    return true;
+}
+
+void SensorStatistics::reset(SensorChannel channel)
+{
+    int8_t index = indexOf(channel);
+    if (index >= 0)
+    {
+        _channels[index].resetRequested = true;
+    }
+}
+
+int8_t SensorStatistics::indexOf(SensorChannel channel) const
+{
+    for (uint8_t i = 0; i < _channelCount; i++)
+    {
+        if (_channels[i].channel == channel)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
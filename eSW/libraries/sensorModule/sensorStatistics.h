@@ -0,0 +1,124 @@
+/**
+ * @file sensorStatistics.h
+ * @author Adrian Goessl
+ * @brief Header file for the streaming statistics of the snapshot channels.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SENSORSTATISTICS_H
+#define SENSORSTATISTICS_H
+
+#include <Arduino.h>
+#include <runningStats.h>
+#include "sensorSnapshot.h"
+
+#define STATS_MAX_CHANNELS 3
+
+/// @brief Namespace for the sensor module. \namespace sensorModule
+namespace sensorModule
+{
+    /// @brief Structure for the summary of a channel since the last reset. \struct StatsSummary
+    struct StatsSummary
+    {
+        uint32_t count;
+        float mean;
+        float standardDeviation;
+        float min;
+        float max;
+        float median;           // P² estimate
+        float percentile95;     // P² estimate
+        uint64_t sinceUs;       // monotonic time of the reset
+    };
+
+    /// @brief Class to summarise every sample of selected channels without storing them. \class SensorStatistics
+    /// The acquisition task offers every sample with add() and never waits, a reader retries its copy
+    /// when an update ran meanwhile (sequence lock). Windows of any length cost the same 130 bytes per channel.
+    class SensorStatistics
+    {
+    public:
+
+        /**
+         * @brief Get the Instance object
+         *
+         * @return SensorStatistics*
+         */
+        static SensorStatistics* getInstance();
+
+        /**
+         * @brief Function to select the channels to summarise.
+         *
+         * @param channels -> The channels.
+         * @param channelCount -> The number of channels, at most STATS_MAX_CHANNELS.
+         * @return true -> if the channels are accepted
+         * @return false -> if there are too many
+         */
+        bool begin(const SensorChannel* channels, uint8_t channelCount);
+
+        /**
+         * @brief Function to offer a sample, acquisition task only. Other channels are ignored.
+         *
+         * @param channel -> The channel.
+         * @param value -> The value.
+         * @param timestampUs -> The monotonic capture time.
+         */
+        void add(SensorChannel channel, float value, uint64_t timestampUs);
+
+        /**
+         * @brief Function to check if a channel is summarised.
+         *
+         * @param channel -> The channel.
+         * @return true -> if begin() got the channel
+         * @return false -> if not
+         */
+        bool isTracked(SensorChannel channel) const;
+
+        /**
+         * @brief Function to get the summary of a channel.
+         * Retries while add() runs, call from a task without a higher priority than the acquisition task.
+         *
+         * @param channel -> The channel.
+         * @param summary -> The summary, values NAN without samples.
+         * @return true -> if the channel is summarised
+         * @return false -> if not
+         */
+        bool getSummary(SensorChannel channel, StatsSummary& summary) const;
+
+        /**
+         * @brief Function to start a new window, takes effect with the next sample.
+         *
+         * @param channel -> The channel.
+         */
+        void reset(SensorChannel channel);
+
+    private:
+        SensorStatistics();
+        ~SensorStatistics() = default;
+
+        /// @brief Accumulators of one channel. \struct Channel
+        struct Channel
+        {
+            SensorChannel channel;
+            calcModule::RunningStats stats;
+            calcModule::P2Quantile median;
+            calcModule::P2Quantile percentile95;
+            uint64_t sinceUs;
+            volatile uint8_t sequence;      // odd while add() updates the accumulators
+            volatile bool resetRequested;
+        };
+
+        static SensorStatistics* _instance;
+
+        uint8_t _channelCount = 0;
+        Channel _channels[STATS_MAX_CHANNELS];
+
+        int8_t indexOf(SensorChannel channel) const;
+
+        SensorStatistics(const SensorStatistics&) = delete;
+        SensorStatistics& operator=(const SensorStatistics&) = delete;
+    };
+}
+
+#endif // SENSORSTATISTICS_H
@@ -0,0 +1,250 @@
+/**
+ * @file sensorTrend.cpp
+ * @author Adrian Goessl
+ * @brief Implementation of the compressed long term trend of the snapshot channels.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ */
+#include "sensorTrend.h"
+#include <ptrUtils.h>
+#include <timeModule.h>
+#include <util/atomic.h>
+
+using namespace sensorModule;
+using namespace calcModule;
+
+SensorTrend* SensorTrend::_instance = nullptr;
+
+SensorTrend::SensorTrend()
+{
+
+}
+
+SensorTrend* SensorTrend::getInstance()
+{
+    if (PtrUtils::IsNullPtr(_instance))
+    {
+        _instance = new SensorTrend();
+    }
+    return _instance;
+}
+
+bool SensorTrend::begin(uint8_t* storage, size_t size, const TrendConfig* configs, uint8_t channelCount)
+{
+    _initialized = false;
+    if (PtrUtils::IsNullPtr(storage) || PtrUtils::IsNullPtr(configs) || channelCount == 0 || channelCount > TREND_MAX_CHANNELS)
+    {
+        return false;
+    }
+
+    // one slot per ring is always being written
+    uint32_t depth = (size / channelCount) / sizeof(TrendPoint);
+    if (depth < 5)
+    {
+        return false;
+    }
+    _depth = (depth > 0xFFFF) ? 0xFFFF : depth;
+
+    for (uint8_t i = 0; i < channelCount; i++)
+    {
+        Channel& entry = _channels[i];
+        entry.config = configs[i];
+        entry.door.configure(configs[i].deadband, configs[i].deviation, TREND_MAX_INTERVAL_MS);
+        entry.ring = reinterpret_cast<TrendPoint*>(storage) + static_cast<uint32_t>(i) * _depth;
+        entry.written = 0;
+        entry.samples = 0;
+        entry.newestMs = 0;
+        entry.hasTail = false;
+    }
+
+    _channelCount = channelCount;
+    _initialized = true;
+    return true;
+}
+
+bool SensorTrend::isInitialized() const
+{
+    return _initialized;
+}
+
+void SensorTrend::add(SensorChannel channel, float value, uint64_t timestampUs)
+{
+    int8_t index = indexOf(channel);
+    if (index < 0)
+    {
+        return;
+    }
+
+    Channel& entry = _channels[index];
+    if (entry.config.logarithmic)
+    {
+        value = (value > 0.0f) ? log10(value) : NAN;
+    }
+
+    uint32_t timeMs = timestampUs / 1000;
+    TrendPoint archived[2];
+    uint8_t count = entry.door.add(timeMs, value, archived);
+
+    // the slot of sequence 'written' is invisible to readers until the counter moves
+    for (uint8_t i = 0; i < count; i++)
+    {
+        entry.ring[entry.written % _depth] = archived[i];
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            entry.written++;
+        }
+    }
+
+    TrendPoint tail;
+    bool hasTail = entry.door.getHeld(tail);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        entry.tail = tail;
+        entry.hasTail = hasTail;
+        entry.samples++;
+        entry.newestMs = timeMs;
+    }
+}
+
+bool SensorTrend::isTracked(SensorChannel channel) const
+{
+    return indexOf(channel) >= 0;
+}
+
+void SensorTrend::getRange(SensorChannel channel, uint32_t& oldest, uint32_t& next) const
+{
+    oldest = next = 0;
+    int8_t index = indexOf(channel);
+    if (index < 0)
+    {
+        return;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        next = _channels[index].written;
+    }
+    oldest = (next + 1 > _depth) ? next + 1 - _depth : 0;
+}
+
+bool SensorTrend::getPoint(SensorChannel channel, uint32_t sequence, SensorReading& point) const
+{
+    int8_t index = indexOf(channel);
+    if (index < 0)
+    {
+        return false;
+    }
+
+    const Channel& entry = _channels[index];
+    TrendPoint stored;
+    bool valid = false;
+
+    // range check and copy must not interleave with add()
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        uint32_t next = entry.written;
+        uint32_t oldest = (next + 1 > _depth) ? next + 1 - _depth : 0;
+        if (sequence >= oldest && sequence < next)
+        {
+            stored = entry.ring[sequence % _depth];
+            valid = true;
+        }
+    }
+
+    if (valid)
+    {
+        point.value = toValue(entry, stored.value);
+        point.timestampUs = toMicros(stored.timeMs);
+    }
+    return valid;
+}
+
+bool SensorTrend::getTail(SensorChannel channel, SensorReading& point) const
+{
+    int8_t index = indexOf(channel);
+    if (index < 0)
+    {
+        return false;
+    }
+
+    const Channel& entry = _channels[index];
+    TrendPoint tail;
+    bool hasTail;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        tail = entry.tail;
+        hasTail = entry.hasTail;
+    }
+
+    if (hasTail)
+    {
+        point.value = toValue(entry, tail.value);
+        point.timestampUs = toMicros(tail.timeMs);
+    }
+    return hasTail;
+}
+
+TrendStats SensorTrend::getStats(SensorChannel channel) const
+{
+    TrendStats stats = {};
+    int8_t index = indexOf(channel);
+    if (index < 0)
+    {
+        return stats;
+    }
+
+    const Channel& entry = _channels[index];
+    uint32_t next;
+    uint32_t newestMs;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        next = entry.written;
+        stats.samples = entry.samples;
+        newestMs = entry.newestMs;
+    }
+
+    uint32_t oldest = (next + 1 > _depth) ? next + 1 - _depth : 0;
+    stats.archived = next;
+    stats.points = next - oldest;
+    stats.depth = _depth - 1;
+
+    SensorReading first;
+    if (getPoint(channel, oldest, first))
+    {
+        uint32_t firstMs = first.timestampUs / 1000;
+        stats.spanMs = newestMs - firstMs;
+    }
+    return stats;
+}
+
+int8_t SensorTrend::indexOf(SensorChannel channel) const
+{
+    if (!_initialized)
+    {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < _channelCount; i++)
+    {
+        if (_channels[i].config.channel == channel)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+float SensorTrend::toValue(const Channel& entry, float stored) const
+{
+    return (entry.config.logarithmic && !isnan(stored)) ? pow(10.0f, stored) : stored;
+}
+
+uint64_t SensorTrend::toMicros(uint32_t timeMs) const
+{
+    // extend the 32 bit ms back to the 64 bit monotonic clock, valid for 49 days
+    uint64_t nowMs = timeModule::TimeModuleInternals::getMonotonicMicros() / 1000;
+    uint32_t age = static_cast<uint32_t>(nowMs) - timeMs;
+    return (nowMs - age) * 1000ULL;
+}
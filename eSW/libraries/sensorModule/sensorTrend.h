@@ -0,0 +1,167 @@
+/**
+ * @file sensorTrend.h
+ * @author Adrian Goessl
+ * @brief Header file for the compressed long term trend of the snapshot channels.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef SENSORTREND_H
+#define SENSORTREND_H
+
+#include <Arduino.h>
+#include <swingingDoor.h>
+#include "sensorSnapshot.h"
+
+#define TREND_MAX_CHANNELS 4
+#define TREND_MAX_INTERVAL_MS 600000UL  // a plateau is confirmed at least every 10 min
+
+/// @brief Namespace for the sensor module. \namespace sensorModule
+namespace sensorModule
+{
+    /// @brief Structure for the error bounds of a trend channel. \struct TrendConfig
+    /// A logarithmic channel is compressed as log10(value), the bounds are in decades then.
+    struct TrendConfig
+    {
+        SensorChannel channel;
+        float deadband;
+        float deviation;
+        bool logarithmic;
+    };
+
+    /// @brief Structure for the counters of a trend channel. \struct TrendStats
+    struct TrendStats
+    {
+        uint32_t samples;       // samples offered since begin()
+        uint32_t archived;      // points stored since begin()
+        uint16_t points;        // points currently stored
+        uint16_t depth;         // points the channel can keep
+        uint32_t spanMs;        // time from the oldest stored point to the newest sample
+    };
+
+    /// @brief Class to keep the long term trend of selected channels, only the points needed to reconstruct them. \class SensorTrend
+    /// The acquisition task offers every sample with add(), a calcModule::SwingingDoor per channel picks
+    /// the points. Like SensorHistory the ring buffers live in a caller provided memory block.
+    class SensorTrend
+    {
+    public:
+
+        /**
+         * @brief Get the Instance object
+         *
+         * @return SensorTrend*
+         */
+        static SensorTrend* getInstance();
+
+        /**
+         * @brief Function to split the memory block equally between the channels.
+         *
+         * @param storage -> The memory block of the ring buffers.
+         * @param size -> The size of the block in bytes.
+         * @param configs -> The channels and their error bounds.
+         * @param channelCount -> The number of channels, at most TREND_MAX_CHANNELS.
+         * @return true -> if every channel got at least four points
+         * @return false -> if the block is too small
+         */
+        bool begin(uint8_t* storage, size_t size, const TrendConfig* configs, uint8_t channelCount);
+
+        /**
+         * @brief Function to check if the trend is initialized.
+         *
+         * @return true -> if begin() succeeded
+         * @return false -> if not
+         */
+        bool isInitialized() const;
+
+        /**
+         * @brief Function to offer a sample, acquisition task only. Other channels are ignored.
+         *
+         * @param channel -> The channel.
+         * @param value -> The value.
+         * @param timestampUs -> The monotonic capture time.
+         */
+        void add(SensorChannel channel, float value, uint64_t timestampUs);
+
+        /**
+         * @brief Function to check if a channel is recorded.
+         *
+         * @param channel -> The channel.
+         * @return true -> if begin() got the channel
+         * @return false -> if not
+         */
+        bool isTracked(SensorChannel channel) const;
+
+        /**
+         * @brief Function to get the sequence numbers of the points a channel holds.
+         *
+         * @param channel -> The channel.
+         * @param oldest -> The oldest point still stored.
+         * @param next -> The sequence number of the next point, oldest == next if empty.
+         */
+        void getRange(SensorChannel channel, uint32_t& oldest, uint32_t& next) const;
+
+        /**
+         * @brief Function to copy one stored point of a channel.
+         *
+         * @param channel -> The channel.
+         * @param sequence -> The sequence number, see getRange().
+         * @param point -> The copy, value NAN starts a gap.
+         * @return true -> if the point is stored
+         * @return false -> if the channel is not recorded or the point is overwritten or not written yet
+         */
+        bool getPoint(SensorChannel channel, uint32_t sequence, SensorReading& point) const;
+
+        /**
+         * @brief Function to copy the newest sample not archived yet, it ends the reconstruction.
+         *
+         * @param channel -> The channel.
+         * @param point -> The copy.
+         * @return true -> if there is such a sample
+         * @return false -> if not
+         */
+        bool getTail(SensorChannel channel, SensorReading& point) const;
+
+        /**
+         * @brief Getter for the counters of a channel.
+         *
+         * @param channel -> The channel.
+         * @return TrendStats -> The counters, all 0 if the channel is not recorded.
+         */
+        TrendStats getStats(SensorChannel channel) const;
+
+    private:
+        SensorTrend();
+        ~SensorTrend() = default;
+
+        /// @brief State of one channel. \struct Channel
+        struct Channel
+        {
+            TrendConfig config;
+            calcModule::SwingingDoor door;
+            calcModule::TrendPoint* ring;
+            uint32_t written;
+            uint32_t samples;
+            uint32_t newestMs;          // newest offered sample
+            calcModule::TrendPoint tail; // copy of the held sample of the door for readers
+            bool hasTail;
+        };
+
+        static SensorTrend* _instance;
+
+        bool _initialized = false;
+        uint16_t _depth = 0;
+        uint8_t _channelCount = 0;
+        Channel _channels[TREND_MAX_CHANNELS];
+
+        int8_t indexOf(SensorChannel channel) const;
+        float toValue(const Channel& entry, float stored) const;
+        uint64_t toMicros(uint32_t timeMs) const;
+
+        SensorTrend(const SensorTrend&) = delete;
+        SensorTrend& operator=(const SensorTrend&) = delete;
+    };
+}
+
+#endif // SENSORTREND_H
@@ -0,0 +1,92 @@
+/**
+ * @file logTokens.h
+ * @author Adrian Goessl
+ * @brief Token and source tables for the tokenised and binary logging of SerialMenu.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef LOG_TOKENS_H
+#define LOG_TOKENS_H
+
+#include <Arduino.h>
+
+/*
+ * Every entry is LOG_TOKEN_ENTRY(NAME, "format"), the position in the table is the token ID.
+ * Only ever append, the host tool eSW/utils/logTool parses this file as the token database
+ * and old captures are decoded with the IDs they were written with.
+ *
+ * Format arguments are packed as 4 bytes little endian:
+ *   %d -> int32_t, %u -> uint32_t, %f -> float
+ *
+ * Frame on serial when built with -DLOG_TOKENIZED:
+ *   0xA5 | level | token (2) | millis (4) | argLength | args | checksum
+ * The checksum is the 8 bit sum of all bytes after the 0xA5. The SD card never gets frames,
+ * a tokenised build logs binary records (LOG_BINARY_RECORDS), the token is the payload of a
+ * LOG_RECORD_TOKEN record, see logManager.h.
+ */
+#define LOG_TOKEN_TABLE(LOG_TOKEN_ENTRY) \
+	LOG_TOKEN_ENTRY(HEALTH_CHECK_FAILED,   "System health check failed!") \
+	LOG_TOKEN_ENTRY(HEALTH_CHECK_PASSED,   "System health check passed.") \
+	LOG_TOKEN_ENTRY(THRESHOLDS_UPDATED,    "Thresholds updated - Temp: %f, Pressure: %f") \
+	LOG_TOKEN_ENTRY(LOW_RAM_WARNING,       "Low RAM warning! Available: %u bytes (Warning: %u)") \
+	LOG_TOKEN_ENTRY(VAC_SYSTEM_OFF,        "System is OFF") \
+	LOG_TOKEN_ENTRY(VAC_MANUAL_MODE,       "System is ON - Manual Mode") \
+	LOG_TOKEN_ENTRY(VAC_REMOTE_MODE,       "System is ON - Remote Mode") \
+	LOG_TOKEN_ENTRY(VAC_PUMP_ON,           "Pump ON.") \
+	LOG_TOKEN_ENTRY(VAC_INVALID_SCENARIO,  "Invalid Scenario.") \
+	LOG_TOKEN_ENTRY(VAC_INVALID_SWITCH,    "VAC: Invalid Switch Position") \
+	LOG_TOKEN_ENTRY(HV_SYSTEM_OFF,         "System is OFF.") \
+	LOG_TOKEN_ENTRY(HV_MANUAL_MODE,        "System is ON - Manual Mode.") \
+	LOG_TOKEN_ENTRY(HV_REMOTE_MODE,        "System is ON - Remote Mode.") \
+	LOG_TOKEN_ENTRY(HV_INVALID_SWITCH,     "HV:Invalid Switch Position.") \
+	LOG_TOKEN_ENTRY(SCENARIO_APPLIED,      "Scenario %d") \
+	LOG_TOKEN_ENTRY(STACK_USAGE_HIGH,      "Stack usage high for task %u: %u / %u") \
+	LOG_TOKEN_ENTRY(ETH_NO_RESPONSE,       "No valid response received.") \
+	LOG_TOKEN_ENTRY(PRESSURE_NOT_INIT,     "Pressure sensor not initialized!") \
+	LOG_TOKEN_ENTRY(TEMPERATURE_NOT_INIT,  "Temperature sensor not initialized!") \
+	LOG_TOKEN_ENTRY(JSON_EMPTY,            "JSON document is empty.") \
+	LOG_TOKEN_ENTRY(JSON_SERIALIZE_FAILED, "Failed to serialize JSON.") \
+	LOG_TOKEN_ENTRY(TIME_FALLBACK,         "Time module not initialized, using fallback time") \
+	LOG_TOKEN_ENTRY(LOG_FLUSH_NO_FILE,     "No log file currently open to flush.") \
+	LOG_TOKEN_ENTRY(HV_INVALID_PSU_STATE,  "Invalid PSU state %d")
+
+/*
+ * Source modules of log messages, a .cpp sets its source before the includes:
+ *   #define LOG_SOURCE LogSource::FLYBACK
+ * Only ever append, the ID is stored in the binary SD records.
+ */
+#define LOG_SOURCE_TABLE(LOG_SOURCE_ENTRY) \
+	LOG_SOURCE_ENTRY(UNKNOWN) \
+	LOG_SOURCE_ENTRY(SKETCH) \
+	LOG_SOURCE_ENTRY(SERIALMENU) \
+	LOG_SOURCE_ENTRY(LOGMANAGER) \
+	LOG_SOURCE_ENTRY(TIME) \
+	LOG_SOURCE_ENTRY(COM) \
+	LOG_SOURCE_ENTRY(SENSOR) \
+	LOG_SOURCE_ENTRY(FLYBACK) \
+	LOG_SOURCE_ENTRY(VACCONTROL) \
+	LOG_SOURCE_ENTRY(REPORT) \
+	LOG_SOURCE_ENTRY(JSON)
+
+/// @brief IDs of the source modules, generated from LOG_SOURCE_TABLE. \enum LogSource
+enum class LogSource : uint8_t
+{
+#define LOG_SOURCE_ENUM(name) name,
+	LOG_SOURCE_TABLE(LOG_SOURCE_ENUM)
+#undef LOG_SOURCE_ENUM
+	COUNT
+};
+
+/// @brief IDs of the log tokens, generated from LOG_TOKEN_TABLE. \enum LogToken
+enum class LogToken : uint16_t
+{
+#define LOG_TOKEN_ENUM(name, format) name,
+	LOG_TOKEN_TABLE(LOG_TOKEN_ENUM)
+#undef LOG_TOKEN_ENUM
+	COUNT
+};
+
+#endif // LOG_TOKENS_H
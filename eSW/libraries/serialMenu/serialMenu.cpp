@@ -1,9 +1,84 @@
 #include "serialMenu.h"
 #include <ptrUtils.h>
 #include <logManager.h>
+#include <util/atomic.h>
 
 using namespace timeModule;
 
+SerialMenu::LogRecord SerialMenu::_logQueue[SerialMenu::LOG_QUEUE_SIZE];
+volatile uint8_t SerialMenu::_logState[SerialMenu::LOG_QUEUE_SIZE] = { 0 };
+uint8_t SerialMenu::_logHead = 0;
+uint8_t SerialMenu::_logTail = 0;
+volatile uint16_t SerialMenu::_droppedLogs = 0;
+uint16_t SerialMenu::_reportedDrops = 0;
+volatile bool SerialMenu::_asyncLogging = false;
+volatile bool SerialMenu::_draining = false;
+uint8_t SerialMenu::_logLevel = static_cast<uint8_t>(SerialMenu::OutputLevel::DEBUG);
+
+#ifndef LOG_TOKENIZED
+// Without LOG_TOKENIZED the formats are needed on the device to expand the tokens
+#define LOG_TOKEN_FORMAT(name, format) static const char logTokenFormat_##name[] PROGMEM = format;
+LOG_TOKEN_TABLE(LOG_TOKEN_FORMAT)
+#undef LOG_TOKEN_FORMAT
+
+#define LOG_TOKEN_POINTER(name, format) logTokenFormat_##name,
+static const char* const logTokenFormats[] PROGMEM = { LOG_TOKEN_TABLE(LOG_TOKEN_POINTER) };
+#undef LOG_TOKEN_POINTER
+
+static String expandToken(uint16_t token, const uint8_t* payload, uint8_t length)
+{
+    String text;
+    if (token >= static_cast<uint16_t>(LogToken::COUNT))
+    {
+        text = "Unknown log token ";
+        text += token;
+        return text;
+    }
+
+    const char* format = reinterpret_cast<const char*>(pgm_read_ptr(&logTokenFormats[token]));
+    uint8_t offset = 0;
+
+    for (char c = pgm_read_byte(format); c != '\0'; c = pgm_read_byte(++format))
+    {
+        if (c != '%')
+        {
+            text += c;
+            continue;
+        }
+
+        char spec = pgm_read_byte(++format);
+        if (spec == '\0') break;
+
+        if (offset + 4 > length)
+        {
+            text += '?';
+            continue;
+        }
+
+        uint32_t word = static_cast<uint32_t>(payload[offset])
+                      | (static_cast<uint32_t>(payload[offset + 1]) << 8)
+                      | (static_cast<uint32_t>(payload[offset + 2]) << 16)
+                      | (static_cast<uint32_t>(payload[offset + 3]) << 24);
+        offset += 4;
+
+        switch (spec)
+        {
+            case 'd': text += String(static_cast<long>(static_cast<int32_t>(word))); break;
+            case 'u': text += String(static_cast<unsigned long>(word)); break;
+            case 'f':
+            {
+                float value;
+                memcpy(&value, &word, sizeof(value));
+                text += String(value, 2);
+                break;
+            }
+            default:  text += '%'; text += spec; break;
+        }
+    }
+    return text;
+}
+#endif
+
 SerialMenu::SerialMenu() : currentMenu(nullptr), menuSize(0)
 {
 
@@ -51,47 +126,339 @@ void SerialMenu::run()
 
 void SerialMenu::printToSerial(OutputLevel level, const String& message, bool newLine, bool logMessage)
 {
-    frt::Mutex serialMutex;
-    serialMutex.lock();
+    printToSerial(LogSource::UNKNOWN, level, message, newLine, logMessage);
+}
+
+void SerialMenu::printToSerial(OutputLevel level, const __FlashStringHelper* message, bool newLine, bool logMessage)
+{
+    printToSerial(LogSource::UNKNOWN, level, message, newLine, logMessage);
+}
+
+void SerialMenu::printToSerial(LogSource source, OutputLevel level, const String& message, bool newLine, bool logMessage)
+{
+    if (!isLogLevelEnabled(level)) return;
+
+    uint8_t flags = 0;
+    if (newLine) flags |= LOG_FLAG_NEWLINE;
+    if (logMessage) flags |= LOG_FLAG_SDCARD;
+
+    if (!_asyncLogging)
+    {
+        writeMessage(source, level, flags, millis(), nullptr, message.c_str());
+        return;
+    }
 
-    String output;
+    LogRecord* record = reserveLogSlot();
+    if (record == nullptr) return;
+
+    size_t length = message.length();
+    if (length >= LOG_TEXT_LENGTH)
+    {
+        length = LOG_TEXT_LENGTH - 1;
+        flags |= LOG_FLAG_TRUNCATED;
+    }
+    memcpy(record->message.text, message.c_str(), length);
+    record->message.text[length] = '\0';
+
+    record->level = static_cast<uint8_t>(level);
+    record->source = static_cast<uint8_t>(source);
+    record->flags = flags;
+    record->timestampMs = millis();
+    commitLogSlot(record);
+}
+
+void SerialMenu::printToSerial(LogSource source, OutputLevel level, const __FlashStringHelper* message, bool newLine, bool logMessage)
+{
+    if (!isLogLevelEnabled(level)) return;
+
+    uint8_t flags = LOG_FLAG_FLASH;
+    if (newLine) flags |= LOG_FLAG_NEWLINE;
+    if (logMessage) flags |= LOG_FLAG_SDCARD;
+
+    if (!_asyncLogging)
+    {
+        writeMessage(source, level, flags, millis(), message, nullptr);
+        return;
+    }
+
+    LogRecord* record = reserveLogSlot();
+    if (record == nullptr) return;
+
+    record->message.flash = message;
+    record->level = static_cast<uint8_t>(level);
+    record->source = static_cast<uint8_t>(source);
+    record->flags = flags;
+    record->timestampMs = millis();
+    commitLogSlot(record);
+}
+
+void SerialMenu::printToSerial(const String& message, bool newLine, bool logMessage)
+{
+    printToSerial(OutputLevel::PLAIN, message, newLine, logMessage);
+}
+
+void SerialMenu::printToSerial(const __FlashStringHelper* message, bool newLine, bool logMessage)
+{
+    printToSerial(OutputLevel::PLAIN, message, newLine, logMessage);
+}
+
+void SerialMenu::setLogLevel(OutputLevel level)
+{
+    _logLevel = static_cast<uint8_t>(level);
+}
+
+SerialMenu::OutputLevel SerialMenu::getLogLevel()
+{
+    return static_cast<OutputLevel>(_logLevel);
+}
+
+void SerialMenu::startAsyncLogging()
+{
+    _asyncLogging = true;
+}
+
+size_t SerialMenu::processLogQueue()
+{
+    bool claimed = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (!_draining)
+        {
+            _draining = true;
+            claimed = true;
+        }
+    }
+    if (!claimed) return 0;
+
+    size_t written = 0;
+    while (_logState[_logTail] == SLOT_READY)
+    {
+        const LogRecord& record = _logQueue[_logTail];
+        const LogSource source = static_cast<LogSource>(record.source);
+        if (record.flags & LOG_FLAG_TOKEN)
+        {
+            const uint8_t* raw = reinterpret_cast<const uint8_t*>(record.message.text);
+            emitToken(source, static_cast<OutputLevel>(record.level), record.timestampMs,
+                      static_cast<uint16_t>(raw[0] | (raw[1] << 8)), &raw[3], raw[2]);
+        }
+        else if (record.flags & LOG_FLAG_FLASH)
+        {
+            writeMessage(source, static_cast<OutputLevel>(record.level), record.flags, record.timestampMs, record.message.flash, nullptr);
+        }
+        else
+        {
+            writeMessage(source, static_cast<OutputLevel>(record.level), record.flags, record.timestampMs, nullptr, record.message.text);
+        }
+
+        _logState[_logTail] = SLOT_FREE;
+        _logTail = (_logTail + 1) % LOG_QUEUE_SIZE;
+        written++;
+    }
+
+    uint16_t dropped = getDroppedLogCount();
+    if (dropped != _reportedDrops)
+    {
+        String note(static_cast<uint16_t>(dropped - _reportedDrops));
+        note += F(" log messages dropped, queue full");
+        _reportedDrops = dropped;
+        writeMessage(LogSource::SERIALMENU, OutputLevel::WARNING, LOG_FLAG_NEWLINE, millis(), nullptr, note.c_str());
+    }
+
+    // buffered SD data is written at least every LOG_FLUSH_INTERVAL_MS
+    LogManager* logger = LogManager::getInstance();
+    if (logger && logger->isSDCardInitialized())
+    {
+        logger->flushIfDue();
+    }
+
+    _draining = false;
+    return written;
+}
+
+uint16_t SerialMenu::getDroppedLogCount()
+{
+    uint16_t dropped;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        dropped = _droppedLogs;
+    }
+    return dropped;
+}
+
+void SerialMenu::writeToken(LogSource source, OutputLevel level, LogToken token, const uint8_t* payload, uint8_t length)
+{
+    const uint16_t id = static_cast<uint16_t>(token);
+
+    if (!_asyncLogging)
+    {
+        emitToken(source, level, millis(), id, payload, length);
+        return;
+    }
+
+    LogRecord* record = reserveLogSlot();
+    if (record == nullptr) return;
+
+    // token ID, argument length and arguments share the text buffer of the slot
+    uint8_t* raw = reinterpret_cast<uint8_t*>(record->message.text);
+    raw[0] = static_cast<uint8_t>(id);
+    raw[1] = static_cast<uint8_t>(id >> 8);
+    raw[2] = length;
+    memcpy(&raw[3], payload, length);
+
+    record->level = static_cast<uint8_t>(level);
+    record->source = static_cast<uint8_t>(source);
+    record->flags = LOG_FLAG_TOKEN | LOG_FLAG_NEWLINE | LOG_FLAG_SDCARD;
+    record->timestampMs = millis();
+    commitLogSlot(record);
+}
+
+void SerialMenu::emitToken(LogSource source, OutputLevel level, unsigned long timestampMs, uint16_t token, const uint8_t* payload, uint8_t length)
+{
+    LogManager* logger = LogManager::getInstance();
+    const bool toFile = (level == OutputLevel::WARNING ||
+                         level == OutputLevel::ERROR ||
+                         level == OutputLevel::CRITICAL) &&
+                        logger && logger->isSDCardInitialized();
+
+#ifdef LOG_TOKENIZED
+    uint8_t frame[10 + LOG_TOKEN_MAX_ARGS * 4];
+    uint8_t size = 0;
+
+    frame[size++] = LOG_TOKEN_SYNC;
+    frame[size++] = static_cast<uint8_t>(level);
+    frame[size++] = static_cast<uint8_t>(token);
+    frame[size++] = static_cast<uint8_t>(token >> 8);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        frame[size++] = static_cast<uint8_t>(timestampMs >> (8 * i));
+    }
+    frame[size++] = length;
+    memcpy(&frame[size], payload, length);
+    size += length;
+
+    uint8_t checksum = 0;
+    for (uint8_t i = 1; i < size; i++)
+    {
+        checksum += frame[i];
+    }
+    frame[size++] = checksum;
+
+    if (Serial)
+    {
+        Serial.write(frame, size);
+    }
+
+    // the frames are for the serial port only, a text log stays text for its index and get_logs
+    if (toFile && !logger->isBinaryRecords())
+    {
+        String line;
+        line.reserve(32 + 3 * length);
+        line += '[';
+        line += formatLogTime(timestampMs);
+        line += F("] [LEVEL ");
+        line += static_cast<uint8_t>(level);
+        line += F("] [TOKEN ");
+        line += token;
+        line += ']';
+        for (uint8_t i = 0; i < length; i++)
+        {
+            line += (payload[i] < 0x10) ? F(" 0") : F(" ");
+            line += String(payload[i], HEX);
+        }
+        logger->writeToLogFile(line, level == OutputLevel::CRITICAL);
+    }
+#else
+    String text = expandToken(token, payload, length);
+    uint8_t flags = LOG_FLAG_NEWLINE;
+    if (!toFile || !logger->isBinaryRecords())
+    {
+        flags |= LOG_FLAG_SDCARD;
+    }
+    writeMessage(source, level, flags, timestampMs, nullptr, text.c_str());
+#endif
+
+    // binary records keep the token, in both builds
+    if (toFile && logger->isBinaryRecords())
+    {
+        uint8_t record[2 + LOG_TOKEN_MAX_ARGS * 4];
+        record[0] = static_cast<uint8_t>(token);
+        record[1] = static_cast<uint8_t>(token >> 8);
+        memcpy(&record[2], payload, length);
+        logger->writeRecord(logEpochMillis(timestampMs), static_cast<uint8_t>(level), static_cast<uint8_t>(source),
+                            LOG_RECORD_TOKEN, record, 2 + length, level == OutputLevel::CRITICAL);
+    }
+}
+
+SerialMenu::LogRecord* SerialMenu::reserveLogSlot()
+{
+    LogRecord* record = nullptr;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (_logState[_logHead] == SLOT_FREE)
+        {
+            _logState[_logHead] = SLOT_WRITING;
+            record = &_logQueue[_logHead];
+            _logHead = (_logHead + 1) % LOG_QUEUE_SIZE;
+        }
+        else
+        {
+            _droppedLogs++;
+        }
+    }
+    return record;
+}
+
+void SerialMenu::commitLogSlot(LogRecord* record)
+{
+    _logState[record - _logQueue] = SLOT_READY;
+}
+
+void SerialMenu::writeMessage(LogSource source, OutputLevel level, uint8_t flags, unsigned long timestampMs,
+                              const __FlashStringHelper* flash, const char* text)
+{
+    String prefix;
     if (level != OutputLevel::PLAIN)
     {
-        output.reserve(message.length() + 32);
-        output += '[';
-        output += getCurrentTime();
-        output += "] ";
+        prefix.reserve(36);
+        prefix += '[';
+        prefix += formatLogTime(timestampMs);
+        prefix += "] ";
 
         switch(level)
         {
-            case OutputLevel::DEBUG:    output += "[DEBUG] "; break;
-            case OutputLevel::INFO:     output += "[INFO] "; break;
-            case OutputLevel::WARNING:  output += "[WARNING] "; break;
-            case OutputLevel::ERROR:    output += "[ERROR] "; break;
-            case OutputLevel::CRITICAL: output += "[CRITICAL] "; break;
-            case OutputLevel::STATUS:   output += "[STATUS] "; break;
+            case OutputLevel::DEBUG:    prefix += "[DEBUG] "; break;
+            case OutputLevel::INFO:     prefix += "[INFO] "; break;
+            case OutputLevel::WARNING:  prefix += "[WARNING] "; break;
+            case OutputLevel::ERROR:    prefix += "[ERROR] "; break;
+            case OutputLevel::CRITICAL: prefix += "[CRITICAL] "; break;
+            case OutputLevel::STATUS:   prefix += "[STATUS] "; break;
             case OutputLevel::PLAIN:    break; // No prefix
         }
-        output += message;
-    }
-    else
-    {
-        output = message;
     }
 
     if (Serial) // TODO CHeck if this is working as expected if serial == false, the no buffer fill
     {
-        if (newLine)
+        Serial.print(prefix);
+        if (flash != nullptr)
         {
-            Serial.println(output);
+            Serial.print(flash);
         }
         else
         {
-            Serial.print(output);
+            Serial.print(text);
+        }
+        if (flags & LOG_FLAG_TRUNCATED)
+        {
+            Serial.print("...");
+        }
+        if (flags & LOG_FLAG_NEWLINE)
+        {
+            Serial.println();
         }
     }
 
-    if (logMessage)
+    if (flags & LOG_FLAG_SDCARD)
     {
         // TODO TEST THIS THIS IS NOT TESTED YET, EXTERNAL LOGGER TO SD CARD!
         LogManager* logger = LogManager::getInstance();
@@ -102,29 +469,57 @@ void SerialMenu::printToSerial(OutputLevel level, const String& message, bool ne
         		level == OutputLevel::ERROR ||
     			level == OutputLevel::CRITICAL)
         	{
-        		String toLog = output;
-        		if (newLine) toLog += "\n";
-        		logger->writeToLogFile(toLog);
+        		// binary records carry time, level and source in the header
+        		String toLog = logger->isBinaryRecords() ? String() : prefix;
+        		if (flash != nullptr)
+        		{
+        			toLog += flash;
+        		}
+        		else
+        		{
+        			toLog += text;
+        		}
+
+        		if (logger->isBinaryRecords())
+        		{
+        			logger->writeRecord(logEpochMillis(timestampMs), static_cast<uint8_t>(level), static_cast<uint8_t>(source),
+        			                    LOG_RECORD_TEXT, reinterpret_cast<const uint8_t*>(toLog.c_str()), toLog.length(),
+        			                    level == OutputLevel::CRITICAL);
+        		}
+        		else
+        		{
+        			logger->writeToLogFile(toLog, level == OutputLevel::CRITICAL);
+        		}
         	}
         }
     }
-
-    serialMutex.unlock();
 }
 
-void SerialMenu::printToSerial(OutputLevel level, const __FlashStringHelper* message, bool newLine, bool logMessage)
+uint64_t SerialMenu::logEpochMillis(unsigned long timestampMs)
 {
-    printToSerial(level, String(message), newLine, logMessage);
-}
+    TimeModuleInternals* timeInstance = TimeModuleInternals::getInstance();
+    if (timeInstance == nullptr)
+    {
+        return 0;
+    }
 
-void SerialMenu::printToSerial(const String& message, bool newLine, bool logMessage)
-{
-    printToSerial(OutputLevel::PLAIN, message, newLine, logMessage);
+    // messages are written later by the logger task, so step back to the time they were logged
+    return timeInstance->getEpochMillis() - (millis() - timestampMs);
 }
 
-void SerialMenu::printToSerial(const __FlashStringHelper* message, bool newLine, bool logMessage)
+String SerialMenu::formatLogTime(unsigned long timestampMs)
 {
-    printToSerial(OutputLevel::PLAIN, String(message), newLine, logMessage);
+    TimeModuleInternals* timeInstance = TimeModuleInternals::getInstance();
+    if (timeInstance == nullptr)
+    {
+        return "0000-00-00T00:00:00Z";
+    }
+
+    uint64_t epochMs = logEpochMillis(timestampMs);
+
+    DateTimeStruct dt;
+    TimeModuleInternals::epochToDateTime(static_cast<uint32_t>(epochMs / 1000ULL), dt);
+    return TimeModuleInternals::formatTimeString(dt);
 }
 
 String SerialMenu::getCurrentTime()
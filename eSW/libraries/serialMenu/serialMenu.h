@@ -14,6 +14,75 @@
 #include <Arduino.h>
 #include <frt.h>
 #include <timeModule.h>
+#include <logTokens.h>
+
+/// A tokenised build writes binary records to the SD card, the token frames only go to the serial port
+#if defined(LOG_TOKENIZED) && !defined(LOG_BINARY_RECORDS)
+#define LOG_BINARY_RECORDS
+#endif
+
+/// Numeric log levels for the preprocessor, same order as SerialMenu::OutputLevel
+#define LOG_LEVEL_DEBUG    0
+#define LOG_LEVEL_INFO     1
+#define LOG_LEVEL_WARNING  2
+#define LOG_LEVEL_ERROR    3
+#define LOG_LEVEL_CRITICAL 4
+#define LOG_LEVEL_NONE     5
+
+/// Compile-time minimum log level, messages below it are removed including their arguments.
+/// DEBUG keeps every message, setLogLevel() filters them at runtime before the arguments are built,
+/// a higher level only saves the flash of the removed calls. eSW/utils/compare_log_levels.sh builds the
+/// Mega per level, the CI puts its table into the job summary.
+/// Override with --build-property "compiler.cpp.extra_flags=-DLOG_MIN_LEVEL=1"
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/// Source module of the LOG_* macros, a .cpp defines it before its includes, see logTokens.h
+#ifndef LOG_SOURCE
+#define LOG_SOURCE LogSource::UNKNOWN
+#endif
+
+/// True if messages of the level are compiled in and pass the runtime threshold, guards expensive message building.
+#define LOG_IS_ENABLED(level) \
+	(LOG_MIN_LEVEL <= LOG_LEVEL_##level && SerialMenu::isLogLevelEnabled(SerialMenu::OutputLevel::level))
+
+#define LOG_AT(level, ...) \
+	do { if (SerialMenu::isLogLevelEnabled(SerialMenu::OutputLevel::level)) SerialMenu::printToSerial(LOG_SOURCE, SerialMenu::OutputLevel::level, __VA_ARGS__); } while (0)
+
+/// Logs a token of logTokens.h, e.g. LOG_TOKEN(WARNING, LOW_RAM_WARNING, ramSize, threshold)
+#define LOG_TOKEN(level, token, ...) \
+	do { if (LOG_IS_ENABLED(level)) SerialMenu::printToken(LOG_SOURCE, SerialMenu::OutputLevel::level, LogToken::token, ##__VA_ARGS__); } while (0)
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do { } while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do { } while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) LOG_AT(WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) do { } while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do { } while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_CRITICAL
+#define LOG_CRITICAL(...) LOG_AT(CRITICAL, __VA_ARGS__)
+#else
+#define LOG_CRITICAL(...) do { } while (0)
+#endif
 
 
 /// @brief Serial menu structure \struct MenuItem
@@ -65,16 +134,18 @@ public:
     void run();
 
     /**
-     * @brief Function to print a message to the serial port, using mutexes, output level and new line options.
+     * @brief Function to print a message to the serial port, output level and new line options.
+     * Once async logging is started the message is copied into the log queue and printed by the logger task.
      *
      * @param level -> The output level of the message.
-     * @param message -> The message to print, a String object.
+     * @param message -> The message to print, a String object, truncated to LOG_TEXT_LENGTH in the queue.
      * @param newLine -> Whether to add a new line at the end of the message.
      */
     static void printToSerial(OutputLevel level, const String& message, bool newLine = true, bool logMessage = false);
 
     /**
-     * @brief Function to print a message to the serial port, using mutexes, output level and new line options.
+     * @brief Function to print a message to the serial port, output level and new line options.
+     * Once async logging is started only the pointer is queued, the text stays in flash.
      *
      * @param level -> The output level of the message.
      * @param message -> The message to print, a __FlashStringHelper pointer.
@@ -83,7 +154,7 @@ public:
     static void printToSerial(OutputLevel level, const __FlashStringHelper* message, bool newLine = true, bool logMessage = false);
 
     /**
-     * @brief Funtion to print a message to the serial port, using mutexes, output level and new line options.
+     * @brief Funtion to print a message to the serial port without output level, new line options.
      *
      * @param message -> The message to print, a String object.
      * @param newLine -> Whether to add a new line at the end of the message.
@@ -91,22 +162,250 @@ public:
     static void printToSerial(const String& message, bool newLine = true, bool logMessage = false);
 
     /**
-     * @brief Function to print a message to the serial port, using mutexes, output level and new line options.
+     * @brief Function to print a message to the serial port without output level, new line options.
      *
      * @param message -> The message to print, a __FlashStringHelper pointer.
      * @param newLine -> Whether to add a new line at the end of the message.
      */
     static void printToSerial(const __FlashStringHelper* message, bool newLine = true, bool logMessage = false);
 
+    /**
+     * @brief Function to print a message of a source module, used by the LOG_* macros.
+     *
+     * @param source -> The module the message comes from, stored in the binary SD records.
+     * @param level -> The output level of the message.
+     * @param message -> The message to print, a String object.
+     * @param newLine -> Whether to add a new line at the end of the message.
+     */
+    static void printToSerial(LogSource source, OutputLevel level, const String& message, bool newLine = true, bool logMessage = false);
+
+    /**
+     * @brief Function to print a message of a source module, used by the LOG_* macros.
+     *
+     * @param source -> The module the message comes from, stored in the binary SD records.
+     * @param level -> The output level of the message.
+     * @param message -> The message to print, a __FlashStringHelper pointer.
+     * @param newLine -> Whether to add a new line at the end of the message.
+     */
+    static void printToSerial(LogSource source, OutputLevel level, const __FlashStringHelper* message, bool newLine = true, bool logMessage = false);
+
+    /**
+     * @brief Function to log a message from the token table in logTokens.h.
+     * Built with -DLOG_TOKENIZED only the token ID and the packed arguments are sent as a binary frame,
+     * otherwise the format is expanded on the device and printed like printToSerial().
+     * Tokens of level WARNING and above also go to the SD card, as LOG_RECORD_TOKEN records when the log
+     * holds binary records. Use it through LOG_TOKEN().
+     *
+     * @param source -> The module the message comes from.
+     * @param level -> The output level of the message.
+     * @param token -> The token of the message format.
+     * @param args -> The arguments of the format, int, long, float or their unsigned variants.
+     */
+    template<typename... Args>
+    static void printToken(LogSource source, OutputLevel level, LogToken token, Args... args)
+    {
+        static_assert(sizeof...(Args) <= LOG_TOKEN_MAX_ARGS, "Too many arguments for a log token");
+
+        if (!isLogLevelEnabled(level)) return;
+
+        uint8_t payload[LOG_TOKEN_MAX_ARGS * 4];
+        uint8_t length = 0;
+        packTokenArgs(payload, length, args...);
+        writeToken(source, level, token, payload, length);
+    }
+
     /**
      * @brief Getter for the current time
      * @return The current time as a String
      */
     static String getCurrentTime();
 
+    /**
+     * @brief Function to set the runtime log threshold, messages below it are discarded before they are queued.
+     * STATUS and PLAIN messages are always printed.
+     *
+     * @param level -> The lowest level to print.
+     */
+    static void setLogLevel(OutputLevel level);
+
+    /**
+     * @brief Getter for the runtime log threshold.
+     *
+     * @return OutputLevel -> The lowest level that is printed.
+     */
+    static OutputLevel getLogLevel();
+
+    /**
+     * @brief Function to check a level against the runtime log threshold.
+     *
+     * @param level -> The level to check.
+     * @return true -> if messages of this level are printed
+     * @return false -> if messages of this level are discarded
+     */
+    static inline bool isLogLevelEnabled(OutputLevel level)
+    {
+        return static_cast<uint8_t>(level) >= _logLevel;
+    }
+
+    /**
+     * @brief Function to switch from printing on the caller to the log queue, drained by processLogQueue().
+     * Until this is called, e.g. during setup(), every message is printed synchronously.
+     */
+    static void startAsyncLogging();
+
+    /**
+     * @brief Function to drain the log queue to the serial port and the SD card, called by the logger task.
+     * Only one caller drains at a time, a concurrent call returns immediately.
+     *
+     * @return size_t -> The number of messages written.
+     */
+    static size_t processLogQueue();
+
+    /**
+     * @brief Getter for the number of messages dropped because the log queue was full.
+     *
+     * @return uint16_t -> The number of dropped messages since boot.
+     */
+    static uint16_t getDroppedLogCount();
+
 private:
     MenuItem* currentMenu;
     size_t menuSize;
+
+    static const uint8_t LOG_QUEUE_SIZE = 8;
+    static const uint8_t LOG_TEXT_LENGTH = 48;
+
+    static const uint8_t LOG_FLAG_NEWLINE = 0x01;
+    static const uint8_t LOG_FLAG_SDCARD = 0x02;
+    static const uint8_t LOG_FLAG_FLASH = 0x04;
+    static const uint8_t LOG_FLAG_TRUNCATED = 0x08;
+    static const uint8_t LOG_FLAG_TOKEN = 0x10;
+
+    static const uint8_t LOG_TOKEN_MAX_ARGS = 4;
+    static const uint8_t LOG_TOKEN_SYNC = 0xA5;
+
+    static const uint8_t SLOT_FREE = 0;
+    static const uint8_t SLOT_WRITING = 1;
+    static const uint8_t SLOT_READY = 2;
+
+    /// @brief Slot of the log queue, the message is either copied or points into flash \struct LogRecord
+    struct LogRecord
+    {
+        uint8_t level;
+        uint8_t source;
+        uint8_t flags;
+        unsigned long timestampMs;
+        union
+        {
+            const __FlashStringHelper* flash;
+            char text[LOG_TEXT_LENGTH];
+        } message;
+    };
+
+    static LogRecord _logQueue[LOG_QUEUE_SIZE];
+    static volatile uint8_t _logState[LOG_QUEUE_SIZE];
+    static uint8_t _logHead;
+    static uint8_t _logTail;
+    static volatile uint16_t _droppedLogs;
+    static uint16_t _reportedDrops;
+    static volatile bool _asyncLogging;
+    static volatile bool _draining;
+    static uint8_t _logLevel;
+
+    /**
+     * @brief Function to reserve the next free slot of the log queue, counts a dropped message if it is full.
+     *
+     * @return LogRecord* -> The reserved slot, nullptr if the queue is full.
+     */
+    static LogRecord* reserveLogSlot();
+
+    /**
+     * @brief Function to hand a filled slot over to the logger task.
+     *
+     * @param record -> The slot returned by reserveLogSlot().
+     */
+    static void commitLogSlot(LogRecord* record);
+
+    /**
+     * @brief Function to format and write one message to the serial port and, if requested, the SD card.
+     *
+     * @param source -> The module the message comes from.
+     * @param level -> The output level of the message.
+     * @param flags -> The LOG_FLAG_* bits of the message.
+     * @param timestampMs -> The millis() when the message was logged.
+     * @param flash -> The message if it is in flash, otherwise nullptr.
+     * @param text -> The message if it is in RAM, otherwise nullptr.
+     */
+    static void writeMessage(LogSource source, OutputLevel level, uint8_t flags, unsigned long timestampMs,
+                             const __FlashStringHelper* flash, const char* text);
+
+    /**
+     * @brief Function to queue or print a token with its packed arguments.
+     *
+     * @param source -> The module the message comes from.
+     * @param level -> The output level of the message.
+     * @param token -> The token of the message format.
+     * @param payload -> The packed arguments.
+     * @param length -> The length of the packed arguments.
+     */
+    static void writeToken(LogSource source, OutputLevel level, LogToken token, const uint8_t* payload, uint8_t length);
+
+    /**
+     * @brief Function to write a token to the serial port and the SD card, as frame or expanded text.
+     *
+     * @param source -> The module the message comes from.
+     * @param level -> The output level of the message.
+     * @param timestampMs -> The millis() when the message was logged.
+     * @param token -> The token of the message format.
+     * @param payload -> The packed arguments.
+     * @param length -> The length of the packed arguments.
+     */
+    static void emitToken(LogSource source, OutputLevel level, unsigned long timestampMs, uint16_t token, const uint8_t* payload, uint8_t length);
+
+    static void packTokenArgs(uint8_t*, uint8_t&) {}
+
+    template<typename T, typename... Rest>
+    static void packTokenArgs(uint8_t* payload, uint8_t& length, T first, Rest... rest)
+    {
+        packTokenArg(payload, length, first);
+        packTokenArgs(payload, length, rest...);
+    }
+
+    static void packTokenArg(uint8_t* payload, uint8_t& length, int value) { packTokenWord(payload, length, static_cast<uint32_t>(static_cast<int32_t>(value))); }
+    static void packTokenArg(uint8_t* payload, uint8_t& length, unsigned int value) { packTokenWord(payload, length, static_cast<uint32_t>(value)); }
+    static void packTokenArg(uint8_t* payload, uint8_t& length, long value) { packTokenWord(payload, length, static_cast<uint32_t>(static_cast<int32_t>(value))); }
+    static void packTokenArg(uint8_t* payload, uint8_t& length, unsigned long value) { packTokenWord(payload, length, static_cast<uint32_t>(value)); }
+    static void packTokenArg(uint8_t* payload, uint8_t& length, double value) { packTokenArg(payload, length, static_cast<float>(value)); }
+    static void packTokenArg(uint8_t* payload, uint8_t& length, float value)
+    {
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        packTokenWord(payload, length, word);
+    }
+
+    static void packTokenWord(uint8_t* payload, uint8_t& length, uint32_t word)
+    {
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            payload[length++] = static_cast<uint8_t>(word >> (8 * i));
+        }
+    }
+
+    /**
+     * @brief Function to map the millis() a message was logged to the wall time.
+     *
+     * @param timestampMs -> The millis() when the message was logged.
+     * @return uint64_t -> Milliseconds since 1970-01-01T00:00:00Z.
+     */
+    static uint64_t logEpochMillis(unsigned long timestampMs);
+
+    /**
+     * @brief Function to format the wall time a message was logged.
+     *
+     * @param timestampMs -> The millis() when the message was logged.
+     * @return String -> The formatted time.
+     */
+    static String formatLogTime(unsigned long timestampMs);
 };
 
 #endif // SERIAL_MENU_H
@@ -6,10 +6,13 @@
  *
  * @copyright Copyright (c) 2024
  */
+#define LOG_SOURCE LogSource::SENSOR
+
 #include <temperature.h>
 #include <serialMenu.h>
 #include <ptrUtils.h>
 #include <calcModule.h>
+#include <adcEngine.h>
 #include <math.h>
 
 TemperatureSensor::TemperatureSensor()
@@ -55,7 +58,7 @@ float TemperatureSensor::readTemperature()
 {
     if (!_temperatureSensorInitialized)
     {
-    	SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Temperature sensor not initialized!"));
+    	LOG_TOKEN(ERROR, TEMPERATURE_NOT_INIT);
         return NAN;
     }
     return readDigitalSensor(TEMP_SENSOR_PIN_DIG);
@@ -121,7 +124,7 @@ bool TemperatureSensor::isInitialized() const
 
 float TemperatureSensor::readAnalogSensor(uint8_t pin)
 {
-	uint8_t rawValue = analogRead(pin);
+	int rawValue = sensorModule::AdcEngine::getInstance()->read(pin);
     return static_cast<float>(rawValue);
 }
 
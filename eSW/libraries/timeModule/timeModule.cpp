@@ -1,18 +1,31 @@
 /**
  * @file timeModule.cpp
  * @brief Implementation of the timeModule class.
- * @version 0.1
+ * @version 0.2
  * @date 2024-01-26
  *
  * @copyright Copyright (c) 2024
  */
 #include <timeModule.h>
+#include <EEPROM.h>
+#include <util/atomic.h>
 
 using namespace timeModule;
 
-TimeModuleInternals::TimeModuleInternals()
+static volatile uint32_t microsHigh = 0;
+static volatile uint32_t lastMicros = 0;
+
+/// @brief Layout of the drift record in the EEPROM \struct DriftRecord
+struct DriftRecord
 {
+	uint16_t magic;
+	float driftPpm;
+};
 
+TimeModuleInternals::TimeModuleInternals()
+{
+	epochToDateTime(0, dt);
+	loadDrift();
 }
 
 TimeModuleInternals::~TimeModuleInternals()
@@ -74,32 +87,390 @@ String TimeModuleInternals::formatTimeString(const DateTimeStruct& dt)
 
 void TimeModuleInternals::setSystemTime(const DateTimeStruct& newDt)
 {
+	unsigned long now = millis();
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_refEpochMs = static_cast<uint64_t>(dateTimeToEpoch(newDt)) * 1000ULL;
+		_refMillis = now;
+		_slewMs = 0;
+		_lastEpochMs = 0;
+	}
 	dt = newDt;
-	startMillis = millis();
 }
 
 DateTimeStruct TimeModuleInternals::getSystemTime()
 {
-	updateSoftwareClock();
-	return dt;
+	DateTimeStruct now;
+	epochToDateTime(static_cast<uint32_t>(getEpochMillis() / 1000ULL), now);
+	return now;
 }
 
 void TimeModuleInternals::updateSoftwareClock()
 {
-    unsigned long currentMillis = millis();
-    unsigned long elapsedMillis = currentMillis - startMillis;
+	epochToDateTime(static_cast<uint32_t>(getEpochMillis() / 1000ULL), dt);
+}
 
-    unsigned long elapsedSeconds = elapsedMillis / 1000;
-    startMillis += elapsedSeconds * 1000; // Retain leftover milliseconds for next update
+uint64_t TimeModuleInternals::getEpochMillis()
+{
+	unsigned long now = millis();
 
-    while (elapsedSeconds > 0)
-    {
-        incrementTime(&dt);
-        elapsedSeconds--;
-    }
+	if (now - _refMillis > REBASE_INTERVAL)
+	{
+		rebase(now, 0, false);
+	}
+
+	uint64_t epochMs = modelEpochMillis(now);
+
+	// Readers on different tasks may race, never hand out an older time than before
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (epochMs < _lastEpochMs)
+		{
+			epochMs = _lastEpochMs;
+		}
+		else
+		{
+			_lastEpochMs = epochMs;
+		}
+	}
+	return epochMs;
 }
 
-bool TimeModuleInternals::setTimeFromHas(const String& timeString)
+uint64_t TimeModuleInternals::getMonotonicMicros()
+{
+	uint64_t result;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uint32_t now = micros();
+		if (now < lastMicros)
+		{
+			microsHigh++;
+		}
+		lastMicros = now;
+		result = (static_cast<uint64_t>(microsHigh) << 32) | now;
+	}
+	return result;
+}
+
+uint64_t TimeModuleInternals::monotonicToEpochMillis(uint64_t monotonicMicros)
+{
+	uint64_t nowMicros = getMonotonicMicros();
+	uint64_t nowEpochMs = getEpochMillis();
+
+	uint64_t ageMs = (nowMicros > monotonicMicros) ? (nowMicros - monotonicMicros) / 1000ULL : 0;
+	return nowEpochMs - ageMs;
+}
+
+String TimeModuleInternals::formatTimeStringMs(uint64_t epochMillis)
+{
+	DateTimeStruct dt;
+	epochToDateTime(static_cast<uint32_t>(epochMillis / 1000ULL), dt);
+
+	String timeStr = formatTimeString(dt);
+	timeStr.remove(timeStr.length() - 1); // drop the 'Z'
+
+	int ms = static_cast<int>(epochMillis % 1000ULL);
+	timeStr += '.';
+	if (ms < 100) timeStr += '0';
+	if (ms < 10) timeStr += '0';
+	timeStr += String(ms);
+	timeStr += 'Z';
+
+	return timeStr;
+}
+
+String TimeModuleInternals::uint64ToString(uint64_t value)
+{
+	char buffer[21];
+	char* ptr = &buffer[sizeof(buffer) - 1];
+	*ptr = '\0';
+
+	do
+	{
+		*--ptr = static_cast<char>('0' + (value % 10ULL));
+		value /= 10ULL;
+	} while (value > 0);
+
+	return String(ptr);
+}
+
+uint64_t TimeModuleInternals::stringToUint64(const String& text)
+{
+	uint64_t value = 0;
+	for (unsigned int i = 0; i < text.length() && isDigit(text[i]); i++)
+	{
+		value = value * 10ULL + static_cast<uint64_t>(text[i] - '0');
+	}
+	return value;
+}
+
+int32_t TimeModuleInternals::appliedSlew(unsigned long elapsedMs, int32_t slewMs)
+{
+	int32_t limit = static_cast<int32_t>((static_cast<uint64_t>(elapsedMs) * SLEW_RATE_PPM) / 1000000ULL);
+
+	if (slewMs > limit) return limit;
+	if (slewMs < -limit) return -limit;
+	return slewMs;
+}
+
+uint64_t TimeModuleInternals::modelEpochMillis(unsigned long now) const
+{
+	uint64_t refEpochMs;
+	unsigned long refMillis;
+	int32_t slewMs;
+	float driftPpm;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		refEpochMs = _refEpochMs;
+		refMillis = _refMillis;
+		slewMs = _slewMs;
+		driftPpm = _driftPpm;
+	}
+
+	unsigned long elapsed = now - refMillis;
+	int32_t driftMs = static_cast<int32_t>(elapsed * (driftPpm * 1e-6f));
+
+	return refEpochMs + elapsed + driftMs + appliedSlew(elapsed, slewMs);
+}
+
+void TimeModuleInternals::rebase(unsigned long now, int64_t offsetMs, bool step)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		unsigned long elapsed = now - _refMillis;
+		int32_t driftMs = static_cast<int32_t>(elapsed * (_driftPpm * 1e-6f));
+		int32_t applied = appliedSlew(elapsed, _slewMs);
+		uint64_t current = _refEpochMs + elapsed + driftMs + applied;
+
+		_refMillis = now;
+		if (step)
+		{
+			_refEpochMs = current + offsetMs;
+			_slewMs = 0;
+			_lastEpochMs = 0;
+		}
+		else
+		{
+			// The offset was measured against the model with the applied slew only,
+			// the part not applied yet is already in it
+			_refEpochMs = current;
+			_slewMs = static_cast<int32_t>(offsetMs);
+		}
+	}
+}
+
+bool TimeModuleInternals::syncWithHas(const String& response, unsigned long requestMillis, unsigned long responseMillis)
+{
+	// t2 -> HAS received the request, t3 -> HAS sent the response
+	uint64_t t2 = 0;
+	uint64_t t3 = 0;
+	bool precise = true;
+
+	if (!parseJsonUint64(response, "\"receive_ms\"", t2) || !parseJsonUint64(response, "\"transmit_ms\"", t3))
+	{
+		// Plain HAS without NTP fields, second resolution only -> assume the middle of the second
+		DateTimeStruct hasDt;
+		if (!parseHasTime(response, hasDt)) return false;
+
+		t2 = static_cast<uint64_t>(dateTimeToEpoch(hasDt)) * 1000ULL + 500ULL;
+		t3 = t2;
+		precise = false;
+	}
+
+	if (t3 < t2) return false;
+
+	uint32_t roundTrip = responseMillis - requestMillis;
+	uint32_t hasProcessing = static_cast<uint32_t>(t3 - t2);
+	uint32_t delayMs = (roundTrip > hasProcessing) ? roundTrip - hasProcessing : 0;
+
+	if (delayMs > MAX_DELAY_MS) return false;
+
+	int64_t t1 = static_cast<int64_t>(modelEpochMillis(requestMillis));
+	int64_t t4 = static_cast<int64_t>(modelEpochMillis(responseMillis));
+	int64_t offset = ((static_cast<int64_t>(t2) - t1) + (static_cast<int64_t>(t3) - t4)) / 2;
+
+	unsigned long now = millis();
+	bool step = !_synced || offset > STEP_THRESHOLD_MS || offset < -STEP_THRESHOLD_MS;
+
+	if (step)
+	{
+		rebase(now, offset, true);
+		_syncInterval = MIN_SYNC_INTERVAL;
+	}
+	else
+	{
+		// the slew not applied yet is a known offset, not drift
+		int32_t pendingSlew;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			pendingSlew = _slewMs - appliedSlew(responseMillis - _refMillis, _slewMs);
+		}
+
+		// rebase with the old drift, the interval since the last sync produced the offset and is
+		// corrected by the slew, the new drift only applies from the new reference on
+		rebase(now, offset, false);
+
+		// +-500 ms of a plain HAS would read as thousands of ppm, only the NTP fields teach the drift
+		if (precise)
+		{
+			updateDrift(static_cast<int32_t>(offset) - pendingSlew, responseMillis - _lastSyncMillis);
+		}
+
+		int32_t absOffset = offset < 0 ? -offset : offset;
+		if (absOffset <= GOOD_OFFSET_MS)
+		{
+			_syncInterval *= 2;
+			if (_syncInterval > MAX_SYNC_INTERVAL)
+			{
+				_syncInterval = MAX_SYNC_INTERVAL;
+			}
+		}
+		else if (absOffset > 4 * GOOD_OFFSET_MS)
+		{
+			_syncInterval = MIN_SYNC_INTERVAL;
+		}
+	}
+
+	_synced = true;
+	_lastSyncMillis = responseMillis;
+	const int64_t offsetLimit = 0x7FFFFFFFL;
+	_lastSample.offsetMs = static_cast<int32_t>(constrain(offset, -offsetLimit, offsetLimit));
+	_lastSample.delayMs = delayMs;
+
+	return true;
+}
+
+void TimeModuleInternals::updateDrift(int32_t offsetMs, unsigned long elapsedMs)
+{
+	// Too short intervals only measure the network jitter
+	if (elapsedMs < MIN_SYNC_INTERVAL / 2) return;
+
+	// Offset left after the model already compensated the old drift -> residual drift, halve it to filter jitter
+	float residualPpm = (static_cast<float>(offsetMs) * 1e6f) / static_cast<float>(elapsedMs);
+	float driftPpm = constrain(_driftPpm + 0.5f * residualPpm, -MAX_DRIFT_PPM, MAX_DRIFT_PPM);
+
+	// getEpochMillis() reads it from other tasks, a float is four byte writes on the AVR
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_driftPpm = driftPpm;
+	}
+
+	// The EEPROM cells only last ~100 000 writes, store real changes only
+	if (fabs(_driftPpm - _storedDriftPpm) >= 1.0f)
+	{
+		saveDrift();
+	}
+}
+
+void TimeModuleInternals::loadDrift()
+{
+	DriftRecord record;
+	EEPROM.get(EEPROM_TIME_DRIFT_ADDR, record);
+
+	if (record.magic == DRIFT_MAGIC && !isnan(record.driftPpm) &&
+		record.driftPpm >= -MAX_DRIFT_PPM && record.driftPpm <= MAX_DRIFT_PPM)
+	{
+		_driftPpm = record.driftPpm;
+		_storedDriftPpm = record.driftPpm;
+	}
+}
+
+void TimeModuleInternals::saveDrift()
+{
+	DriftRecord record = { DRIFT_MAGIC, _driftPpm };
+	EEPROM.put(EEPROM_TIME_DRIFT_ADDR, record);
+	_storedDriftPpm = _driftPpm;
+}
+
+unsigned long TimeModuleInternals::getSyncInterval() const
+{
+	if (!_synced)
+	{
+		return MIN_SYNC_INTERVAL;
+	}
+	return _syncInterval;
+}
+
+SyncSample TimeModuleInternals::getLastSyncSample() const
+{
+	return _lastSample;
+}
+
+float TimeModuleInternals::getDriftPpm() const
+{
+	return _driftPpm;
+}
+
+void TimeModuleInternals::epochToDateTime(uint32_t epochSeconds, DateTimeStruct& dt)
+{
+	// Civil from days, see: https://howardhinnant.github.io/date_algorithms.html
+	uint32_t days = epochSeconds / 86400UL;
+	uint32_t secondsOfDay = epochSeconds % 86400UL;
+
+	dt.hour = secondsOfDay / 3600UL;
+	dt.minute = (secondsOfDay % 3600UL) / 60UL;
+	dt.second = secondsOfDay % 60UL;
+
+	uint32_t z = days + 719468UL;
+	uint32_t era = z / 146097UL;
+	uint32_t doe = z - era * 146097UL;
+	uint32_t yoe = (doe - doe / 1460UL + doe / 36524UL - doe / 146096UL) / 365UL;
+	uint32_t doy = doe - (365UL * yoe + yoe / 4UL - yoe / 100UL);
+	uint32_t mp = (5UL * doy + 2UL) / 153UL;
+
+	dt.day = doy - (153UL * mp + 2UL) / 5UL + 1UL;
+	dt.month = mp < 10UL ? mp + 3UL : mp - 9UL;
+	dt.year = yoe + era * 400UL + (dt.month <= 2 ? 1 : 0);
+}
+
+uint32_t TimeModuleInternals::dateTimeToEpoch(const DateTimeStruct& dt)
+{
+	// Days from civil, see: https://howardhinnant.github.io/date_algorithms.html
+	uint32_t y = static_cast<uint32_t>(dt.year) - (dt.month <= 2 ? 1 : 0);
+	uint32_t era = y / 400UL;
+	uint32_t yoe = y - era * 400UL;
+	uint32_t mp = dt.month > 2 ? dt.month - 3 : dt.month + 9;
+	uint32_t doy = (153UL * mp + 2UL) / 5UL + dt.day - 1;
+	uint32_t doe = yoe * 365UL + yoe / 4UL - yoe / 100UL + doy;
+	uint32_t days = era * 146097UL + doe - 719468UL;
+
+	return days * 86400UL + static_cast<uint32_t>(dt.hour) * 3600UL +
+		   static_cast<uint32_t>(dt.minute) * 60UL + static_cast<uint32_t>(dt.second);
+}
+
+bool TimeModuleInternals::parseJsonUint64(const String& json, const char* key, uint64_t& value)
+{
+	int idx = json.indexOf(key);
+	if (idx == -1) return false;
+
+	idx = json.indexOf(':', idx + strlen(key));
+	if (idx == -1) return false;
+	idx++;
+
+	while (idx < static_cast<int>(json.length()) && (json.charAt(idx) == ' ' || json.charAt(idx) == '"'))
+	{
+		idx++;
+	}
+
+	uint64_t result = 0;
+	int digits = 0;
+	while (idx < static_cast<int>(json.length()) && isdigit(json.charAt(idx)))
+	{
+		result = result * 10ULL + static_cast<uint64_t>(json.charAt(idx) - '0');
+		idx++;
+		digits++;
+	}
+
+	if (digits == 0) return false;
+
+	value = result;
+	return true;
+}
+
+bool TimeModuleInternals::parseHasTime(const String& timeString, DateTimeStruct& newDt)
 {
 	int startIdx = timeString.indexOf("\"time\": \"");
 	if (startIdx == -1) return false;
@@ -119,7 +490,6 @@ bool TimeModuleInternals::setTimeFromHas(const String& timeString)
         return false;
     }
 
-    DateTimeStruct newDt;
     newDt.year   = extTime.substring(0, 4).toInt();
     newDt.month  = extTime.substring(5, 7).toInt();
     newDt.day    = extTime.substring(8, 10).toInt();
@@ -134,6 +504,14 @@ bool TimeModuleInternals::setTimeFromHas(const String& timeString)
         return false;
     }
 
+    return true;
+}
+
+bool TimeModuleInternals::setTimeFromHas(const String& timeString)
+{
+    DateTimeStruct newDt;
+    if (!parseHasTime(timeString, newDt)) return false;
+
     setSystemTime(newDt);
     return true;
 }
@@ -143,4 +521,3 @@ TimeModuleInternals* TimeModuleInternals::getInstance()
 	static TimeModuleInternals instance;
 	return &instance;
 }
-
@@ -13,6 +13,8 @@
 
 #include <Arduino.h>
 
+#define EEPROM_TIME_DRIFT_ADDR 64 // Behind the last error slot of the ReportSystem
+
 /// @brief namespace for the timeModule \namespace timeModule
 namespace timeModule
 {
@@ -27,6 +29,13 @@ namespace timeModule
 		int second;
 	} DateTimeStruct;
 
+	/// @brief Struct to hold the result of one NTP-style exchange with the HAS \struct SyncSample
+	typedef struct SyncSample
+	{
+		int32_t offsetMs;	// HAS time minus local time at the moment of the exchange
+		uint32_t delayMs;	// Round-trip delay without the HAS processing time
+	} SyncSample;
+
 	/// @brief Class to handle Systemtime \class TimeModuleInternals
     class TimeModuleInternals
     {
@@ -58,6 +67,104 @@ namespace timeModule
 		 */
     	bool setTimeFromHas(const String& timeString);
 
+		/**
+		 * @brief Runs an NTP-style clock update from the HAS time response.
+		 * Small offsets are slewed, so the clock never jumps, large offsets step the clock.
+		 * The drift of millis() is learned and stored in the EEPROM.
+		 *
+		 * @param response -> The response of the HAS time endpoint.
+		 * @param requestMillis -> millis() when the request was sent (t1).
+		 * @param responseMillis -> millis() when the response arrived (t4).
+		 * @return true -> if the clock was synchronised
+		 * @return false -> if the response was invalid or the delay too high
+		 */
+    	bool syncWithHas(const String& response, unsigned long requestMillis, unsigned long responseMillis);
+
+		/**
+		 * @brief Get the interval after which the next sync with the HAS is due.
+		 * Grows while the learned drift keeps the clock within tolerance.
+		 *
+		 * @return unsigned long -> The sync interval in milliseconds.
+		 */
+    	unsigned long getSyncInterval() const;
+
+		/**
+		 * @brief Get the result of the last successful sync.
+		 *
+		 * @return SyncSample -> Offset and round-trip delay of the last sync.
+		 */
+    	SyncSample getLastSyncSample() const;
+
+		/**
+		 * @brief Get the learned drift of the millis() clock.
+		 *
+		 * @return float -> The drift in ppm, positive if millis() runs slow.
+		 */
+    	float getDriftPpm() const;
+
+		/**
+		 * @brief Get the current wall time, monotonic and drift compensated.
+		 *
+		 * @return uint64_t -> Milliseconds since 1970-01-01T00:00:00Z.
+		 */
+    	uint64_t getEpochMillis();
+
+		/**
+		 * @brief Get the monotonic microsecond counter, micros() extended over its 71 min wraparound.
+		 * Needs to be called at least once per wraparound, every running task does that.
+		 *
+		 * @return uint64_t -> Microseconds since boot.
+		 */
+    	static uint64_t getMonotonicMicros();
+
+		/**
+		 * @brief Maps a monotonic timestamp to the wall time.
+		 *
+		 * @param monotonicMicros -> A value of getMonotonicMicros().
+		 * @return uint64_t -> Milliseconds since 1970-01-01T00:00:00Z.
+		 */
+    	uint64_t monotonicToEpochMillis(uint64_t monotonicMicros);
+
+		/**
+		 * @brief Function to format the time with milliseconds to a string.
+		 *
+		 * @param epochMillis -> Milliseconds since 1970-01-01T00:00:00Z.
+		 * @return String -> The formatted time, e.g. 2025-01-01T12:00:00.123Z
+		 */
+    	static String formatTimeStringMs(uint64_t epochMillis);
+
+		/**
+		 * @brief Function to format an unsigned 64 bit value, the String class only handles 32 bit.
+		 *
+		 * @param value -> The value to format.
+		 * @return String -> The decimal representation.
+		 */
+    	static String uint64ToString(uint64_t value);
+
+		/**
+		 * @brief Function to parse an unsigned 64 bit decimal value, stops at the first non digit.
+		 *
+		 * @param text -> The text to parse.
+		 * @return uint64_t -> The value, 0 if the text does not start with a digit.
+		 */
+    	static uint64_t stringToUint64(const String& text);
+
+		/**
+		 * @brief Function to convert seconds since the epoch to a DateTimeStruct.
+		 *
+		 * @param epochSeconds -> Seconds since 1970-01-01T00:00:00Z.
+		 * @param dt -> The DateTimeStruct to fill.
+		 */
+    	static void epochToDateTime(uint32_t epochSeconds, DateTimeStruct& dt);
+
+		/**
+		 * @brief Function to convert a DateTimeStruct to seconds since the epoch.
+		 *
+		 * @param dt -> The DateTimeStruct to convert.
+		 * @return uint32_t -> Seconds since 1970-01-01T00:00:00Z.
+		 */
+    	static uint32_t dateTimeToEpoch(const DateTimeStruct& dt);
+
 		/**
 		 * @brief Set the System Time object of the system.
 		 *
@@ -87,7 +194,92 @@ namespace timeModule
 
     private:
     	DateTimeStruct dt;
-    	unsigned long startMillis = 0;
+
+    	// Clock model: wall = refEpochMs + elapsed * (1 + drift) + applied slew
+    	uint64_t _refEpochMs = 0;
+    	unsigned long _refMillis = 0;
+    	int32_t _slewMs = 0;
+    	uint64_t _lastEpochMs = 0;
+    	float _driftPpm = 0.0f;
+    	float _storedDriftPpm = 0.0f;
+    	bool _synced = false;
+
+    	unsigned long _lastSyncMillis = 0;
+    	unsigned long _syncInterval = MIN_SYNC_INTERVAL;
+    	SyncSample _lastSample = {0, 0};
+
+    	static const unsigned long MIN_SYNC_INTERVAL = 60000UL;	// 1 min
+    	static const unsigned long MAX_SYNC_INTERVAL = 1920000UL;	// 32 min
+    	static const int32_t STEP_THRESHOLD_MS = 1000;		// Step instead of slew above this offset
+    	static const int32_t GOOD_OFFSET_MS = 50;			// Interval may grow below this offset
+    	static const uint32_t MAX_DELAY_MS = 1500;			// Reject exchanges with a higher delay
+    	static const int32_t SLEW_RATE_PPM = 5000;			// 5 ms per second
+    	static const unsigned long REBASE_INTERVAL = 3600000UL;	// Keeps millis() deltas far from overflow
+    	static const int MAX_DRIFT_PPM = 1000;
+    	static const uint16_t DRIFT_MAGIC = 0xD21F;
+
+    	/**
+    	 * @brief Computes the wall time for a millis() value from the clock model.
+    	 *
+    	 * @param now -> millis() value to convert.
+    	 * @return uint64_t -> Milliseconds since the epoch.
+    	 */
+    	uint64_t modelEpochMillis(unsigned long now) const;
+
+    	/**
+    	 * @brief Computes how much of a pending slew is applied after some time.
+    	 *
+    	 * @param elapsedMs -> Time since the reference of the clock model.
+    	 * @param slewMs -> The pending slew.
+    	 * @return int32_t -> The applied part of the slew.
+    	 */
+    	static int32_t appliedSlew(unsigned long elapsedMs, int32_t slewMs);
+
+    	/**
+    	 * @brief Moves the reference of the clock model to now and adds an offset.
+    	 *
+    	 * @param now -> The new reference millis() value.
+    	 * @param offsetMs -> The offset measured against the model, replaces the slew still pending.
+    	 * @param step -> true to step the clock, false to slew.
+    	 */
+    	void rebase(unsigned long now, int64_t offsetMs, bool step);
+
+    	/**
+    	 * @brief Learns the drift from the offset seen after a sync interval.
+    	 *
+    	 * @param offsetMs -> The measured offset without the slew still pending.
+    	 * @param elapsedMs -> Time since the previous sync.
+    	 */
+    	void updateDrift(int32_t offsetMs, unsigned long elapsedMs);
+
+    	/**
+    	 * @brief Loads the stored drift from the EEPROM.
+    	 */
+    	void loadDrift();
+
+    	/**
+    	 * @brief Stores the learned drift in the EEPROM.
+    	 */
+    	void saveDrift();
+
+    	/**
+    	 * @brief Parses an unsigned 64 bit json number value.
+    	 *
+    	 * @param json -> The json string.
+    	 * @param key -> The quoted key to look for.
+    	 * @param value -> The parsed value.
+    	 * @return true -> if the key was found
+    	 */
+    	static bool parseJsonUint64(const String& json, const char* key, uint64_t& value);
+
+    	/**
+    	 * @brief Parses the "time" field of the HAS response.
+    	 *
+    	 * @param timeString -> The HAS response.
+    	 * @param newDt -> The parsed time.
+    	 * @return true -> if the time could be parsed
+    	 */
+    	static bool parseHasTime(const String& timeString, DateTimeStruct& newDt);
     };
 }
 
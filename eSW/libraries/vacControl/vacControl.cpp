@@ -1,8 +1,12 @@
+#define LOG_SOURCE LogSource::VACCONTROL
+
 #include <Wire.h>
 #include <SPI.h>
 #include <Arduino.h>
 #include <vacControl.h>
 #include <serialMenu.h>
+#include <timeModule.h>
+#include <adcEngine.h>
 
 using namespace vacControlModule;
 
@@ -89,20 +93,13 @@ PumpState VacControl::getPumpState()
 
 Pressure VacControl::measure()
 {
-	int manual = digitalRead(Main_Switch_MANUAL);
-	int remote = digitalRead(Main_Switch_REMOTE);
-
-	if(manual == LOW || remote == LOW)
-	{
-		meas.pressure = getExternPressure();  // Wert auslesen und speichern
-	}
-	return meas;
+	return _pressure.read();
 }
 
 Scenarios VacControl::getScenario()
 {
 	MainSwitchStates mode = getMainSwitchState();
-	int potValue = analogRead(targetPressure);
+	int potValue = sensorModule::AdcEngine::getInstance()->read(targetPressure);
 	int pumpSwitchState = digitalRead(Switch_Pump_ON);
 
 	if (mode == MainSwitchStates::Main_Switch_MANUAL)
@@ -138,35 +135,35 @@ int VacControl::getScenarioFromPotValue(int potValue)
     return -1;
 }
 
-float VacControl::getCurrentTargetPressure()
+MillibarPressure VacControl::getCurrentTargetPressure()
 {
 	if (digitalRead(Main_Switch_OFF) == LOW)
-		return 1000;
+		return MillibarPressure(1000);
 
 	if (digitalRead(Main_Switch_MANUAL) == LOW)
 	{
 		if (digitalRead(Switch_Pump_ON) == HIGH)
-			return 1000;
+			return MillibarPressure(1000);
 
-		int potValue = analogRead(targetPressure);
+		int potValue = sensorModule::AdcEngine::getInstance()->read(targetPressure);
 		switch (getScenarioFromPotValue(potValue))
 		{
-			case Scenarios::Scenario_1: return 0;
-			case Scenarios::Scenario_2: return TARGET_PRESSURE_1;
-			case Scenarios::Scenario_3: return TARGET_PRESSURE_2;
-			case Scenarios::Scenario_4: return TARGET_PRESSURE_3;
+			case Scenarios::Scenario_1: return MillibarPressure(0);
+			case Scenarios::Scenario_2: return MillibarPressure(TARGET_PRESSURE_1);
+			case Scenarios::Scenario_3: return MillibarPressure(TARGET_PRESSURE_2);
+			case Scenarios::Scenario_4: return MillibarPressure(TARGET_PRESSURE_3);
 		}
 	}
 	if (digitalRead(Main_Switch_REMOTE) == LOW)
-		return -1;
-	return -1;
+		return MillibarPressure(-1);
+	return MillibarPressure(-1);
 }
 
-void VacControl::setVacuumLed(float pressure, float targetPressure)
+void VacControl::setVacuumLed(MillibarPressure pressure, MillibarPressure targetPressure)
 {
-	float dynamicTolerance = targetPressure * 0.2f;
-	float lowerLimit = targetPressure - dynamicTolerance;
-	float upperLimit = targetPressure + dynamicTolerance;
+	MillibarPressure dynamicTolerance = targetPressure * 0.2f;
+	MillibarPressure lowerLimit = targetPressure - dynamicTolerance;
+	MillibarPressure upperLimit = targetPressure + dynamicTolerance;
 
     if (pressure >= lowerLimit && pressure <= upperLimit)
     {
@@ -208,13 +205,26 @@ void VacControl::run()
 			handleInvalidMode();
 			break;
 	}
+
+	VacStatus& status = _status.beginWrite();
+	status.mainSwitch = state;
+	status.pump = getPumpState();
+	status.scenario = currentScenario;
+	status.targetPressure = getCurrentTargetPressure().value();
+	status.timestampUs = timeModule::TimeModuleInternals::getMonotonicMicros();
+	_status.commit();
+}
+
+VacStatus VacControl::getStatus() const
+{
+	return _status.read();
 }
 
 void VacControl::handleOffMode()
 {
 	if (lastState != 0)
 	{
-		SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("System is OFF"));
+		LOG_TOKEN(INFO, VAC_SYSTEM_OFF);
 		lastState = 0;
 	}
 
@@ -229,19 +239,19 @@ void VacControl::handleManualMode()
 {
     if (lastState != 1)
     {
-        SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("System is ON - Manual Mode"));
+        LOG_TOKEN(INFO, VAC_MANUAL_MODE);
         lastState = 1;
     }
 
     int pumpOnState = digitalRead(Switch_Pump_ON);
-    int potValue = analogRead(targetPressure);
+    int potValue = sensorModule::AdcEngine::getInstance()->read(targetPressure);
     Pressure currentMeasurement = measure();
 
     if (pumpOnState == LOW)
     {
         if (lastPumpState != 1)
         {
-            SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("Pump ON."));
+            LOG_TOKEN(INFO, VAC_PUMP_ON);
             lastPumpState = 1;
 
             currentScenario = static_cast<int>(getScenario());
@@ -255,7 +265,7 @@ void VacControl::handleManualMode()
                 case static_cast<int>(Scenarios::Scenario_3):targetPressureValue = TARGET_PRESSURE_2;break;
                 case static_cast<int>(Scenarios::Scenario_4):targetPressureValue = TARGET_PRESSURE_3;break;
                 default:
-                    SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("Invalid Scenario."));
+                    LOG_TOKEN(ERROR, VAC_INVALID_SCENARIO);
                     setPump(false);
                     return;
             }
@@ -263,8 +273,8 @@ void VacControl::handleManualMode()
             setPump(true);
         }
 
-        float currentTargetPressure = getCurrentTargetPressure();
-        setVacuumLed(currentMeasurement.pressure, currentTargetPressure);
+        MillibarPressure currentTargetPressure = getCurrentTargetPressure();
+        setVacuumLed(MillibarPressure(currentMeasurement.pressure), currentTargetPressure);
     }
     else if (pumpOnState == HIGH && lastPumpState != 2)
     {
@@ -279,7 +289,7 @@ void VacControl::handleRemoteMode()
 {
 	if (lastState != 2)
 	{
-		SerialMenu::printToSerial(SerialMenu::OutputLevel::INFO, F("System is ON - Remote Mode"));
+		LOG_TOKEN(INFO, VAC_REMOTE_MODE);
 		lastState = 2;
 
 		setPump(false);
@@ -294,7 +304,7 @@ void VacControl::handleInvalidMode()
 {
 	if (lastState != 3)
 	{
-		SerialMenu::printToSerial(SerialMenu::OutputLevel::ERROR, F("VAC: Invalid Switch Position"));
+		LOG_TOKEN(ERROR, VAC_INVALID_SWITCH);
 		setPump(false);
 		lastState = 3;
 	}
@@ -337,10 +347,13 @@ void VacControl::setExternPressure(float pressure)
 {
 	if (pressure < 0)
 		return;
-	meas.pressure = pressure;
+	Pressure sample;
+	sample.pressure = pressure;
+	sample.timestampUs = timeModule::TimeModuleInternals::getMonotonicMicros();
+	_pressure.publish(sample);
 }
 
 float VacControl::getExternPressure()
 {
-	return meas.pressure;
+	return _pressure.read().pressure;
 }
@@ -12,6 +12,8 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <snapshot.h>
+#include <quantity.h>
 
 
 /// @brief Namespace for the VacControl module \namespace vacControlModule
@@ -46,12 +48,26 @@ namespace vacControlModule
 
 	/// @brief Structure to store the measured values of the system \struct Measurement
 	/// This structure holds the pressure values measured from the system.
+	/// timestampUs is the monotonic time the value arrived, see TimeModuleInternals::getMonotonicMicros().
 	typedef struct Pressure
 	{
 		float pressure;
-
+		uint64_t timestampUs;
 	} meas;
 
+	/// @brief Structure for the state of the vacuum control, published by run(). \struct VacStatus
+	struct VacStatus
+	{
+		MainSwitchStates mainSwitch;
+		PumpState pump;
+		int scenario;			// scenario of the running pump cycle, -1 if none
+		float targetPressure;	// mbar, -1 in remote mode
+		uint64_t timestampUs;	// time of the run() that published it
+	};
+
+	/// @brief Pressure in mbar, the unit of the VAT controller and the target pressures.
+	typedef calcModule::Pressure<calcModule::units::Millibar> MillibarPressure;
+
 	/// @brief VacControl class to manage the vacuum control system
 	/// This class provides methods for initializing the system, configuring the timer,
 	/// measuring parameters, and handling different system states such as ON, OFF, HAND, and REMOTE modes.
@@ -112,9 +128,9 @@ namespace vacControlModule
 
 		/**
 		 * @brief Returns the currently selected target pressure
-		 * @return float target pressure value
+		 * @return target pressure in mbar, 1000 mbar with the pump off, -1 in remote mode
 		 */
-		float getCurrentTargetPressure();
+		MillibarPressure getCurrentTargetPressure();
 
 		/**
 		 * @brief Controls the vacuum LED based on the current and target pressures
@@ -122,7 +138,7 @@ namespace vacControlModule
 		 * @param pressure The current pressure in the system
 		 * @param targetPressure The target pressure to reach
 		 */
-		void setVacuumLed(float pressure, float targetPressure);
+		void setVacuumLed(MillibarPressure pressure, MillibarPressure targetPressure);
 
 		 /**
 		  * @brief Determines the scenario based on the potentiometer value
@@ -147,6 +163,14 @@ namespace vacControlModule
 		 */
 		void run();
 
+		/**
+		 * @brief Returns the state the last run() of the control task published, without touching the pins
+		 * Lock free and never torn, see Snapshot.
+		 *
+		 * @return VacStatus -> The last published state, all zero before the first run()
+		 */
+		VacStatus getStatus() const;
+
 		/**
 		 * @brief Function to set an external scenario, typically from remote input
 		 *
@@ -197,7 +221,11 @@ namespace vacControlModule
 
 
 	private:
-		Pressure meas;
+		// published by setExternPressure() of the control task, read lock free by all others
+		Snapshot<Pressure> _pressure;
+
+		// published by run(), the control task is the only producer
+		Snapshot<VacStatus> _status;
 
 
 		//Define Pins --> Input
@@ -0,0 +1,161 @@
+#!/bin/bash
+
+# Builds the sketch with the default features, with each optional feature swapped in and with
+# every feature on its own, prints flash/RAM usage and fails if a set does not build (the
+# static_assert on FEATURE_RAM_BUDGET) or the globals of a build pass the limit.
+# The RAM of a feature is measured against the build without any feature: the globals from the
+# arduino-cli size report plus its singletons on the heap, whose size comes from the debug info
+# of the ELF. The free RAM at runtime is logged by setup().
+#
+# Usage:
+# ./check_ram_budget.sh [/path/to/FFRESW.ino] [limit in bytes]
+#
+# The limit defaults to 6144 bytes (75 % of the 8 KB), where arduino-cli warns about low memory.
+# Needs arduino-cli with arduino:avr installed and the libraries in ~/Arduino/libraries.
+# In GitHub Actions the tables also go to the job summary.
+
+SKETCH="${1:-$(dirname "$0")/../FFRESW/FFRESW/FFRESW.ino}"
+LIMIT="${2:-6144}"
+FQBN="arduino:avr:mega"
+BUILD_ROOT="${TMPDIR:-/tmp}/ffresw_ram_budget"
+SUMMARY="${GITHUB_STEP_SUMMARY:-/dev/null}"
+
+NONE="-DUSE_STATISTICS=0 -DUSE_HISTORY=0"
+
+# the sets the sketch documents, all must fit FEATURE_RAM_BUDGET without an override
+CONFIGS=(
+  ""
+  "-DUSE_HISTORY=0 -DUSE_TREND=1"
+  "-DUSE_HISTORY=0 -DUSE_SCOPE=1"
+  "-DUSE_HISTORY=0 -DUSE_EVENTS=1"
+  "-DUSE_STATISTICS=0 -DUSE_HISTORY=0 -DUSE_DATALOGGER=1"
+)
+
+# every feature on its own: flags and the classes the sketch creates on the heap for it
+FEATURES=(
+  "USE_STATISTICS|-DUSE_STATISTICS=1 -DUSE_HISTORY=0|SensorStatistics"
+  "USE_HISTORY|-DUSE_STATISTICS=0 -DUSE_HISTORY=1|SensorHistory"
+  "USE_TREND|$NONE -DUSE_TREND=1|SensorTrend"
+  "USE_SCOPE|$NONE -DUSE_SCOPE=1|ScopeCapture RippleAnalyzer"
+  "USE_EVENTS|$NONE -DUSE_EVENTS=1|EventRecorder"
+  "USE_DATALOGGER|$NONE -DUSE_DATALOGGER=1|DataLogger"
+)
+
+if ! command -v arduino-cli >/dev/null 2>&1; then
+  echo "[ERROR] arduino-cli not found"
+  exit 1
+fi
+
+if [ ! -f "$SKETCH" ]; then
+  echo "[ERROR] Sketch not found: $SKETCH"
+  exit 1
+fi
+
+OBJDUMP=$(find ~/.arduino15/packages/arduino/tools/avr-gcc -name avr-objdump -type f 2>/dev/null | head -n 1)
+if [ -z "$OBJDUMP" ]; then
+  echo "[ERROR] avr-objdump of the arduino:avr core not found"
+  exit 1
+fi
+
+index=0
+flash=""
+ram=""
+elf=""
+
+# builds one set, sets flash, ram and elf, returns 1 if the build failed
+build() {
+  local flags="$1"
+  local build_dir="$BUILD_ROOT/config_$index"
+  index=$((index + 1))
+  mkdir -p "$build_dir"
+
+  local output
+  output=$(arduino-cli compile \
+    --fqbn "$FQBN" \
+    --libraries ~/Arduino/libraries \
+    --build-path "$build_dir" \
+    --build-property "compiler.cpp.extra_flags=$flags" \
+    "$SKETCH" 2>&1)
+
+  if [ $? -ne 0 ]; then
+    echo "[ERROR] Build failed for features: ${flags:-default}"
+    echo "$output" | tail -n 20
+    return 1
+  fi
+
+  flash=$(echo "$output" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+  ram=$(echo "$output" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+  elf=$(find "$build_dir" -maxdepth 1 -name '*.elf' | head -n 1)
+  return 0
+}
+
+# sizeof of a class from the DWARF info of the ELF, 0 if it is not in the build
+class_size() {
+  "$OBJDUMP" --dwarf=info "$1" 2>/dev/null | awk -v cls="$2" '
+    /Abbrev Number/ { inType = ($0 ~ /DW_TAG_(class|structure)_type/); name = ""; next }
+    inType && /DW_AT_name/ { n = split($0, f, ": "); name = f[n]; gsub(/[ \t]+$/, "", name); next }
+    inType && /DW_AT_byte_size/ && name == cls { n = split($0, f, ": "); size = f[n] + 0; exit }
+    END { print size + 0 }'
+}
+
+rc=0
+
+printf "%-80s %8s %8s\n" "Features" "Flash" "RAM"
+{
+  echo "### RAM per feature set (limit $LIMIT B of globals)"
+  echo ""
+  echo "| Features | Flash | Globals |"
+  echo "|---|---:|---:|"
+} >> "$SUMMARY"
+
+for flags in "${CONFIGS[@]}"; do
+  if ! build "$flags"; then
+    rc=1
+    continue
+  fi
+
+  printf "%-80s %8s %8s\n" "${flags:-default}" "$flash" "$ram"
+  echo "| \`${flags:-default}\` | $flash | $ram |" >> "$SUMMARY"
+
+  if [ -z "$ram" ] || [ "$ram" -gt "$LIMIT" ]; then
+    echo "[ERROR] Globals of ${flags:-default} exceed the limit of $LIMIT bytes"
+    rc=1
+  fi
+done
+
+if ! build "$NONE"; then
+  exit 1
+fi
+base_flash=$flash
+base_ram=$ram
+
+echo ""
+echo "Against the build without features, flash $base_flash, globals $base_ram:"
+printf "%-16s %8s %8s %8s %8s\n" "Feature" "Flash" "Globals" "Heap" "RAM"
+{
+  echo ""
+  echo "### RAM of each feature (without features: flash $base_flash B, globals $base_ram B)"
+  echo ""
+  echo "| Feature | Flash | Globals | Heap | RAM |"
+  echo "|---|---:|---:|---:|---:|"
+} >> "$SUMMARY"
+
+for entry in "${FEATURES[@]}"; do
+  IFS='|' read -r name flags classes <<< "$entry"
+  if ! build "$flags"; then
+    rc=1
+    continue
+  fi
+
+  heap=0
+  for cls in $classes; do
+    heap=$((heap + $(class_size "$elf" "$cls")))
+  done
+
+  delta_flash=$((flash - base_flash))
+  delta_ram=$((ram - base_ram))
+  printf "%-16s %8s %8s %8s %8s\n" "$name" "$delta_flash" "$delta_ram" "$heap" "$((delta_ram + heap))"
+  echo "| $name | $delta_flash | $delta_ram | $heap | $((delta_ram + heap)) |" >> "$SUMMARY"
+done
+
+exit $rc
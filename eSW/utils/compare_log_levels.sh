@@ -0,0 +1,86 @@
+#!/bin/bash
+
+# Builds the sketch for the Mega once per LOG_MIN_LEVEL and prints flash/RAM usage side by side,
+# with what each level saves against the first one. Fails if a higher level needs more flash
+# or RAM than a lower one, the removed calls must not cost anything.
+#
+# Usage:
+# ./compare_log_levels.sh [/path/to/FFRESW.ino] [levels...]
+#
+# Levels in ascending order, default "0 1 2 5" (DEBUG, INFO, WARNING, NONE), see LOG_LEVEL_* in serialMenu.h.
+# Needs arduino-cli with arduino:avr installed and the libraries in ~/Arduino/libraries.
+# In GitHub Actions the table also goes to the job summary.
+
+SKETCH="${1:-$(dirname "$0")/../FFRESW/FFRESW/FFRESW.ino}"
+shift
+LEVELS="${*:-0 1 2 5}"
+FQBN="arduino:avr:mega"
+BUILD_ROOT="${TMPDIR:-/tmp}/ffresw_log_levels"
+SUMMARY="${GITHUB_STEP_SUMMARY:-/dev/null}"
+
+if ! command -v arduino-cli >/dev/null 2>&1; then
+  echo "[ERROR] arduino-cli not found"
+  exit 1
+fi
+
+if [ ! -f "$SKETCH" ]; then
+  echo "[ERROR] Sketch not found: $SKETCH"
+  exit 1
+fi
+
+printf "%-14s %12s %12s %12s %12s\n" "LOG_MIN_LEVEL" "Flash" "RAM" "Flash saved" "RAM saved"
+{
+  echo "### Build size per LOG_MIN_LEVEL ($FQBN)"
+  echo ""
+  echo "| LOG_MIN_LEVEL | Flash | RAM | Flash saved | RAM saved |"
+  echo "|---:|---:|---:|---:|---:|"
+} >> "$SUMMARY"
+
+rc=0
+first_flash=""
+first_ram=""
+last_flash=""
+last_ram=""
+
+for level in $LEVELS; do
+  build_dir="$BUILD_ROOT/level_$level"
+  mkdir -p "$build_dir"
+
+  output=$(arduino-cli compile \
+    --fqbn "$FQBN" \
+    --libraries ~/Arduino/libraries \
+    --build-path "$build_dir" \
+    --build-property "compiler.cpp.extra_flags=-DLOG_MIN_LEVEL=$level" \
+    "$SKETCH" 2>&1)
+
+  if [ $? -ne 0 ]; then
+    echo "[ERROR] Build failed for LOG_MIN_LEVEL=$level"
+    echo "$output" | tail -n 20
+    exit 1
+  fi
+
+  flash=$(echo "$output" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+  ram=$(echo "$output" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+
+  if [ -z "$flash" ] || [ -z "$ram" ]; then
+    echo "[ERROR] No size report for LOG_MIN_LEVEL=$level"
+    exit 1
+  fi
+
+  if [ -z "$first_flash" ]; then
+    first_flash=$flash
+    first_ram=$ram
+  fi
+
+  printf "%-14s %12s %12s %12s %12s\n" "$level" "$flash" "$ram" "$((first_flash - flash))" "$((first_ram - ram))"
+  echo "| $level | $flash | $ram | $((first_flash - flash)) | $((first_ram - ram)) |" >> "$SUMMARY"
+
+  if [ -n "$last_flash" ] && { [ "$flash" -gt "$last_flash" ] || [ "$ram" -gt "$last_ram" ]; }; then
+    echo "[ERROR] LOG_MIN_LEVEL=$level is larger than the level before it"
+    rc=1
+  fi
+  last_flash=$flash
+  last_ram=$ram
+done
+
+exit $rc
@@ -0,0 +1,954 @@
+/**
+ * @file logTool.cpp
+ * @author Adrian Goessl
+ * @brief Host tool to turn the binary logs of the FFRESW firmware back into readable text.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Build:
+ *   g++ -std=c++11 -O2 -o logTool logTool.cpp
+ *
+ * Usage:
+ *   logTool tokens <logTokens.h> [capture.bin]
+ *       Expands the token frames of a serial capture of a -DLOG_TOKENIZED build,
+ *       plain text in between is passed through. Reads stdin without a capture file.
+ *
+ *   logTool records <logTokens.h> <LOG00001.BIN> [--csv]
+ *       Decodes the binary SD records of a LOG_BINARY_RECORDS or LOG_TOKENIZED build as text lines or CSV.
+ *       Damaged bytes are skipped up to the next record or sync marker with a valid crc.
+ *       Use - as file to read stdin, e.g. the output of unpack.
+ *
+ *   logTool unpack <LOG00001.LZT> [out]
+ *       Unpacks the LZ frames of a LOG_COMPRESSED build, writes to stdout without an out file.
+ *       Prints frames, sizes and ratio, a damaged frame is skipped up to the next valid one.
+ *
+ *   logTool samples <DAT00001.BIN>
+ *       Writes the samples of a DataLogger recording as CSV, one column per channel of the
+ *       schema header. Prints rate, records and overruns, stops at the first missing block.
+ *
+ *   logTool scope <capture.bin> [--ripple N]
+ *       Writes a get_scope_data capture as CSV, time relative to the trigger sample and the
+ *       sample scaled back to 0..1023. Prints channel, rate and trigger time.
+ *       --ripple prints the get_ripple?n=N metrics of the capture instead, computed in double
+ *       precision with a plain DFT, the reference for the Q15 FFT of the firmware.
+ *
+ *   logTool events <EVT00001.BIN>
+ *       Writes an EventRecorder file as CSV, time relative to the trigger record, the channels
+ *       and the switch states. Prints the cause, the trigger time and the records before it.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// @brief Names of SerialMenu::OutputLevel, same order as the enum.
+static const char* const levelNames[] = { "DEBUG", "INFO", "WARNING", "ERROR", "CRITICAL", "STATUS", "PLAIN" };
+
+static const uint8_t TOKEN_SYNC = 0xA5;
+static const size_t TOKEN_HEADER_SIZE = 9;
+static const size_t TOKEN_MAX_PAYLOAD = 16;
+
+// see the record format in logManager.h
+static const uint8_t RECORD_MAGIC = 0xB1;
+static const size_t RECORD_HEADER_SIZE = 11;
+static const uint8_t RECORD_TEXT = 0;
+static const uint8_t RECORD_TOKEN = 1;
+static const uint8_t SYNC_MARKER[] = { 0xB5, 0x5B, 'S', 'Y' };
+static const size_t SYNC_SIZE = 11;
+
+// see the frame format in logManager.h
+static const size_t LZ_FRAME_SIZE = 512;
+static const size_t LZ_MIN_MATCH = 3;
+
+/// @brief One entry of the token database. \struct TokenEntry
+struct TokenEntry
+{
+    std::string name;
+    std::string format;
+};
+
+/**
+ * @brief Function to read a whole file or stdin.
+ *
+ * @param path -> The file to read, nullptr for stdin.
+ * @param data -> The bytes read.
+ * @return true -> if the file was read
+ * @return false -> if the file could not be opened
+ */
+static bool readAll(const char* path, std::vector<uint8_t>& data)
+{
+    if (path == nullptr)
+    {
+        std::istreambuf_iterator<char> begin(std::cin), end;
+        data.assign(begin, end);
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "[ERROR] Cannot open " << path << std::endl;
+        return false;
+    }
+    std::istreambuf_iterator<char> begin(file), end;
+    data.assign(begin, end);
+    return true;
+}
+
+/**
+ * @brief Function to remove C and C++ comments, so examples in comments are not taken as tokens.
+ *
+ * @param source -> The source text.
+ * @return std::string -> The source without comments.
+ */
+static std::string stripComments(const std::string& source)
+{
+    std::string result;
+    result.reserve(source.size());
+
+    for (size_t i = 0; i < source.size(); i++)
+    {
+        if (source[i] == '"')
+        {
+            size_t end = i + 1;
+            while (end < source.size() && source[end] != '"')
+            {
+                end += (source[end] == '\\') ? 2 : 1;
+            }
+            result.append(source, i, end - i + 1);
+            i = end;
+        }
+        else if (source.compare(i, 2, "//") == 0)
+        {
+            while (i < source.size() && source[i] != '\n') i++;
+            result += '\n';
+        }
+        else if (source.compare(i, 2, "/*") == 0)
+        {
+            size_t end = source.find("*/", i + 2);
+            i = (end == std::string::npos) ? source.size() : end + 1;
+        }
+        else
+        {
+            result += source[i];
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Function to load the token database from logTokens.h, the position of an entry is its ID.
+ *
+ * @param path -> The path of logTokens.h.
+ * @param tokens -> The tokens in ID order.
+ * @return true -> if at least one token was found
+ * @return false -> if the file could not be read or has no tokens
+ */
+static bool loadTokens(const char* path, std::vector<TokenEntry>& tokens, std::vector<std::string>* sources = nullptr)
+{
+    std::vector<uint8_t> raw;
+    if (!readAll(path, raw)) return false;
+
+    std::string source = stripComments(std::string(raw.begin(), raw.end()));
+    std::regex entry("LOG_TOKEN_ENTRY\\(\\s*(\\w+)\\s*,\\s*\"((?:[^\"\\\\]|\\\\.)*)\"\\s*\\)");
+
+    for (std::sregex_iterator it(source.begin(), source.end(), entry), end; it != end; ++it)
+    {
+        TokenEntry token;
+        token.name = (*it)[1].str();
+        token.format = (*it)[2].str();
+        tokens.push_back(token);
+    }
+
+    if (sources != nullptr)
+    {
+        std::regex sourceEntry("LOG_SOURCE_ENTRY\\(\\s*(\\w+)\\s*\\)");
+        for (std::sregex_iterator it(source.begin(), source.end(), sourceEntry), end; it != end; ++it)
+        {
+            sources->push_back((*it)[1].str());
+        }
+    }
+
+    if (tokens.empty())
+    {
+        std::cerr << "[ERROR] No LOG_TOKEN_ENTRY found in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static uint32_t readLe32(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0])
+         | (static_cast<uint32_t>(data[1]) << 8)
+         | (static_cast<uint32_t>(data[2]) << 16)
+         | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static const char* levelName(uint8_t level)
+{
+    return level < sizeof(levelNames) / sizeof(levelNames[0]) ? levelNames[level] : "UNKNOWN";
+}
+
+/**
+ * @brief Function to expand a token format with its packed arguments, same rules as expandToken() on the device.
+ *
+ * @param tokens -> The token database.
+ * @param id -> The token ID.
+ * @param args -> The packed arguments.
+ * @param length -> The length of the packed arguments.
+ * @return std::string -> The expanded message.
+ */
+static std::string expandToken(const std::vector<TokenEntry>& tokens, uint16_t id, const uint8_t* args, size_t length)
+{
+    if (id >= tokens.size())
+    {
+        return "Unknown log token " + std::to_string(id);
+    }
+
+    const std::string& format = tokens[id].format;
+    std::string text;
+    size_t offset = 0;
+
+    for (size_t i = 0; i < format.size(); i++)
+    {
+        if (format[i] != '%' || i + 1 >= format.size())
+        {
+            text += format[i];
+            continue;
+        }
+
+        char spec = format[++i];
+        if (offset + 4 > length)
+        {
+            text += '?';
+            continue;
+        }
+
+        uint32_t word = readLe32(&args[offset]);
+        offset += 4;
+
+        char buffer[32];
+        switch (spec)
+        {
+            case 'd': snprintf(buffer, sizeof(buffer), "%ld", static_cast<long>(static_cast<int32_t>(word))); break;
+            case 'u': snprintf(buffer, sizeof(buffer), "%lu", static_cast<unsigned long>(word)); break;
+            case 'f':
+            {
+                float value;
+                std::memcpy(&value, &word, sizeof(value));
+                snprintf(buffer, sizeof(buffer), "%.2f", value);
+                break;
+            }
+            default: snprintf(buffer, sizeof(buffer), "%%%c", spec); break;
+        }
+        text += buffer;
+    }
+    return text;
+}
+
+/**
+ * @brief Function to check for a valid token frame at the given position.
+ *
+ * @param data -> The capture.
+ * @param pos -> The position of the sync byte.
+ * @param frameSize -> The size of the frame including sync and checksum.
+ * @return true -> if a frame with valid length and checksum starts at pos
+ * @return false -> if the byte is plain text
+ */
+static bool isTokenFrame(const std::vector<uint8_t>& data, size_t pos, size_t& frameSize)
+{
+    if (data[pos] != TOKEN_SYNC || pos + TOKEN_HEADER_SIZE > data.size()) return false;
+
+    size_t length = data[pos + 8];
+    if (length > TOKEN_MAX_PAYLOAD || (length % 4) != 0) return false;
+
+    frameSize = TOKEN_HEADER_SIZE + length + 1;
+    if (pos + frameSize > data.size()) return false;
+
+    uint8_t checksum = 0;
+    for (size_t i = pos + 1; i < pos + frameSize - 1; i++)
+    {
+        checksum += data[i];
+    }
+    return checksum == data[pos + frameSize - 1];
+}
+
+static int decodeTokens(const char* tokenFile, const char* captureFile)
+{
+    std::vector<TokenEntry> tokens;
+    if (!loadTokens(tokenFile, tokens)) return 1;
+
+    std::vector<uint8_t> data;
+    if (!readAll(captureFile, data)) return 1;
+
+    size_t frames = 0;
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        size_t frameSize = 0;
+        if (!isTokenFrame(data, pos, frameSize))
+        {
+            std::cout << static_cast<char>(data[pos]);
+            pos++;
+            continue;
+        }
+
+        const uint8_t* frame = &data[pos];
+        uint16_t id = static_cast<uint16_t>(frame[2] | (frame[3] << 8));
+        std::cout << "[+" << readLe32(&frame[4]) << " ms] [" << levelName(frame[1]) << "] "
+                  << expandToken(tokens, id, &frame[TOKEN_HEADER_SIZE], frame[8]) << '\n';
+
+        frames++;
+        pos += frameSize;
+    }
+
+    std::cerr << "[INFO] " << frames << " token frames, " << data.size() << " bytes" << std::endl;
+    return 0;
+}
+
+static uint8_t crc8(uint8_t crc, const uint8_t* data, size_t length)
+{
+    while (length--)
+    {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint64_t readLe48(const uint8_t* data)
+{
+    uint64_t value = 0;
+    for (int i = 5; i >= 0; i--)
+    {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+/**
+ * @brief Function to format a wall time like the device, with milliseconds.
+ *
+ * @param epochMs -> Milliseconds since 1970-01-01T00:00:00Z.
+ * @return std::string -> e.g. 2026-10-19T12:00:00.123Z
+ */
+static std::string formatEpochMillis(uint64_t epochMs)
+{
+    std::time_t seconds = static_cast<std::time_t>(epochMs / 1000);
+    std::tm utc;
+    gmtime_r(&seconds, &utc);
+
+    char buffer[40];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(buffer + length, sizeof(buffer) - length, ".%03uZ", static_cast<unsigned>(epochMs % 1000));
+    return buffer;
+}
+
+/**
+ * @brief Function to quote a CSV field if needed.
+ *
+ * @param field -> The field.
+ * @return std::string -> The field, quoted with doubled quotes if it contains a comma, quote or line break.
+ */
+static std::string csvField(const std::string& field)
+{
+    if (field.find_first_of(",\"\r\n") == std::string::npos) return field;
+
+    std::string quoted = "\"";
+    for (char c : field)
+    {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+/**
+ * @brief Function to check for a valid record at the given position.
+ *
+ * @param data -> The log file.
+ * @param pos -> The position of the magic byte.
+ * @param recordSize -> The size of the record including magic and crc.
+ * @return true -> if a record with valid crc starts at pos
+ * @return false -> if there is no complete record at pos
+ */
+static bool isRecord(const std::vector<uint8_t>& data, size_t pos, size_t& recordSize)
+{
+    if (data[pos] != RECORD_MAGIC || pos + RECORD_HEADER_SIZE > data.size()) return false;
+
+    recordSize = RECORD_HEADER_SIZE + data[pos + 1] + 1;
+    if (pos + recordSize > data.size()) return false;
+
+    return crc8(0, &data[pos + 1], recordSize - 2) == data[pos + recordSize - 1];
+}
+
+static bool isSyncMarker(const std::vector<uint8_t>& data, size_t pos)
+{
+    if (pos + SYNC_SIZE > data.size() || std::memcmp(&data[pos], SYNC_MARKER, sizeof(SYNC_MARKER)) != 0) return false;
+    return crc8(0, &data[pos + 4], 6) == data[pos + 10];
+}
+
+static int decodeRecords(const char* tokenFile, const char* logFile, bool csv)
+{
+    std::vector<TokenEntry> tokens;
+    std::vector<std::string> sources;
+    if (!loadTokens(tokenFile, tokens, &sources)) return 1;
+
+    std::vector<uint8_t> data;
+    if (!readAll(std::string(logFile) == "-" ? nullptr : logFile, data)) return 1;
+
+    if (csv)
+    {
+        std::cout << "epoch_ms,time,level,source,message\n";
+    }
+
+    size_t records = 0;
+    size_t syncs = 0;
+    size_t skipped = 0;
+    size_t gaps = 0;
+    bool inGap = false;
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        size_t recordSize = 0;
+        if (isSyncMarker(data, pos))
+        {
+            syncs++;
+            inGap = false;
+            pos += SYNC_SIZE;
+            continue;
+        }
+        if (!isRecord(data, pos, recordSize))
+        {
+            // torn write or erased tail, skip up to the next valid record or sync marker
+            if (!inGap)
+            {
+                gaps++;
+                inGap = true;
+            }
+            skipped++;
+            pos++;
+            continue;
+        }
+        inGap = false;
+
+        const uint8_t* record = &data[pos];
+        uint64_t epochMs = readLe48(&record[2]);
+        uint8_t source = record[9];
+        uint8_t type = record[10];
+        const uint8_t* payload = &record[RECORD_HEADER_SIZE];
+        size_t length = record[1];
+
+        std::string message;
+        if (type == RECORD_TEXT)
+        {
+            message.assign(reinterpret_cast<const char*>(payload), length);
+        }
+        else if (type == RECORD_TOKEN && length >= 2)
+        {
+            message = expandToken(tokens, static_cast<uint16_t>(payload[0] | (payload[1] << 8)), &payload[2], length - 2);
+        }
+        else
+        {
+            message = "Unknown record type " + std::to_string(type);
+        }
+
+        std::string sourceName = source < sources.size() ? sources[source] : "SOURCE_" + std::to_string(source);
+        if (csv)
+        {
+            std::cout << epochMs << ',' << formatEpochMillis(epochMs) << ',' << levelName(record[8]) << ','
+                      << sourceName << ',' << csvField(message) << '\n';
+        }
+        else
+        {
+            std::cout << '[' << formatEpochMillis(epochMs) << "] [" << levelName(record[8]) << "] ["
+                      << sourceName << "] " << message << '\n';
+        }
+
+        records++;
+        pos += recordSize;
+    }
+
+    std::cerr << "[INFO] " << records << " records, " << syncs << " sync markers, "
+              << skipped << " bytes skipped in " << gaps << " gaps, " << data.size() << " bytes" << std::endl;
+    return 0;
+}
+
+/**
+ * @brief Function to unpack one LZ frame at the given position.
+ *
+ * @param data -> The log file.
+ * @param pos -> The position of the 'L' of the frame.
+ * @param raw -> The unpacked data is appended here.
+ * @param frameSize -> The packed size of the frame including header and crc.
+ * @return true -> if a complete frame with valid crc starts at pos
+ * @return false -> if there is no valid frame at pos, raw is unchanged
+ */
+static bool unpackFrame(const std::vector<uint8_t>& data, size_t pos, std::vector<uint8_t>& raw, size_t& frameSize)
+{
+    if (pos + 4 > data.size() || data[pos] != 'L' || data[pos + 1] != 'Z') return false;
+
+    size_t rawLength = data[pos + 2] | (data[pos + 3] << 8);
+    if (rawLength == 0 || rawLength > LZ_FRAME_SIZE) return false;
+
+    std::vector<uint8_t> out;
+    size_t in = pos + 4;
+    while (out.size() < rawLength)
+    {
+        if (in >= data.size()) return false;
+        uint8_t flags = data[in++];
+
+        for (int item = 0; item < 8 && out.size() < rawLength; item++)
+        {
+            if (flags & (1 << item))
+            {
+                if (in + 2 > data.size()) return false;
+                uint16_t match = static_cast<uint16_t>(data[in] | (data[in + 1] << 8));
+                size_t distance = (match & 0x1FF) + 1;
+                size_t length = (match >> 9) + LZ_MIN_MATCH;
+                in += 2;
+                if (distance > out.size() || out.size() + length > rawLength) return false;
+
+                // byte by byte, a match may overlap the data it produces
+                for (size_t i = 0; i < length; i++)
+                {
+                    out.push_back(out[out.size() - distance]);
+                }
+            }
+            else
+            {
+                if (in >= data.size()) return false;
+                out.push_back(data[in++]);
+            }
+        }
+    }
+
+    if (in >= data.size() || crc8(0, out.data(), out.size()) != data[in]) return false;
+
+    frameSize = in + 1 - pos;
+    raw.insert(raw.end(), out.begin(), out.end());
+    return true;
+}
+
+static int unpackFile(const char* packedFile, const char* outFile)
+{
+    std::vector<uint8_t> data;
+    if (!readAll(packedFile, data)) return 1;
+
+    std::vector<uint8_t> raw;
+    size_t frames = 0;
+    size_t skipped = 0;
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        size_t frameSize = 0;
+        if (!unpackFrame(data, pos, raw, frameSize))
+        {
+            skipped++;
+            pos++;
+            continue;
+        }
+        frames++;
+        pos += frameSize;
+    }
+
+    if (outFile != nullptr)
+    {
+        std::ofstream out(outFile, std::ios::binary);
+        if (!out)
+        {
+            std::cerr << "[ERROR] Cannot write " << outFile << std::endl;
+            return 1;
+        }
+        out.write(reinterpret_cast<const char*>(raw.data()), raw.size());
+    }
+    else
+    {
+        std::cout.write(reinterpret_cast<const char*>(raw.data()), raw.size());
+    }
+
+    char ratio[16];
+    snprintf(ratio, sizeof(ratio), "%.2f", data.empty() ? 0.0 : static_cast<double>(raw.size()) / data.size());
+    std::cerr << "[INFO] " << frames << " frames, " << data.size() << " bytes packed, " << raw.size()
+              << " bytes raw, ratio " << ratio << ":1, " << skipped << " bytes skipped" << std::endl;
+    return 0;
+}
+
+/// @brief Layout of the DataLogger files, see dataLogger.h.
+static const size_t DATALOG_BLOCK_SIZE = 512;
+static const size_t DATALOG_HEADER_SIZE = 32;
+static const size_t DATALOG_BLOCK_HEADER_SIZE = 8;
+static const size_t DATALOG_CHANNEL_SIZE = 24;
+
+static std::string fixedString(const uint8_t* data, size_t length)
+{
+    size_t end = 0;
+    while (end < length && data[end] != 0) end++;
+    return std::string(reinterpret_cast<const char*>(data), end);
+}
+
+static int decodeSamples(const char* dataFile)
+{
+    std::vector<uint8_t> data;
+    if (!readAll(dataFile, data)) return 1;
+
+    if (data.size() < DATALOG_BLOCK_SIZE || memcmp(data.data(), "FFDL", 4) != 0)
+    {
+        std::cerr << "[ERROR] " << dataFile << " is no DataLogger recording" << std::endl;
+        return 1;
+    }
+
+    const uint8_t* header = data.data();
+    uint8_t channels = header[5];
+    uint16_t recordSize = header[6] | (header[7] << 8);
+    uint16_t recordsPerBlock = header[8] | (header[9] << 8);
+    uint16_t sampleRate = header[10] | (header[11] << 8);
+    uint64_t startMs = readLe48(&header[12]);
+    uint32_t records = readLe32(&header[18]);
+    uint32_t overruns = readLe32(&header[22]);
+    uint32_t blocks = readLe32(&header[26]);
+
+    if (header[4] != 1 || recordSize != 4 + 4 * channels
+        || DATALOG_HEADER_SIZE + channels * DATALOG_CHANNEL_SIZE > DATALOG_BLOCK_SIZE
+        || recordsPerBlock * recordSize > DATALOG_BLOCK_SIZE - DATALOG_BLOCK_HEADER_SIZE)
+    {
+        std::cerr << "[ERROR] Unsupported schema header in " << dataFile << std::endl;
+        return 1;
+    }
+
+    std::cout << "time_s";
+    for (uint8_t i = 0; i < channels; i++)
+    {
+        const uint8_t* channel = &header[DATALOG_HEADER_SIZE + i * DATALOG_CHANNEL_SIZE];
+        std::cout << "," << csvField(fixedString(channel, 12) + " [" + fixedString(channel + 12, 8) + "]");
+    }
+    std::cout << "\n";
+
+    // a recording that was not stopped has zero counters, the sequence tells where it ends
+    uint32_t decoded = 0;
+    uint32_t sequence = 0;
+    for (size_t pos = DATALOG_BLOCK_SIZE; pos + DATALOG_BLOCK_SIZE <= data.size(); pos += DATALOG_BLOCK_SIZE)
+    {
+        const uint8_t* block = &data[pos];
+        uint16_t count = block[2] | (block[3] << 8);
+        if (block[0] != 'D' || block[1] != 'B' || readLe32(&block[4]) != sequence || count > recordsPerBlock)
+        {
+            break;
+        }
+        sequence++;
+
+        for (uint16_t r = 0; r < count; r++)
+        {
+            const uint8_t* record = &block[DATALOG_BLOCK_HEADER_SIZE + r * recordSize];
+            char field[32];
+            snprintf(field, sizeof(field), "%.6f", readLe32(record) / 1e6);
+            std::cout << field;
+            for (uint8_t i = 0; i < channels; i++)
+            {
+                uint32_t bits = readLe32(record + 4 + 4 * i);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                snprintf(field, sizeof(field), "%g", value);
+                std::cout << "," << field;
+            }
+            std::cout << "\n";
+            decoded++;
+        }
+    }
+
+    std::cerr << "[INFO] start " << formatEpochMillis(startMs) << ", " << sampleRate << " Hz, "
+              << static_cast<int>(channels) << " channels, " << sequence << " blocks, " << decoded << " samples" << std::endl;
+    std::cerr << "[INFO] header: " << records << " samples, " << overruns << " overruns, " << blocks << " blocks" << std::endl;
+    if (blocks != sequence || records != decoded)
+    {
+        std::cerr << "[WARNING] Header counters differ from the data, the recording was not stopped cleanly" << std::endl;
+    }
+    return 0;
+}
+
+/// @brief Layout of a scope capture, see scopeCapture.h.
+static const size_t SCOPE_HEADER_SIZE = 32;
+
+/// @brief Same method as RippleAnalyzer, see rippleAnalyzer.h, amplitudes in 10 bit ADC counts.
+static const int RIPPLE_MAX_HARMONIC = 5;
+static const int RIPPLE_LOBE_BINS = 2;
+
+static int printRipple(const uint8_t* samples, uint16_t count, uint8_t bits, uint32_t intervalNs, int points)
+{
+    if (points < 8 || points > 256 || (points & (points - 1)) != 0 || points > count)
+    {
+        std::cerr << "[ERROR] --ripple needs a power of two 8..256, at most " << count << std::endl;
+        return 1;
+    }
+
+    const double pi = 3.14159265358979323846;
+    const double countsPerSample = 1 << (10 - bits);
+    double mean = 0.0;
+    double low = 255.0;
+    double high = 0.0;
+    for (int i = 0; i < points; i++)
+    {
+        mean += samples[i];
+        low = std::min(low, static_cast<double>(samples[i]));
+        high = std::max(high, static_cast<double>(samples[i]));
+    }
+    mean /= points;
+    double variance = 0.0;
+    for (int i = 0; i < points; i++)
+    {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    }
+    variance /= points;
+
+    // one sided power of the Hann windowed samples, X[k] / n
+    std::vector<double> power(points / 2 + 1);
+    for (int k = 0; k <= points / 2; k++)
+    {
+        double re = 0.0;
+        double im = 0.0;
+        for (int i = 0; i < points; i++)
+        {
+            double value = (samples[i] - mean) * (0.5 - 0.5 * cos(2 * pi * i / points));
+            re += value * cos(2 * pi * k * i / points);
+            im -= value * sin(2 * pi * k * i / points);
+        }
+        power[k] = (re * re + im * im) / (static_cast<double>(points) * points);
+    }
+
+    auto lobe = [&](int center)
+    {
+        double sum = 0.0;
+        for (int bin = center - RIPPLE_LOBE_BINS; bin <= center + RIPPLE_LOBE_BINS; bin++)
+        {
+            if (bin >= 2 && bin < points / 2) sum += power[bin];
+        }
+        return sum;
+    };
+
+    int peak = 2;
+    for (int bin = 2; bin < points / 2; bin++)
+    {
+        if (power[bin] > power[peak]) peak = bin;
+    }
+    double below = sqrt(power[peak - 1]);
+    double center = sqrt(power[peak]);
+    double above = sqrt(power[peak + 1]);
+    double denominator = below + 2 * center + above;
+    double fundamentalBin = peak + ((denominator > 0) ? 2 * (above - below) / denominator : 0.0);
+
+    double harmonicPower = 0.0;
+    int harmonics = 0;
+    if (peak > 2 * RIPPLE_LOBE_BINS)
+    {
+        for (int harmonic = 2; harmonic <= RIPPLE_MAX_HARMONIC; harmonic++)
+        {
+            int bin = static_cast<int>(harmonic * fundamentalBin + 0.5);
+            if (bin + RIPPLE_LOBE_BINS >= points / 2) break;
+            harmonicPower += lobe(bin);
+            harmonics++;
+        }
+    }
+
+    double rateHz = 1e9 / intervalNs;
+    char line[256];
+    snprintf(line, sizeof(line), "points %d, rate %.1f Hz, bin %.2f Hz\nmean %.3f, rms %.3f, pp %.3f counts\n"
+             "dominant %.2f Hz, %.3f counts\nthd %.3f %% of %d harmonics\n",
+             points, rateHz, rateHz / points, mean * countsPerSample, sqrt(variance) * countsPerSample,
+             (high - low) * countsPerSample, fundamentalBin * rateHz / points,
+             sqrt(lobe(peak) * 32.0 / 3.0) * countsPerSample,
+             (harmonics > 0 && lobe(peak) > 0) ? 100.0 * sqrt(harmonicPower / lobe(peak)) : NAN, harmonics);
+    std::cout << line;
+    return 0;
+}
+
+static int decodeScope(const char* captureFile, int ripplePoints)
+{
+    std::vector<uint8_t> data;
+    if (!readAll(captureFile, data)) return 1;
+
+    if (data.size() < SCOPE_HEADER_SIZE || memcmp(data.data(), "SCP1", 4) != 0)
+    {
+        std::cerr << "[ERROR] " << captureFile << " is no scope capture" << std::endl;
+        return 1;
+    }
+
+    const uint8_t* header = data.data();
+    uint8_t channel = header[4];
+    uint8_t bits = header[5];
+    bool triggered = header[7] != 0;
+    uint16_t samples = header[8] | (header[9] << 8);
+    uint16_t preTrigger = header[10] | (header[11] << 8);
+    uint32_t intervalNs = readLe32(&header[12]);
+    uint64_t triggerMs = readLe48(&header[20]);
+
+    if (bits == 0 || bits > 10 || intervalNs == 0)
+    {
+        std::cerr << "[ERROR] Unsupported header in " << captureFile << std::endl;
+        return 1;
+    }
+    if (data.size() < SCOPE_HEADER_SIZE + samples)
+    {
+        std::cerr << "[WARNING] Capture truncated, " << (data.size() - SCOPE_HEADER_SIZE) << " of " << samples << " samples" << std::endl;
+        samples = static_cast<uint16_t>(data.size() - SCOPE_HEADER_SIZE);
+    }
+
+    if (ripplePoints > 0)
+    {
+        return printRipple(&data[SCOPE_HEADER_SIZE], samples, bits, intervalNs, ripplePoints);
+    }
+
+    std::cout << "time_us,adc\n";
+    for (uint16_t i = 0; i < samples; i++)
+    {
+        char field[32];
+        snprintf(field, sizeof(field), "%.3f,%u", (static_cast<int32_t>(i) - preTrigger) * (intervalNs / 1000.0),
+                 static_cast<unsigned>(data[SCOPE_HEADER_SIZE + i]) << (10 - bits));
+        std::cout << field << "\n";
+    }
+
+    std::cerr << "[INFO] channel A" << static_cast<int>(channel) << ", " << (1e9 / intervalNs) << " S/s, " << samples
+              << " samples, " << preTrigger << " before the trigger" << std::endl;
+    std::cerr << "[INFO] " << (triggered ? "trigger " : "frozen at the timeout ") << formatEpochMillis(triggerMs) << std::endl;
+    return 0;
+}
+
+/// @brief Layout of an event file, see eventRecorder.h.
+static const size_t EVENT_HEADER_SIZE = 32;
+static const char* const eventSourceNames[] = { "none", "hv", "switch", "threshold", "manual" };
+static const char* const eventChannelNames[] = { "hv_voltage", "hv_current", "pressure", "temp_in", "temp_out" };
+static const char* const mainSwitchNames[] = { "off", "manual", "remote", "invalid" };
+
+static int decodeEvents(const char* eventFile)
+{
+    std::vector<uint8_t> data;
+    if (!readAll(eventFile, data)) return 1;
+
+    if (data.size() < EVENT_HEADER_SIZE || memcmp(data.data(), "FFEV", 4) != 0)
+    {
+        std::cerr << "[ERROR] " << eventFile << " is no event file" << std::endl;
+        return 1;
+    }
+
+    const uint8_t* header = data.data();
+    uint8_t version = header[4];
+    uint8_t source = header[5];
+    uint8_t channels = header[6];
+    uint8_t recordSize = header[7];
+    uint16_t records = header[8] | (header[9] << 8);
+    uint16_t preRecords = header[10] | (header[11] << 8);
+    uint16_t periodMs = header[12] | (header[13] << 8);
+    uint64_t triggerEpochMs = readLe48(&header[20]);
+    uint32_t triggerMs = readLe32(&header[26]);
+
+    if (version != 1 || channels == 0 || recordSize != 5 + 4 * channels)
+    {
+        std::cerr << "[ERROR] Unsupported header in " << eventFile << std::endl;
+        return 1;
+    }
+    if (data.size() < EVENT_HEADER_SIZE + static_cast<size_t>(records) * recordSize)
+    {
+        std::cerr << "[WARNING] File truncated, " << (data.size() - EVENT_HEADER_SIZE) / recordSize << " of " << records << " records" << std::endl;
+        records = static_cast<uint16_t>((data.size() - EVENT_HEADER_SIZE) / recordSize);
+    }
+
+    std::cout << "time_ms";
+    for (uint8_t i = 0; i < channels; i++)
+    {
+        std::cout << "," << ((i < sizeof(eventChannelNames) / sizeof(eventChannelNames[0])) ? eventChannelNames[i] : "channel");
+    }
+    std::cout << ",main_switch,hv_switch,hv_output,pump\n";
+
+    for (uint16_t r = 0; r < records; r++)
+    {
+        const uint8_t* record = &data[EVENT_HEADER_SIZE + static_cast<size_t>(r) * recordSize];
+        uint8_t states = record[4];
+        std::cout << static_cast<int32_t>(readLe32(record) - triggerMs);
+        for (uint8_t i = 0; i < channels; i++)
+        {
+            uint32_t bits = readLe32(record + 5 + 4 * i);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            char field[32];
+            snprintf(field, sizeof(field), "%g", value);
+            std::cout << "," << field;
+        }
+        std::cout << "," << mainSwitchNames[(states >> 3) & 0x03] << "," << ((states >> 1) & 1) << ","
+                  << (states & 1) << "," << ((states >> 2) & 1) << "\n";
+    }
+
+    std::cerr << "[INFO] " << ((source < sizeof(eventSourceNames) / sizeof(eventSourceNames[0])) ? eventSourceNames[source] : "unknown")
+              << " event " << formatEpochMillis(triggerEpochMs) << ", " << records << " records every " << periodMs
+              << " ms, " << preRecords << " before the trigger" << std::endl;
+    return 0;
+}
+
+static void printUsage()
+{
+    std::cerr << "Usage:\n"
+              << "  logTool tokens <logTokens.h> [capture.bin]\n"
+              << "  logTool records <logTokens.h> <LOG00001.BIN> [--csv]\n"
+              << "  logTool unpack <LOG00001.LZT> [out]\n"
+              << "  logTool samples <DAT00001.BIN>\n"
+              << "  logTool scope <capture.bin> [--ripple N]\n"
+              << "  logTool events <EVT00001.BIN>\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::string command = argv[1];
+
+    if (command == "tokens" && argc >= 3)
+    {
+        return decodeTokens(argv[2], argc >= 4 ? argv[3] : nullptr);
+    }
+
+    if (command == "records" && argc >= 4)
+    {
+        return decodeRecords(argv[2], argv[3], argc >= 5 && std::string(argv[4]) == "--csv");
+    }
+
+    if (command == "unpack" && argc >= 3)
+    {
+        return unpackFile(argv[2], argc >= 4 ? argv[3] : nullptr);
+    }
+
+    if (command == "samples" && argc >= 3)
+    {
+        return decodeSamples(argv[2]);
+    }
+
+    if (command == "scope" && argc >= 3)
+    {
+        int ripplePoints = (argc >= 5 && std::string(argv[3]) == "--ripple") ? atoi(argv[4]) : 0;
+        return decodeScope(argv[2], ripplePoints);
+    }
+
+    if (command == "events" && argc >= 3)
+    {
+        return decodeEvents(argv[2]);
+    }
+
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file conversionBench.cpp
+ * @author Adrian Goessl
+ * @brief Cycle counts of the float conversions of the baseline against their fixed point replacements on the AVR.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Build for the Mega and run in simavr from the repository root:
+ *   avr-g++ -std=gnu++11 -Os -mmcu=atmega2560 -DF_CPU=16000000UL -Itesting/avr/stubs -IeSW/libraries/calcModule \
+ *       -o conversionBench.elf testing/avr/conversionBench.cpp
+ *   simavr -m atmega2560 -f 16000000 conversionBench.elf
+ *
+ * Runs without the Arduino core, the table goes to UART0 and the program ends with a sleep with
+ * interrupts off, which stops simavr. On a real Mega the table shows at 115200 baud.
+ *
+ * Timer5 runs at the CPU clock, every path is a noinline function that is called once per input
+ * between two reads of TCNT5, minus the cycles of an empty function. The inputs cover the ADC range,
+ * the table shows the mean and the maximum over them, a replacement with a higher mean is marked
+ * slower. The old paths are copied from the baseline, the new ones from Flyback::sample() and
+ * CalcModuleInternals, with the ADC count of the HV divider instead of the fixed test voltage of sample().
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <fixedPoint.h>
+#include <quantity.h>
+
+using namespace calcModule;
+
+// constants of the flyback
+static constexpr float R1 = 100000000;
+static constexpr float R2 = 10000;
+static constexpr float ADC_Max_Value = 1023.0;
+static constexpr float Vcc = 5.0;
+
+static const uint16_t inputs[] = { 0, 1, 100, 256, 511, 700, 1000, 1023 };
+static const uint8_t inputCount = sizeof(inputs) / sizeof(inputs[0]);
+
+volatile uint16_t adcValue;
+volatile float sinkVoltage;
+volatile float sinkCurrent;
+volatile float sinkPower;
+volatile float sinkValue;
+
+__attribute__((noinline)) static void emptyPath()
+{
+    sinkValue = 0;
+}
+
+// Flyback::measure() of the baseline, with the ADC line instead of the test voltage
+__attribute__((noinline)) static void hvFloat()
+{
+    float reducedVoltage = adcValue * (Vcc / ADC_Max_Value);
+    float current = (reducedVoltage / R2) * 1000000;
+    float voltage = (current / 1000000) * R1;
+    sinkCurrent = current;
+    sinkVoltage = voltage;
+    sinkPower = (voltage * current) / 1000000;
+}
+
+// Flyback::sample()
+__attribute__((noinline)) static void hvFixed()
+{
+    constexpr Q16_16 milliVoltsPerCount(Vcc * 1000.0 / ADC_Max_Value);
+    constexpr Q8_24 microAmpsPerMilliVolt(1000.0 / R2);
+    constexpr Fixed<12> voltsPerMicroAmp(R1 / 1000000.0);
+
+    Q16_16 reducedMilliVolts = Q16_16::scale(adcValue, milliVoltsPerCount);
+    Q16_16 current = reducedMilliVolts.multiply(microAmpsPerMilliVolt);
+    Fixed<12> voltage = current.multiply<12>(voltsPerMicroAmp);
+
+    sinkCurrent = current.toFloat();
+    sinkVoltage = voltage.toFloat();
+    sinkPower = sinkVoltage * (sinkCurrent * 0.000001f);
+}
+
+static float roundFloat(float value, int precision)
+{
+    float factor = pow(10, precision);
+    return round(value * factor) / factor;
+}
+
+static float roundTable(float value, int precision)
+{
+    static const float factors[] PROGMEM = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f, 1000000.0f };
+    float factor = (precision >= 0 && precision < 7) ? pgm_read_float(&factors[precision]) : pow(10, precision);
+    return round(value * factor) / factor;
+}
+
+// CalcModuleInternals::roundToPrecision(value, 5) of the baseline
+__attribute__((noinline)) static void roundPow()
+{
+    sinkValue = roundFloat(adcValue * 0.1234f, 5);
+}
+
+// CalcModuleInternals::roundToPrecision(value, 5)
+__attribute__((noinline)) static void roundPowTable()
+{
+    sinkValue = roundTable(adcValue * 0.1234f, 5);
+}
+
+// CalcModuleInternals::calculatePressureFromSensor(value, Psi) of the baseline
+__attribute__((noinline)) static void pressureFloat()
+{
+    float voltage = (adcValue * (5.0f / 1023.0f));
+    float pressurePascal = voltage * 10000.0f;
+    float result = roundFloat(pressurePascal * 0.000145038, 5);
+    sinkValue = roundFloat(result, 5);
+}
+
+// CalcModuleInternals::calculatePressureFromSensor(value, Psi)
+__attribute__((noinline)) static void pressureFolded()
+{
+    constexpr Pressure<units::Pascal> perCount(5.0f / 1023.0f * 10000.0f);
+    float factor = perCount.to<units::Psi>().value();
+    sinkValue = roundTable(adcValue * factor, 5);
+}
+
+/// @brief Structure for one path and its replacement. \struct BenchCase
+struct BenchCase
+{
+    const char* name;
+    void (*before)();
+    void (*after)();
+};
+
+static const BenchCase cases[] = {
+    { "flyback HV conversion", hvFloat, hvFixed },
+    { "roundToPrecision(x, 5)", roundPow, roundPowTable },
+    { "pressure from sensor (psi)", pressureFloat, pressureFolded }
+};
+
+static uint16_t measure(void (*path)())
+{
+    uint16_t start = TCNT5;
+    path();
+    uint16_t end = TCNT5;
+    return end - start;
+}
+
+/// @brief Structure for the cycles of one path over all inputs. \struct BenchResult
+struct BenchResult
+{
+    uint32_t mean;
+    uint16_t max;
+};
+
+static BenchResult run(void (*path)(), uint16_t overhead)
+{
+    BenchResult result = { 0, 0 };
+    for (uint8_t i = 0; i < inputCount; i++)
+    {
+        adcValue = inputs[i];
+        uint16_t cycles = measure(path) - overhead;
+        result.mean += cycles;
+        if (cycles > result.max) result.max = cycles;
+    }
+    result.mean = (result.mean + inputCount / 2) / inputCount;
+    return result;
+}
+
+static int uartPut(char c, FILE*)
+{
+    if (c == '\n') uartPut('\r', nullptr);
+    while (!(UCSR0A & (1 << UDRE0))) {}
+    UDR0 = c;
+    return 0;
+}
+
+static FILE uartOut;
+
+int main()
+{
+    UCSR0A = (1 << U2X0);
+    UBRR0 = 16;                         // 115200 baud at 16 MHz
+    UCSR0B = (1 << TXEN0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    fdev_setup_stream(&uartOut, uartPut, nullptr, _FDEV_SETUP_WRITE);
+    stdout = &uartOut;
+
+    cli();
+    TCCR5A = 0;
+    TCCR5B = (1 << CS50);               // CPU clock, 4 ms until the 16 bit counter wraps
+
+    adcValue = 0;
+    uint16_t overhead = measure(emptyPath);
+
+    printf("cycles at 16 MHz, mean / max over %u ADC counts, call overhead %u removed\n", inputCount, overhead);
+    printf("%-28s %14s %14s\n", "path", "before", "after");
+    for (uint8_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        BenchResult before = run(cases[i].before, overhead);
+        BenchResult after = run(cases[i].after, overhead);
+        printf("%-28s %7lu / %5u %7lu / %5u%s\n", cases[i].name, before.mean, before.max, after.mean, after.max,
+               (after.mean > before.mean) ? "  slower" : "");
+    }
+
+    // simavr stops on a sleep with interrupts off
+    while (!(UCSR0A & (1 << TXC0))) {}
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    sleep_cpu();
+    return 0;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file Arduino.h
+ * @author Adrian Goessl
+ * @brief Minimal Arduino API for the AVR benchmarks, avr-libc only, no Arduino core.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef AVR_BENCH_ARDUINO_H
+#define AVR_BENCH_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#endif // AVR_BENCH_ARDUINO_H
@@ -0,0 +1,58 @@
+import json
+import time
+import logging
+import argparse
+from datetime import datetime, timezone
+from http.server import BaseHTTPRequestHandler, HTTPServer
+
+logging.basicConfig(level=logging.DEBUG, format='%(asctime)s - %(levelname)s - %(message)s')
+
+# Local stand-in for the HAS time endpoint, answers GET /time/ like the HAS does
+# and adds the NTP-style receive/transmit timestamps used by the FFRESW time sync.
+class TimeHandler(BaseHTTPRequestHandler):
+    def do_GET(self):
+        receive_ms = int(time.time() * 1000)
+
+        if self.path.rstrip("/") != "/time":
+            self.send_response(404)
+            self.end_headers()
+            return
+
+        now = datetime.now(timezone.utc)
+        body = {
+            "time": now.strftime("%Y-%m-%dT%H:%M:%SZ"),
+            "receive_ms": receive_ms,
+        }
+        # transmit timestamp as late as possible, right before the body is sent
+        body["transmit_ms"] = int(time.time() * 1000)
+        payload = json.dumps(body, separators=(", ", ": ")).encode("utf-8")
+
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(payload)))
+        self.send_header("Connection", "close")
+        self.end_headers()
+        self.wfile.write(payload)
+
+        logging.info(f"{self.client_address[0]} -> {body}")
+
+    def log_message(self, format, *args):
+        pass
+
+def main():
+    parser = argparse.ArgumentParser(description="HAS time endpoint stand-in for the FFRESW time sync")
+    parser.add_argument("--host", default="0.0.0.0", help="Address to bind to (HAS is 192.168.1.1)")
+    parser.add_argument("--port", type=int, default=5000, help="Port to listen on")
+    args = parser.parse_args()
+
+    server = HTTPServer((args.host, args.port), TimeHandler)
+    logging.info(f"HAS time stand-in listening on {args.host}:{args.port}")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,413 @@
+/**
+ * @file fftTest.cpp
+ * @author Adrian Goessl
+ * @brief Host test of the Q15 FFT and the ripple analysis against double precision references.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Build and run from the repository root:
+ *   g++ -std=gnu++11 -O2 -Wall -Itesting/host/stubs -IeSW/libraries/calcModule -IeSW/libraries/sensorModule \
+ *       -o fftTest testing/host/fftTest.cpp eSW/libraries/calcModule/fixedFft.cpp \
+ *       eSW/libraries/sensorModule/rippleAnalyzer.cpp && ./fftTest
+ *
+ * Prints the error of every case next to its bound, the exit code is the number of failed cases.
+ * The signals come from a fixed seed, every run checks the same data.
+ *
+ * Bounds:
+ *   transformReal()  |X - X_ref| <= log2(n) + 1 LSB of Q15, one rounding per stage plus the split
+ *   transform()      |X - X_ref| <= log2(n) + 2 LSB, one rounding per stage plus the twiddle factors
+ *   applyHann()      |w x - w_ref x| <= 2 LSB, the rounded window times the rounded product
+ *   RippleAnalyzer   the same analysis in double on the same 8 bit samples:
+ *                    mean 0.01 %, rms 0.01 counts (float mean square minus the squared mean),
+ *                    dominant frequency 0.02 bin, amplitude 0.5 % + 0.05 counts,
+ *                    THD 0.002 absolute and the same number of harmonics
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <fixedFft.h>
+#include <scopeCapture.h>
+#include <rippleAnalyzer.h>
+
+using namespace calcModule;
+using namespace sensorModule;
+
+// The analyzer reads the frozen capture through ScopeCapture, the test provides the capture
+// instead of the ADC. Only the members the analyzer calls are defined.
+static uint8_t capture[512];
+static ScopeConfig captureConfig = {};
+
+ScopeCapture* ScopeCapture::_instance = nullptr;
+
+ScopeCapture::ScopeCapture()
+{
+
+}
+
+ScopeCapture* ScopeCapture::getInstance()
+{
+    if (_instance == nullptr)
+    {
+        _instance = new ScopeCapture();
+    }
+    return _instance;
+}
+
+uint16_t ScopeCapture::getSampleCount() const
+{
+    return sizeof(capture);
+}
+
+const ScopeConfig& ScopeCapture::getConfig() const
+{
+    return captureConfig;
+}
+
+uint32_t ScopeCapture::getSampleIntervalNs(uint8_t prescaler)
+{
+    if (prescaler != 32 && prescaler != 64 && prescaler != 128)
+    {
+        return 0;
+    }
+    return 13000UL * prescaler / (F_CPU / 1000000UL);
+}
+
+uint16_t ScopeCapture::readSamples(uint16_t offset, uint8_t* buffer, uint16_t length)
+{
+    if (offset >= sizeof(capture))
+    {
+        return 0;
+    }
+    uint16_t count = min(length, static_cast<uint16_t>(sizeof(capture) - offset));
+    memcpy(buffer, &capture[offset], count);
+    return count;
+}
+
+static int failures = 0;
+
+static void check(const char* name, double error, double bound)
+{
+    bool passed = error <= bound;
+    printf("%-48s %10.4g  bound %10.4g  %s\n", name, error, bound, passed ? "ok" : "FAILED");
+    if (!passed)
+    {
+        failures++;
+    }
+}
+
+static double random(double low, double high)
+{
+    return low + (high - low) * rand() / static_cast<double>(RAND_MAX);
+}
+
+static uint8_t log2Of(uint16_t n)
+{
+    uint8_t bits = 0;
+    while ((1U << bits) < n)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+/**
+ * @brief Function to get bin k of the DFT of complex data divided by n, like FixedFft.
+ *
+ * @param re -> The real parts.
+ * @param im -> The imaginary parts.
+ * @param k -> The bin.
+ * @param outRe -> The real part of the bin.
+ * @param outIm -> The imaginary part of the bin.
+ */
+static void dft(const std::vector<double>& re, const std::vector<double>& im, size_t k, double& outRe, double& outIm)
+{
+    size_t n = re.size();
+    outRe = 0.0;
+    outIm = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        double angle = -2.0 * M_PI * static_cast<double>((k * i) % n) / n;
+        outRe += re[i] * cos(angle) - im[i] * sin(angle);
+        outIm += re[i] * sin(angle) + im[i] * cos(angle);
+    }
+    outRe /= n;
+    outIm /= n;
+}
+
+static void testTransformReal()
+{
+    const char* signalNames[] = { "tone between bins", "three harmonics", "full scale noise" };
+    for (uint16_t n = FFT_MIN_POINTS; n <= FFT_MAX_POINTS; n <<= 1)
+    {
+        for (uint8_t signal = 0; signal < 3; signal++)
+        {
+            std::vector<int16_t> data(n);
+            std::vector<double> re(n);
+            std::vector<double> im(n, 0.0);
+            for (uint16_t i = 0; i < n; i++)
+            {
+                double t = static_cast<double>(i) / n;
+                double value;
+                switch (signal)
+                {
+                    case 0: value = 0.9 * sin(2.0 * M_PI * 2.3 * t); break;
+                    case 1: value = 0.5 * sin(2.0 * M_PI * 3.0 * t) + 0.2 * sin(2.0 * M_PI * 6.0 * t + 1.0) + 0.1 * cos(2.0 * M_PI * 9.0 * t); break;
+                    default: value = random(-0.95, 0.95); break;
+                }
+                data[i] = static_cast<int16_t>(lround(value * 32767.0));
+                re[i] = data[i] / 32768.0;
+            }
+
+            FixedFft::transformReal(data.data(), n);
+
+            // bins 0..n/2-1 interleaved, bin n/2 in the imaginary part of bin 0
+            double error = 0.0;
+            for (uint16_t k = 0; k <= n / 2; k++)
+            {
+                double refRe;
+                double refIm;
+                dft(re, im, k, refRe, refIm);
+                double gotRe = (k == n / 2) ? data[1] / 32768.0 : data[2 * k] / 32768.0;
+                double gotIm = (k == 0 || k == n / 2) ? 0.0 : data[2 * k + 1] / 32768.0;
+                error = fmax(error, hypot(gotRe - refRe, gotIm - refIm) * 32768.0);
+            }
+
+            char name[64];
+            snprintf(name, sizeof(name), "transformReal n=%u %s [LSB]", n, signalNames[signal]);
+            check(name, error, log2Of(n) + 1);
+        }
+    }
+}
+
+static void testTransform()
+{
+    for (uint16_t n = 4; n <= FFT_MAX_POINTS / 2; n <<= 1)
+    {
+        std::vector<int16_t> data(2 * n);
+        std::vector<double> re(n);
+        std::vector<double> im(n);
+        for (uint16_t i = 0; i < n; i++)
+        {
+            data[2 * i] = static_cast<int16_t>(lround(random(-0.95, 0.95) * 32767.0));
+            data[2 * i + 1] = static_cast<int16_t>(lround(random(-0.95, 0.95) * 32767.0));
+            re[i] = data[2 * i] / 32768.0;
+            im[i] = data[2 * i + 1] / 32768.0;
+        }
+
+        FixedFft::transform(data.data(), n);
+
+        double error = 0.0;
+        for (uint16_t k = 0; k < n; k++)
+        {
+            double refRe;
+            double refIm;
+            dft(re, im, k, refRe, refIm);
+            error = fmax(error, hypot(data[2 * k] / 32768.0 - refRe, data[2 * k + 1] / 32768.0 - refIm) * 32768.0);
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "transform n=%u complex noise [LSB]", n);
+        check(name, error, log2Of(n) + 2);
+    }
+}
+
+static void testHann()
+{
+    for (uint16_t n = FFT_MIN_POINTS; n <= FFT_MAX_POINTS; n <<= 1)
+    {
+        std::vector<int16_t> data(n);
+        std::vector<double> reference(n);
+        for (uint16_t i = 0; i < n; i++)
+        {
+            data[i] = (i & 1) ? 32767 : -32768;
+            reference[i] = data[i] * (0.5 - 0.5 * cos(2.0 * M_PI * i / n));
+        }
+
+        FixedFft::applyHann(data.data(), n);
+
+        double error = 0.0;
+        for (uint16_t i = 0; i < n; i++)
+        {
+            error = fmax(error, fabs(data[i] - reference[i]));
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "applyHann n=%u full scale [LSB]", n);
+        check(name, error, 2.0);
+    }
+}
+
+/// @brief Structure of a test signal of the ripple analysis, in 8 bit capture counts. \struct RippleCase
+struct RippleCase
+{
+    double offset;
+    double amplitude;
+    double frequencyHz;
+    double second;          // amplitude of the 2nd harmonic
+    double third;           // amplitude of the 3rd harmonic
+    double noise;           // peak of the uniform noise
+};
+
+/**
+ * @brief Function to run RippleAnalyzer::analyze() in double precision on the same samples.
+ *
+ * @param samples -> The capture, 8 bit.
+ * @param n -> The number of points.
+ * @param rateHz -> The sample rate.
+ * @param result -> Receives the reference, in 10 bit counts like the analyzer.
+ */
+static void analyzeReference(const uint8_t* samples, uint16_t n, double rateHz, RippleResult& result)
+{
+    const double countsPerSample = 1 << (10 - SCOPE_SAMPLE_BITS);
+    double mean = 0.0;
+    for (uint16_t i = 0; i < n; i++)
+    {
+        mean += samples[i];
+    }
+    mean /= n;
+
+    double variance = 0.0;
+    std::vector<double> re(n);
+    std::vector<double> im(n, 0.0);
+    for (uint16_t i = 0; i < n; i++)
+    {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+        re[i] = (samples[i] - mean) * (0.5 - 0.5 * cos(2.0 * M_PI * i / n));
+    }
+    variance /= n;
+
+    std::vector<double> power(n / 2 + 1);
+    for (uint16_t k = 0; k <= n / 2; k++)
+    {
+        double binRe;
+        double binIm;
+        dft(re, im, k, binRe, binIm);
+        power[k] = binRe * binRe + binIm * binIm;
+    }
+
+    uint16_t peak = 2;
+    for (uint16_t k = 2; k < n / 2; k++)
+    {
+        if (power[k] > power[peak])
+        {
+            peak = k;
+        }
+    }
+    double below = sqrt(power[peak - 1]);
+    double center = sqrt(power[peak]);
+    double above = sqrt(power[peak + 1]);
+    double fundamentalBin = peak + 2.0 * (above - below) / (below + 2.0 * center + above);
+
+    auto lobe = [&](uint16_t bin)
+    {
+        double sum = 0.0;
+        for (int b = bin - RIPPLE_LOBE_BINS; b <= bin + RIPPLE_LOBE_BINS; b++)
+        {
+            if (b >= 2 && b < n / 2)
+            {
+                sum += power[b];
+            }
+        }
+        return sum;
+    };
+
+    double harmonicPower = 0.0;
+    result.harmonics = 0;
+    if (peak > 2 * RIPPLE_LOBE_BINS)
+    {
+        for (uint8_t harmonic = 2; harmonic <= RIPPLE_MAX_HARMONIC; harmonic++)
+        {
+            uint16_t bin = static_cast<uint16_t>(harmonic * fundamentalBin + 0.5);
+            if (bin + RIPPLE_LOBE_BINS >= n / 2)
+            {
+                break;
+            }
+            harmonicPower += lobe(bin);
+            result.harmonics++;
+        }
+    }
+
+    result.points = n;
+    result.sampleRateHz = rateHz;
+    result.binHz = rateHz / n;
+    result.mean = mean * countsPerSample;
+    result.rms = sqrt(variance) * countsPerSample;
+    result.dominantHz = fundamentalBin * result.binHz;
+    result.dominantAmplitude = sqrt(lobe(peak) * 32.0 / 3.0) * countsPerSample;
+    result.thd = (result.harmonics > 0) ? sqrt(harmonicPower / lobe(peak)) : NAN;
+}
+
+static void testRipple()
+{
+    static int16_t work[FFT_MAX_POINTS];
+    RippleAnalyzer* analyzer = RippleAnalyzer::getInstance();
+    analyzer->begin(work, FFT_MAX_POINTS);
+    captureConfig.pin = A0;
+    captureConfig.prescaler = 32;
+    const double rateHz = 1.0e9 / ScopeCapture::getSampleIntervalNs(captureConfig.prescaler);
+
+    const RippleCase cases[] = {
+        { 128.0, 100.0, 1234.5, 0.0, 0.0, 0.0 },    // large tone between the bins
+        { 128.0, 100.0, 2000.0, 10.0, 5.0, 0.0 },   // 11 % THD
+        { 200.0, 3.0, 5100.0, 0.0, 0.0, 0.0 },      // ripple of a few counts, the shift scales it up
+        { 128.0, 60.0, 777.0, 6.0, 0.0, 1.0 },      // close to bin 2 with noise
+        { 100.0, 20.0, 3300.0, 4.0, 2.0, 0.5 }
+    };
+
+    for (const RippleCase& signal : cases)
+    {
+        for (uint16_t n = 64; n <= FFT_MAX_POINTS; n <<= 1)
+        {
+            for (uint16_t i = 0; i < sizeof(capture); i++)
+            {
+                double t = i / rateHz;
+                double value = signal.offset + signal.amplitude * sin(2.0 * M_PI * signal.frequencyHz * t)
+                    + signal.second * sin(2.0 * M_PI * 2.0 * signal.frequencyHz * t + 0.3)
+                    + signal.third * sin(2.0 * M_PI * 3.0 * signal.frequencyHz * t + 1.1)
+                    + random(-signal.noise, signal.noise);
+                capture[i] = static_cast<uint8_t>(fmin(255.0, fmax(0.0, round(value))));
+            }
+
+            RippleResult result;
+            RippleResult reference;
+            if (!analyzer->analyze(n, result))
+            {
+                check("RippleAnalyzer::analyze() returned false", 1.0, 0.0);
+                continue;
+            }
+            analyzeReference(capture, n, rateHz, reference);
+
+            char name[64];
+            snprintf(name, sizeof(name), "ripple %.0f Hz n=%u mean [rel]", signal.frequencyHz, n);
+            check(name, fabs(result.mean - reference.mean) / reference.mean, 1.0e-4);
+            snprintf(name, sizeof(name), "ripple %.0f Hz n=%u rms [counts]", signal.frequencyHz, n);
+            check(name, fabs(result.rms - reference.rms), 0.01);
+            snprintf(name, sizeof(name), "ripple %.0f Hz n=%u dominant [bins]", signal.frequencyHz, n);
+            check(name, fabs(result.dominantHz - reference.dominantHz) / reference.binHz, 0.02);
+            snprintf(name, sizeof(name), "ripple %.0f Hz n=%u amplitude [counts]", signal.frequencyHz, n);
+            check(name, fabs(result.dominantAmplitude - reference.dominantAmplitude), 0.005 * reference.dominantAmplitude + 0.05);
+            snprintf(name, sizeof(name), "ripple %.0f Hz n=%u harmonics [count]", signal.frequencyHz, n);
+            check(name, abs(result.harmonics - reference.harmonics), 0.0);
+            if (reference.harmonics > 0)
+            {
+                snprintf(name, sizeof(name), "ripple %.0f Hz n=%u thd [abs]", signal.frequencyHz, n);
+                check(name, fabs(result.thd - reference.thd), 0.002);
+            }
+        }
+    }
+}
+
+int main()
+{
+    srand(1);
+    testTransformReal();
+    testTransform();
+    testHann();
+    testRipple();
+
+    printf("%d failed\n", failures);
+    return failures;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file Arduino.h
+ * @author Adrian Goessl
+ * @brief Minimal Arduino API for the host tests of the hardware independent libraries.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define PROGMEM
+#define pgm_read_word(address) (*reinterpret_cast<const uint16_t*>(address))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+#define F_CPU 16000000UL
+#define A0 54
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,25 @@
+/**
+ * @file ptrUtils.h
+ * @author Adrian Goessl
+ * @brief The part of ptrUtils the host tests need, without the serial menu behind the real one.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#ifndef PTRUTILS_H
+#define PTRUTILS_H
+
+/// @brief Utility class for pointer operations. \class PtrUtils
+class PtrUtils
+{
+public:
+    template <typename T>
+    static inline bool IsNullPtr(T* ptr)
+    {
+        return ptr == nullptr;
+    }
+};
+
+#endif // PTRUTILS_H